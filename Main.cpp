@@ -3,9 +3,12 @@
 #include <exception> // for exception
 #include <iostream>  // for char_traits, basic_ostream
 #include <memory>    // for make_unique, unique_ptr
+#include <string_view>
 
 #include "01_InnerCore/VuLogger.h" // for LogLevel, Logger
+#include "13_Scenes/Scene_DrawBenchmark.h"
 #include "13_Scenes/Scene_GLTF_Load.h"
+#include "13_Scenes/Scene_LightBenchmark.h"
 #include "GetTimeSinceProcessStart.h"
 
 #if defined(__linux__)
@@ -17,10 +20,23 @@ main(int argc, char* argv[]) {
 
   std::cout << "App Start Time: " << GetTimeSinceProcessStart() * 1000 << " millisecond" << std::endl;
   Vu::Logger::SetLevel(Vu::LogLevel::Trace);
-  auto scene0 = std::make_unique<Vu::Scene_GLTF_Load>();
+  // --draw-benchmark logs gbuffer recording times at 10k and 50k draws instead of opening the gltf scene
+  const bool drawBenchmark = argc > 1 && std::string_view {argv[1]} == "--draw-benchmark";
+  // --light-benchmark logs lighting frame times at 1k and 10k point lights, clustered and unclustered
+  const bool lightBenchmark = argc > 1 && std::string_view {argv[1]} == "--light-benchmark";
+  // --single-pass-deferred opens the gltf scene with gbuffer and lighting as subpasses of one render pass
+  const bool singlePassDeferred = argc > 1 && std::string_view {argv[1]} == "--single-pass-deferred";
 
   try {
-    scene0->run();
+    if (drawBenchmark) {
+      std::make_unique<Vu::Scene_DrawBenchmark>()->run();
+    } else if (lightBenchmark) {
+      std::make_unique<Vu::Scene_LightBenchmark>()->run();
+    } else {
+      auto scene0                = std::make_unique<Vu::Scene_GLTF_Load>();
+      scene0->singlePassDeferred = singlePassDeferred;
+      scene0->run();
+    }
   } catch (const std::exception& e) { std::puts(e.what()); }
 
 #if defined(__linux__)
@@ -15,6 +15,13 @@ enum ShaderDebugMode {
   Depth,
 };
 
+enum GBufferLayout {
+  // RGBA32F normal, arm and world position targets
+  GBufferFull,
+  // octahedral RG16 normal, RGBA8 arm, world position reconstructed from depth
+  GBufferCompact,
+};
+
 // Point Light Structure
 struct PointLight {
   float3 color     = {1, 1, 1}; // RGB intensity (linear space)
@@ -40,6 +47,9 @@ struct Camera {
   float4   position;
   float4   direction;
   float    exposureScale = 1;
+  // distances of the clip planes, the light clusters slice the depth between them
+  float nearPlane = 0.01f;
+  float farPlane  = 100.0f;
 };
 
 struct Mesh {
@@ -80,17 +90,116 @@ struct VuMaterialDataHandle {
   uint32_t index;
 };
 
+// froxel grid of the clustered lighting, x/y split the screen in tiles and z slices the view depth exponentially
+struct LightClusterInfo {
+  // bindless index of the current frame's PointLight array
+  uint32_t lightBufferHandle;
+  uint32_t lightCount;
+  // bindless index of the cluster lists, each one is a light count followed by maxLightsPerCluster light indices
+  uint32_t clusterBufferHandle;
+  uint32_t countX;
+  uint32_t countY;
+  uint32_t countZ;
+  uint32_t maxLightsPerCluster;
+  // zero makes every pixel loop over all lights, kept for comparisons
+  uint32_t enabled;
+};
+
 struct FrameConstant {
-  Camera          camera;
-  float           time;
-  ShaderDebugMode debugIndex;
-  PointLight      pointLights[2];
+  Camera           camera;
+  float            time;
+  ShaderDebugMode  debugIndex;
+  GBufferLayout    gBufferLayout;
+  LightClusterInfo lightClusters;
+};
+
+// per object data of the gbuffer pass, one entry per instance of an instanced draw
+struct InstanceData {
+  float4x4             model;
+  VuMaterialDataHandle materialDataHandle;
+  uint32_t             padding[3];
+};
+
+// culling input of one object of the gpu driven path, its model matrix is the InstanceData at the same index
+struct GpuObject {
+  // mesh space center in xyz, radius in w
+  float4   boundingSphere;
+  // zero marks a free slot
+  uint32_t indexCount;
+  // first command of the draw group, the group draw count is drawCounts[groupIndex]
+  uint32_t commandOffset;
+  uint32_t groupIndex;
+  uint32_t padding;
+};
+
+// same layout as VkDrawIndexedIndirectCommand
+struct DrawIndexedIndirectCommand {
+  uint32_t indexCount;
+  uint32_t instanceCount;
+  uint32_t firstIndex;
+  int32_t  vertexOffset;
+  uint32_t firstInstance;
+};
+
+// two phase occlusion culling: early draws what was visible last frame, late tests the rest against the depth pyramid
+enum GpuCullPhase {
+  // frustum culling only, used when depth is not kept after the gbuffer pass
+  CullFrustumOnly,
+  CullEarly,
+  CullLate,
+};
+
+// counters of one frame, read back on the cpu
+struct GpuCullStats {
+  uint32_t earlyDrawn;
+  uint32_t lateDrawn;
+  uint32_t frustumCulled;
+  uint32_t occlusionCulled;
+};
+
+// device addresses of the gpu scene buffers of the current frame
+struct GpuCullPushConstant {
+  uint64_t instances;
+  uint64_t objects;
+  uint64_t commands;
+  uint64_t drawCounts;
+  // one uint per object, non zero when it passed the last occlusion test
+  uint64_t visibility;
+  uint64_t stats;
+  // max depth pyramid, level 0 is half the depth resolution, levels are packed one after another
+  uint64_t     hzb;
+  uint32_t     objectCount;
+  GpuCullPhase phase;
+  uint32_t     depthWidth;
+  uint32_t     depthHeight;
+  uint32_t     hzbLevelCount;
+};
+
+struct HzbBuildPushConstant {
+  uint64_t dst;
+  // previous level, unused when reading the depth texture
+  uint64_t src;
+  uint32_t srcWidth;
+  uint32_t srcHeight;
+  uint32_t dstWidth;
+  uint32_t dstHeight;
+  uint32_t depthTexture;
+  uint32_t fromDepth;
+};
+
+// device addresses of the light clustering buffers of the current frame, the grid comes from the frame constant
+struct LightAssignPushConstant {
+  uint64_t lights;
+  uint64_t clusters;
 };
 
 struct PushConstant {
+  // only read by the forward shaders, deferred ones take it from InstanceData
   float4x4             model;
   VuMaterialDataHandle materialDataHandle;
   Mesh                 mesh;
+  // bindless index of the InstanceData buffer of the current frame
+  uint32_t instanceBufferHandle;
 };
 
 struct MatData_Raw {
@@ -20,7 +20,7 @@ for file in slang_files:
     print(f"Compiling: {file} → {out_file}")
 
     result = subprocess.run(
-        [compiler, str(file),"-target", "spirv", "-fvk-use-scalar-layout","-g", "-o", out_file],
+        [compiler, str(file),"-target", "spirv", "-fvk-use-scalar-layout", "-I", "common","-g", "-o", out_file],
         stdout=subprocess.PIPE,
         stderr=subprocess.PIPE,
         text=True
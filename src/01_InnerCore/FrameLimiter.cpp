@@ -0,0 +1,42 @@
+#include "FrameLimiter.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+// sleep granularity is a millisecond or worse on most systems, the rest of the wait spins
+constexpr std::chrono::microseconds SPIN_THRESHOLD {1500};
+} // namespace
+
+void
+FrameLimiter::setTargetFps(const float fps) {
+  m_targetFps    = std::max(fps, 0.0f);
+  m_interval     = {};
+  m_nextDeadline = {};
+  if (m_targetFps > 0.0f) {
+    m_interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetFps));
+  }
+}
+
+float
+FrameLimiter::getTargetFps() const {
+  return m_targetFps;
+}
+
+float
+FrameLimiter::wait() {
+  if (m_interval == Clock::duration {}) { return 0.0f; }
+
+  const Clock::time_point start = Clock::now();
+  if (m_nextDeadline == Clock::time_point {} || m_nextDeadline + m_interval < start) {
+    m_nextDeadline = start + m_interval;
+    return 0.0f;
+  }
+
+  if (m_nextDeadline - start > SPIN_THRESHOLD) { std::this_thread::sleep_until(m_nextDeadline - SPIN_THRESHOLD); }
+  while (Clock::now() < m_nextDeadline) {
+    std::this_thread::yield();
+  }
+  m_nextDeadline += m_interval;
+  return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <chrono>
+
+// Paces a loop to a target rate on the cpu. Deadlines advance by a fixed interval so the average rate is exact, a loop
+// that falls behind starts over from now instead of running several frames back to back to catch up.
+struct FrameLimiter {
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::duration   m_interval {};
+  Clock::time_point m_nextDeadline {};
+  float             m_targetFps {};
+
+public:
+  // 0 or less disables the limiter
+  void
+  setTargetFps(float fps);
+
+  [[nodiscard]] float
+  getTargetFps() const;
+
+  // blocks until the next deadline, returns the time spent waiting in milliseconds
+  float
+  wait();
+};
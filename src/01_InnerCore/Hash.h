@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+constexpr uint64_t FNV1A_64_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV1A_64_PRIME        = 1099511628211ull;
+
+// 64 bit FNV-1a, pass the previous result as seed to hash several pieces as one stream
+constexpr uint64_t
+fnv1a64(std::span<const std::byte> data, uint64_t seed = FNV1A_64_OFFSET_BASIS) {
+  uint64_t hash = seed;
+  for (std::byte b : data) {
+    hash ^= static_cast<uint64_t>(b);
+    hash *= FNV1A_64_PRIME;
+  }
+  return hash;
+}
+
+constexpr uint64_t
+fnv1a64(std::string_view str, uint64_t seed = FNV1A_64_OFFSET_BASIS) {
+  uint64_t hash = seed;
+  for (char c : str) {
+    hash ^= static_cast<uint64_t>(static_cast<unsigned char>(c));
+    hash *= FNV1A_64_PRIME;
+  }
+  return hash;
+}
@@ -45,4 +45,25 @@ IndexAllocator::deallocate(uint32_t idx) {
   } else {
     m_freeIndices.push_back(idx);
   }
+}
+
+uint32_t
+IndexAllocator::capacity() {
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_capacity;
+}
+
+bool
+IndexAllocator::isFull() {
+  std::lock_guard<std::mutex> lock(m_mtx);
+  return m_freeIndices.empty() && m_nextIndex >= m_capacity;
+}
+
+void
+IndexAllocator::grow(uint32_t newCapacity) {
+  std::lock_guard<std::mutex> lock(m_mtx);
+
+  if (newCapacity < m_capacity) { throw std::runtime_error("IndexAllocator: Trying to shrink capacity!"); }
+  m_capacity = newCapacity;
+  m_freeIndices.reserve(m_capacity);
 }
\ No newline at end of file
@@ -24,4 +24,15 @@ public:
 
   void
   deallocate(uint32_t idx);
+
+  uint32_t
+  capacity();
+
+  // true when the next allocate would throw
+  bool
+  isFull();
+
+  // raises the capacity, handed out indices stay valid
+  void
+  grow(uint32_t newCapacity);
 };
@@ -0,0 +1,47 @@
+#include "MemoryAliasPlanner.h"
+
+#include <algorithm>
+#include <numeric>
+
+static bool
+isOverlapping(const AliasResource& a, const AliasResource& b) {
+  return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+}
+
+AliasPlan
+planMemoryAliasing(const std::span<const AliasResource> resources) {
+  AliasPlan plan {};
+  plan.blockOfResource.resize(resources.size());
+
+  std::vector<uint32_t> order(resources.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::ranges::stable_sort(order, [&](uint32_t a, uint32_t b) { return resources[a].size > resources[b].size; });
+
+  for (const uint32_t resourceIndex : order) {
+    const AliasResource& resource = resources[resourceIndex];
+    plan.unaliasedBytes += resource.size;
+
+    uint32_t blockIndex = 0;
+    for (; blockIndex < plan.blocks.size(); ++blockIndex) {
+      const AliasBlock& block = plan.blocks[blockIndex];
+      if ((block.memoryTypeBits & resource.memoryTypeBits) == 0) { continue; }
+
+      const bool collides = std::ranges::any_of(
+          block.resources, [&](uint32_t other) { return isOverlapping(resources[other], resource); });
+      if (!collides) { break; }
+    }
+    if (blockIndex == plan.blocks.size()) { plan.blocks.emplace_back(); }
+
+    AliasBlock& block = plan.blocks[blockIndex];
+    block.size        = std::max(block.size, resource.size);
+    block.alignment   = std::max(block.alignment, resource.alignment);
+    block.memoryTypeBits &= resource.memoryTypeBits;
+    block.resources.push_back(resourceIndex);
+    plan.blockOfResource[resourceIndex] = blockIndex;
+  }
+
+  for (const AliasBlock& block : plan.blocks) {
+    plan.aliasedBytes += block.size;
+  }
+  return plan;
+}
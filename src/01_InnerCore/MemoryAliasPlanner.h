@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A resource that needs memory from pass 'firstPass' to pass 'lastPass', both inclusive
+struct AliasResource {
+  uint64_t size {};
+  uint64_t alignment {1};
+  // bit i set when memory type i can back the resource
+  uint32_t memoryTypeBits {~0u};
+  uint32_t firstPass {};
+  uint32_t lastPass {};
+};
+
+// One allocation shared by resources whose pass ranges never overlap, every resource is placed at offset 0
+struct AliasBlock {
+  uint64_t              size {};
+  uint64_t              alignment {1};
+  uint32_t              memoryTypeBits {~0u};
+  std::vector<uint32_t> resources {};
+};
+
+struct AliasPlan {
+  std::vector<AliasBlock> blocks {};
+  // index into blocks for each input resource
+  std::vector<uint32_t> blockOfResource {};
+  // sum of resource sizes, what separate allocations would take
+  uint64_t unaliasedBytes {};
+  // sum of block sizes
+  uint64_t aliasedBytes {};
+};
+
+// Greedy placement, largest resources first, each one goes to the first block it does not collide with.
+AliasPlan
+planMemoryAliasing(std::span<const AliasResource> resources);
@@ -0,0 +1,76 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace {
+constexpr uint32_t RADIX_BUCKET_COUNT = 256;
+// below this a single thread is faster than handing chunks to the pool
+constexpr size_t PARALLEL_MIN_ITEM_COUNT = 1u << 14;
+
+using Histogram = std::array<size_t, RADIX_BUCKET_COUNT>;
+
+uint32_t
+digitOf(uint64_t key, uint32_t pass) {
+  return static_cast<uint32_t>(key >> (pass * 8)) & 0xFF;
+}
+} // namespace
+
+void
+radixSort(std::span<RadixSortItem> items, std::span<RadixSortItem> scratch, ThreadPool* pool) {
+  assert(scratch.size() >= items.size());
+  const size_t count = items.size();
+  if (count < 2) { return; }
+
+  const size_t chunkCount =
+      (pool != nullptr && count >= PARALLEL_MIN_ITEM_COUNT) ? std::max<size_t>(pool->getThreadCount(), 1) + 1 : 1;
+  const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+  std::vector<Histogram> histograms(chunkCount);
+  RadixSortItem*         src = items.data();
+  RadixSortItem*         dst = scratch.data();
+
+  for (uint32_t pass = 0; pass < 8; ++pass) {
+    forEachChunk(pool, chunkCount, [&](size_t chunk) {
+      Histogram& histogram = histograms[chunk];
+      histogram.fill(0);
+      const size_t end = std::min(count, (chunk + 1) * chunkSize);
+      for (size_t i = chunk * chunkSize; i < end; ++i) {
+        histogram[digitOf(src[i].key, pass)]++;
+      }
+    });
+
+    // every key shares this byte, order would not change
+    const uint32_t firstDigit = digitOf(src[0].key, pass);
+    size_t         firstDigitCount {};
+    for (const Histogram& histogram : histograms) {
+      firstDigitCount += histogram[firstDigit];
+    }
+    if (firstDigitCount == count) { continue; }
+
+    // turn counts into write offsets, bucket major then chunk order keeps the sort stable
+    size_t offset = 0;
+    for (uint32_t bucket = 0; bucket < RADIX_BUCKET_COUNT; ++bucket) {
+      for (Histogram& histogram : histograms) {
+        const size_t bucketCount = histogram[bucket];
+        histogram[bucket]        = offset;
+        offset += bucketCount;
+      }
+    }
+
+    forEachChunk(pool, chunkCount, [&](size_t chunk) {
+      Histogram&   writeOffsets = histograms[chunk];
+      const size_t end          = std::min(count, (chunk + 1) * chunkSize);
+      for (size_t i = chunk * chunkSize; i < end; ++i) {
+        dst[writeOffsets[digitOf(src[i].key, pass)]++] = src[i];
+      }
+    });
+    std::swap(src, dst);
+  }
+
+  if (src != items.data()) { std::copy_n(src, count, items.data()); }
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+struct ThreadPool;
+
+struct RadixSortItem {
+  uint64_t key {};
+  uint32_t value {};
+};
+
+// Stable LSD radix sort over the 64 bit key, one byte per pass.
+// Passes where every key has the same byte are skipped, so keys with few used bits sort in few passes.
+// scratch must be as large as items. With a pool, large inputs build histograms and scatter in parallel chunks.
+void
+radixSort(std::span<RadixSortItem> items, std::span<RadixSortItem> scratch, ThreadPool* pool = nullptr);
@@ -0,0 +1,63 @@
+#include "RingAllocator.h"
+
+#include <stdexcept>
+
+RingAllocator::RingAllocator(const uint64_t capacity) : m_capacity {capacity} {}
+
+std::optional<RingAllocation>
+RingAllocator::allocate(const uint64_t size, const uint64_t alignment) {
+  if (size == 0 || size > m_capacity) { return std::nullopt; }
+  if (m_used == 0) {
+    m_head = 0;
+    m_tail = 0;
+  } else if (m_head == m_tail) {
+    // full
+    return std::nullopt;
+  }
+
+  const uint64_t align   = alignment == 0 ? 1 : alignment;
+  const uint64_t aligned = (m_head + align - 1) / align * align;
+
+  if (m_head >= m_tail) {
+    // free space is [head, capacity) and [0, tail)
+    if (aligned + size <= m_capacity) {
+      RingAllocation allocation {.offset = aligned, .consumed = aligned - m_head + size};
+      m_head = aligned + size;
+      m_used += allocation.consumed;
+      return allocation;
+    }
+    if (size <= m_tail) {
+      RingAllocation allocation {.offset = 0, .consumed = m_capacity - m_head + size};
+      m_head = size;
+      m_used += allocation.consumed;
+      return allocation;
+    }
+    return std::nullopt;
+  }
+
+  // free space is [head, tail)
+  if (aligned + size <= m_tail) {
+    RingAllocation allocation {.offset = aligned, .consumed = aligned - m_head + size};
+    m_head = aligned + size;
+    m_used += allocation.consumed;
+    return allocation;
+  }
+  return std::nullopt;
+}
+
+void
+RingAllocator::release(const uint64_t consumed) {
+  if (consumed > m_used) { throw std::runtime_error("RingAllocator: Trying to release more than allocated!"); }
+  m_tail = (m_tail + consumed) % m_capacity;
+  m_used -= consumed;
+}
+
+uint64_t
+RingAllocator::getCapacity() const {
+  return m_capacity;
+}
+
+uint64_t
+RingAllocator::getUsed() const {
+  return m_used;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+
+// FIFO sub-allocator over a fixed size ring, allocations are released in the same order they were made
+struct RingAllocation {
+  uint64_t offset {};
+  // bytes taken from the ring, includes alignment padding and the skipped tail when wrapping around
+  uint64_t consumed {};
+};
+
+struct RingAllocator {
+private:
+  uint64_t m_capacity {};
+  uint64_t m_head {};
+  uint64_t m_tail {};
+  uint64_t m_used {};
+
+public:
+  RingAllocator() = default;
+
+  explicit RingAllocator(uint64_t capacity);
+
+  std::optional<RingAllocation>
+  allocate(uint64_t size, uint64_t alignment);
+
+  // releases the oldest 'consumed' bytes
+  void
+  release(uint64_t consumed);
+
+  [[nodiscard]] uint64_t
+  getCapacity() const;
+
+  [[nodiscard]] uint64_t
+  getUsed() const;
+};
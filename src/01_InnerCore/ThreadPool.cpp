@@ -0,0 +1,57 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(const uint32_t threadCount) {
+  m_workers.reserve(threadCount);
+  for (uint32_t i = 0; i < std::max(threadCount, 1u); ++i) {
+    m_workers.emplace_back([this] { workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock {m_mutex};
+    m_stopping = true;
+  }
+  m_condition.notify_all();
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void
+ThreadPool::workerLoop() {
+  while (true) {
+    std::function<void()> job {};
+    {
+      std::unique_lock lock {m_mutex};
+      m_condition.wait(lock, [this] { return m_stopping || !m_jobs.empty() || !m_urgentJobs.empty(); });
+      std::queue<std::function<void()>>& jobs = m_urgentJobs.empty() ? m_jobs : m_urgentJobs;
+      if (jobs.empty()) { return; }
+      job = std::move(jobs.front());
+      jobs.pop();
+    }
+    job();
+  }
+}
+
+void
+ThreadPool::enqueue(std::function<void()> job, const bool urgent) {
+  {
+    std::lock_guard lock {m_mutex};
+    (urgent ? m_urgentJobs : m_jobs).push(std::move(job));
+  }
+  m_condition.notify_one();
+}
+
+uint32_t
+ThreadPool::getThreadCount() const {
+  return static_cast<uint32_t>(m_workers.size());
+}
+
+uint32_t
+ThreadPool::defaultThreadCount() {
+  const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+  return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
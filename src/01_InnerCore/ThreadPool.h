@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads consuming two FIFO job queues, urgent jobs are taken before any other queued job.
+// Queued jobs still run when the pool is destroyed, the destructor returns after the last one.
+struct ThreadPool {
+private:
+  std::vector<std::thread>          m_workers {};
+  std::queue<std::function<void()>> m_jobs {};
+  // frame critical work, a worker busy with a long job still finishes it first
+  std::queue<std::function<void()>> m_urgentJobs {};
+  std::mutex                        m_mutex {};
+  std::condition_variable           m_condition {};
+  bool                              m_stopping {};
+
+  void
+  workerLoop();
+
+  void
+  enqueue(std::function<void()> job, bool urgent);
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>>
+  submitJob(F&& job, const bool urgent) {
+    using Result = std::invoke_result_t<F>;
+    // std::function needs a copyable callable, packaged_task is move only
+    auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+    auto future = task->get_future();
+    enqueue([task] { (*task)(); }, urgent);
+    return future;
+  }
+
+public:
+  explicit ThreadPool(uint32_t threadCount = defaultThreadCount());
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool&
+  operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool();
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>>
+  submit(F&& job) {
+    return submitJob(std::forward<F>(job), false);
+  }
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>>
+  submitUrgent(F&& job) {
+    return submitJob(std::forward<F>(job), true);
+  }
+
+  [[nodiscard]] uint32_t
+  getThreadCount() const;
+
+  // one thread is left for the main loop
+  static uint32_t
+  defaultThreadCount();
+};
+
+// runs job(chunkIndex) for every chunk, on the pool when there is one, and returns once all of them finished.
+// chunks are claimed one by one by the calling thread and by helpers on the pool's urgent lane. the caller keeps
+// claiming instead of waiting, helpers a busy pool starts late find nothing left, so the caller never waits behind
+// queued jobs. every chunk finishes before the first exception of a job is rethrown here
+template <typename Job>
+void
+forEachChunk(ThreadPool* pool, size_t chunkCount, Job&& job) {
+  if (pool == nullptr || chunkCount <= 1) {
+    for (size_t i = 0; i < chunkCount; ++i) {
+      job(i);
+    }
+    return;
+  }
+  // outlives the call, helpers starting after it returned only touch this
+  struct State {
+    std::atomic<size_t>     next {};
+    size_t                  finished {};
+    std::exception_ptr      firstException {};
+    std::mutex              mutex {};
+    std::condition_variable condition {};
+  };
+  auto  state  = std::make_shared<State>();
+  auto* jobPtr = &job;
+
+  // job is only dereferenced for a claimed chunk, the caller is still waiting for it then
+  auto runChunks = [state, jobPtr, chunkCount] {
+    for (size_t i = state->next++; i < chunkCount; i = state->next++) {
+      std::exception_ptr exception {};
+      try {
+        (*jobPtr)(i);
+      } catch (...) {
+        exception = std::current_exception();
+      }
+      std::lock_guard lock {state->mutex};
+      if (exception && !state->firstException) { state->firstException = exception; }
+      if (++state->finished == chunkCount) { state->condition.notify_all(); }
+    }
+  };
+  const size_t helperCount = std::min<size_t>(chunkCount - 1, pool->getThreadCount());
+  for (size_t i = 0; i < helperCount; ++i) {
+    pool->submitUrgent(runChunks);
+  }
+  runChunks();
+
+  std::unique_lock lock {state->mutex};
+  state->condition.wait(lock, [&state, chunkCount] { return state->finished == chunkCount; });
+  if (state->firstException) { std::rethrow_exception(state->firstException); }
+}
@@ -10,10 +10,15 @@ namespace Vu::config {
 constexpr u32 START_WIDTH  = 1280u;
 constexpr u32 START_HEIGHT = 720u;
 
-constexpr u32 MAX_FRAMES_IN_FLIGHT = 2u;
+// upper bound of VuRenderer::m_framesInFlight, per frame resources are created for all of them
+constexpr u32 MAX_FRAMES_IN_FLIGHT = 3u;
 
 constexpr VkDeviceSize MATERIAL_DATA_SIZE = 64u;
 constexpr u32          PUSH_CONST_SIZE    = 256u;
+// initial capacity of the per frame instance buffers, they double when a frame queues more
+constexpr u32 INITIAL_INSTANCE_CAPACITY = 1024u;
+// queued packets each secondary command buffer should get at least, smaller queues are split across fewer workers
+constexpr u32 MIN_PACKETS_PER_RECORD_CHUNK = 512u;
 
 // constexpr u32 DEVICE_MAX_IMAGE_COUNT         = 256u;
 // constexpr u32 DEVICE_MAX_SAMPLER_COUNT       = 256u;
@@ -49,6 +54,19 @@ inline static std::vector<const char*> DEVICE_EXTENSIONS = {
     //VK_EXT_ROBUSTNESS_2_EXTENSION_NAME,
 };
 
+// enabled only when the physical device supports them
+inline static std::vector<const char*> OPTIONAL_DEVICE_EXTENSIONS = {
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+    VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+    VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME,
+};
+
+// pipeline cache and other files that are safe to delete, relative to the working directory
+inline static std::filesystem::path CACHE_DIRECTORY = "cache";
+
+// shader modules every shader can import, the compiler's search path. the in-process compiler keeps them loaded
+inline static std::filesystem::path SHADER_MODULE_DIRECTORY = "assets/shaders/common";
+
 #ifdef NDEBUG
 constexpr bool ENABLE_VALIDATION_LAYERS_LAYERS = false;
 #else
@@ -0,0 +1,161 @@
+#include "VuFileWatcher.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Vu {
+
+static std::filesystem::path
+normalized(const std::filesystem::path& path) {
+  std::error_code       ec {};
+  std::filesystem::path result = std::filesystem::weakly_canonical(path, ec);
+  return ec ? path.lexically_normal() : result;
+}
+
+VuFileWatcher::VuFileWatcher(const std::chrono::milliseconds pollInterval) :
+    m_pollInterval {pollInterval} {
+#ifdef __linux__
+  m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+  m_thread = std::jthread([this](const std::stop_token& stopToken) { run(stopToken); });
+}
+
+VuFileWatcher::~VuFileWatcher() {
+  m_thread.request_stop();
+  if (m_thread.joinable()) { m_thread.join(); }
+#ifdef __linux__
+  if (m_inotifyFd >= 0) { close(m_inotifyFd); }
+#endif
+}
+
+VuFileWatcher::SubscriptionId
+VuFileWatcher::subscribe(std::span<const std::filesystem::path> files) {
+  std::lock_guard lock {m_mutex};
+  const SubscriptionId id = m_nextId++;
+
+  Subscription& subscription = m_subscriptions[id];
+  for (const std::filesystem::path& file : files) {
+    std::filesystem::path path = normalized(file);
+    if (!m_writeTimes.contains(path)) {
+      std::error_code ec {};
+      m_writeTimes[path] = std::filesystem::last_write_time(path, ec);
+      watchDirectory(path.parent_path());
+    }
+    subscription.files.push_back(std::move(path));
+  }
+  return id;
+}
+
+void
+VuFileWatcher::unsubscribe(const SubscriptionId id) {
+  std::lock_guard lock {m_mutex};
+  auto            it = m_subscriptions.find(id);
+  if (it == m_subscriptions.end()) { return; }
+  if (it->second.changed) { m_pendingChangeCount--; }
+  m_subscriptions.erase(it);
+}
+
+bool
+VuFileWatcher::consumeChange(const SubscriptionId id) {
+  if (m_pendingChangeCount.load(std::memory_order_acquire) == 0) { return false; }
+
+  std::lock_guard lock {m_mutex};
+  auto            it = m_subscriptions.find(id);
+  if (it == m_subscriptions.end() || !it->second.changed) { return false; }
+  it->second.changed = false;
+  m_pendingChangeCount--;
+  return true;
+}
+
+bool
+VuFileWatcher::isEventDriven() const {
+  return m_inotifyFd >= 0;
+}
+
+void
+VuFileWatcher::run(const std::stop_token& stopToken) {
+  while (!stopToken.stop_requested()) {
+#ifdef __linux__
+    if (isEventDriven()) {
+      pollfd pollFd {.fd = m_inotifyFd, .events = POLLIN, .revents = 0};
+      // bounded wait so a stop request is noticed
+      if (poll(&pollFd, 1, static_cast<int>(m_pollInterval.count())) > 0) { readInotifyEvents(); }
+      continue;
+    }
+#endif
+    std::this_thread::sleep_for(m_pollInterval);
+    pollWriteTimes();
+  }
+}
+
+void
+VuFileWatcher::readInotifyEvents() {
+#ifdef __linux__
+  alignas(inotify_event) char buffer[4096];
+  while (true) {
+    const ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+    if (length <= 0) { return; }
+
+    for (ssize_t offset = 0; offset < length;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+      if (event->len == 0) { continue; }
+
+      std::lock_guard lock {m_mutex};
+      auto            dirIt = m_directoryWatches.find(event->wd);
+      if (dirIt == m_directoryWatches.end()) { continue; }
+      markChanged(dirIt->second / event->name);
+    }
+  }
+#endif
+}
+
+void
+VuFileWatcher::pollWriteTimes() {
+  std::lock_guard                    lock {m_mutex};
+  std::vector<std::filesystem::path> changedFiles {};
+  for (auto& [path, writeTime] : m_writeTimes) {
+    std::error_code ec {};
+    const auto      currentTime = std::filesystem::last_write_time(path, ec);
+    if (!ec && currentTime != writeTime) { changedFiles.push_back(path); }
+  }
+  for (const std::filesystem::path& path : changedFiles) {
+    markChanged(path);
+  }
+}
+
+void
+VuFileWatcher::markChanged(const std::filesystem::path& file) {
+  auto timeIt = m_writeTimes.find(file);
+  if (timeIt == m_writeTimes.end()) { return; }
+
+  std::error_code ec {};
+  timeIt->second = std::filesystem::last_write_time(file, ec);
+
+  for (auto& [id, subscription] : m_subscriptions) {
+    if (subscription.changed || std::ranges::find(subscription.files, file) == subscription.files.end()) { continue; }
+    subscription.changed = true;
+    m_pendingChangeCount.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void
+VuFileWatcher::watchDirectory(const std::filesystem::path& directory) {
+#ifdef __linux__
+  if (!isEventDriven()) { return; }
+  for (const auto& [wd, watchedDirectory] : m_directoryWatches) {
+    if (watchedDirectory == directory) { return; }
+  }
+  // editors often save by writing a new file and renaming it over the old one
+  const int wd = inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+  if (wd >= 0) { m_directoryWatches[wd] = directory; }
+#else
+  (void)directory;
+#endif
+}
+} // namespace Vu
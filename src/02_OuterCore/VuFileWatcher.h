@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "01_InnerCore/TypeDefs.h"
+
+namespace Vu {
+
+// Watches files on a background thread, inotify on linux and last write time polling elsewhere.
+// Subscribers register a set of files and query a change flag, the query is a single atomic load while nothing changed.
+struct VuFileWatcher {
+  using SubscriptionId = u32;
+
+private:
+  struct Subscription {
+    std::vector<std::filesystem::path> files {};
+    bool                               changed {};
+  };
+
+  using WriteTimeMap = std::unordered_map<std::filesystem::path, std::filesystem::file_time_type>;
+
+  mutable std::mutex                               m_mutex {};
+  std::unordered_map<SubscriptionId, Subscription> m_subscriptions {};
+  WriteTimeMap                                     m_writeTimes {};
+  SubscriptionId                                   m_nextId {1};
+  // subscriptions with a change nobody consumed yet
+  std::atomic<u32>          m_pendingChangeCount {};
+  std::chrono::milliseconds m_pollInterval {};
+  int                       m_inotifyFd {-1};
+  // inotify watch descriptor of every watched directory
+  std::unordered_map<int, std::filesystem::path> m_directoryWatches {};
+  std::jthread                                   m_thread {};
+
+public:
+  explicit VuFileWatcher(std::chrono::milliseconds pollInterval = std::chrono::milliseconds(250));
+
+  VuFileWatcher(const VuFileWatcher&) = delete;
+  VuFileWatcher&
+  operator=(const VuFileWatcher&) = delete;
+
+  ~VuFileWatcher();
+
+  // ids start from 1
+  SubscriptionId
+  subscribe(std::span<const std::filesystem::path> files);
+
+  void
+  unsubscribe(SubscriptionId id);
+
+  // true once for every batch of changes to any file of the subscription
+  bool
+  consumeChange(SubscriptionId id);
+
+  // false when running on the polling fallback
+  [[nodiscard]] bool
+  isEventDriven() const;
+
+private:
+  void
+  run(const std::stop_token& stopToken);
+
+  void
+  readInotifyEvents();
+
+  void
+  pollWriteTimes();
+
+  void
+  markChanged(const std::filesystem::path& file);
+
+  void
+  watchDirectory(const std::filesystem::path& directory);
+};
+} // namespace Vu
@@ -0,0 +1,108 @@
+#include "VuShaderCache.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iterator>
+
+#include "01_InnerCore/Hash.h"
+
+namespace Vu {
+
+static std::string_view
+trimLeft(std::string_view line) {
+  const size_t first = line.find_first_not_of(" \t");
+  return first == std::string_view::npos ? std::string_view {} : line.substr(first);
+}
+
+// #include "file" references relative to the directory of the referencing file, import module; references there and
+// in every search path
+static std::vector<std::filesystem::path>
+parseReferences(const std::filesystem::path& filePath, std::span<const std::filesystem::path> searchPaths) {
+  std::vector<std::filesystem::path> references {};
+  std::ifstream                      file {filePath};
+  std::string                        line {};
+  while (std::getline(file, line)) {
+    std::string_view view = trimLeft(line);
+    // a re-exported module is resolved like any other import
+    if (view.starts_with("__exported ")) { view = trimLeft(view.substr(11)); }
+
+    if (view.starts_with("#include")) {
+      const size_t open  = view.find('"');
+      const size_t close = view.find('"', open + 1);
+      if (open == std::string_view::npos || close == std::string_view::npos) { continue; }
+      references.push_back(filePath.parent_path() / view.substr(open + 1, close - open - 1));
+
+    } else if (view.starts_with("import ")) {
+      std::string moduleName {trimLeft(view.substr(7))};
+      moduleName = moduleName.substr(0, moduleName.find(';'));
+      std::ranges::replace(moduleName, '.', '/');
+      // slang also looks for the module with underscores spelled as dashes, missing candidates are skipped later
+      std::string dashedName = moduleName;
+      std::ranges::replace(dashedName, '_', '-');
+
+      references.push_back(filePath.parent_path() / (moduleName + ".slang"));
+      references.push_back(filePath.parent_path() / (dashedName + ".slang"));
+      for (const std::filesystem::path& searchPath : searchPaths) {
+        references.push_back(searchPath / (moduleName + ".slang"));
+        references.push_back(searchPath / (dashedName + ".slang"));
+      }
+    }
+  }
+  return references;
+}
+
+std::vector<std::filesystem::path>
+VuShaderCache::collectSourceFiles(const std::filesystem::path&          shaderPath,
+                                  std::span<const std::filesystem::path> searchPaths) {
+  std::vector<std::filesystem::path> files {};
+  std::vector<std::filesystem::path> stack {shaderPath};
+
+  while (!stack.empty()) {
+    std::filesystem::path current = stack.back();
+    stack.pop_back();
+
+    std::error_code ec {};
+    current = std::filesystem::weakly_canonical(current, ec);
+    if (ec || !std::filesystem::is_regular_file(current, ec)) { continue; }
+    if (std::ranges::find(files, current) != files.end()) { continue; }
+
+    files.push_back(current);
+    std::vector<std::filesystem::path> references = parseReferences(current, searchPaths);
+    // reversed so files are visited in the order they are referenced
+    stack.insert(stack.end(), references.rbegin(), references.rend());
+  }
+  return files;
+}
+
+u64
+VuShaderCache::computeKey(const std::filesystem::path&          shaderPath,
+                          std::string_view                       compilerFlags,
+                          std::string_view                       compilerVersion,
+                          std::span<const std::filesystem::path> searchPaths) {
+  u64 hash = fnv1a64(compilerFlags);
+  hash     = fnv1a64(compilerVersion, hash);
+
+  for (const std::filesystem::path& file : collectSourceFiles(shaderPath, searchPaths)) {
+    std::ifstream     stream {file, std::ios::binary};
+    const std::string content {std::istreambuf_iterator<char> {stream}, std::istreambuf_iterator<char> {}};
+    hash = fnv1a64(file.filename().string(), hash);
+    hash = fnv1a64(content, hash);
+  }
+  return hash;
+}
+
+std::string
+VuShaderCache::compilerFingerprint(const std::filesystem::path& compilerPath) {
+  std::error_code ec {};
+  const auto      size      = std::filesystem::file_size(compilerPath, ec);
+  const auto      writeTime = std::filesystem::last_write_time(compilerPath, ec);
+  if (ec) { return "unknown"; }
+  return std::format("{}:{}", size, writeTime.time_since_epoch().count());
+}
+
+std::filesystem::path
+VuShaderCache::spirvPath(const std::filesystem::path& cacheDirectory, const std::filesystem::path& shaderPath, u64 key) {
+  return cacheDirectory / "shaders" / std::format("{}_{:016x}.spv", shaderPath.stem().string(), key);
+}
+} // namespace Vu
@@ -0,0 +1,36 @@
+#pragma once
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "01_InnerCore/TypeDefs.h"
+
+namespace Vu {
+
+// Naming and keying of compiled SPIR-V files.
+// A key covers the shader source, every file it pulls in, the compiler flags and the compiler binary,
+// so a cached file can be used without invoking the compiler at all.
+struct VuShaderCache {
+  // the shader first, then every transitively included or imported file once. imports are looked up next to the
+  // importing file first, then in searchPaths like the compiler's -I. references that cannot be resolved are skipped,
+  // the compiler reports them
+  static std::vector<std::filesystem::path>
+  collectSourceFiles(const std::filesystem::path&          shaderPath,
+                     std::span<const std::filesystem::path> searchPaths = {});
+
+  static u64
+  computeKey(const std::filesystem::path&          shaderPath,
+             std::string_view                       compilerFlags,
+             std::string_view                       compilerVersion,
+             std::span<const std::filesystem::path> searchPaths = {});
+
+  // size and write time of the compiler binary, changes whenever the compiler is replaced
+  static std::string
+  compilerFingerprint(const std::filesystem::path& compilerPath);
+
+  static std::filesystem::path
+  spirvPath(const std::filesystem::path& cacheDirectory, const std::filesystem::path& shaderPath, u64 key);
+};
+} // namespace Vu
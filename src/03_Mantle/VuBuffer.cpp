@@ -10,8 +10,20 @@
 
 namespace Vu {
 
+static VuMemoryCategory
+memoryCategoryOf(const VuBufferCreateInfo& createInfo) {
+  if (createInfo.memoryUsage == VuMemoryUsage::Upload) { return VuMemoryCategory::Staging; }
+  if (createInfo.vkUsageFlags & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+    return VuMemoryCategory::Geometry;
+  }
+  if (createInfo.vkUsageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) { return VuMemoryCategory::Uniform; }
+  if (createInfo.vkUsageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) { return VuMemoryCategory::Storage; }
+  return VuMemoryCategory::Other;
+}
+
 VkResult
 VuBuffer::map() {
+  if (!isHostVisible()) { return VK_ERROR_MEMORY_MAP_FAILED; }
   return vkMapMemory(m_vuDevice->m_device, m_deviceMemory, MakeVkOffset(0), VK_WHOLE_SIZE, ZERO_FLAG, &m_mapPtr);
 }
 
@@ -42,6 +54,11 @@ VuBuffer::getSizeInBytes() const {
   return m_sizeInBytes;
 }
 
+bool
+VuBuffer::isHostVisible() const {
+  return (m_memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
 std::span<byte>
 VuBuffer::getMappedSpan(VkDeviceSize start, VkDeviceSize sizeInBytes) const {
   auto* base = static_cast<std::byte*>(m_mapPtr);
@@ -69,9 +86,12 @@ VuBuffer::VuBuffer(std::shared_ptr<VuDevice> vuDevice, const VuBufferCreateInfo&
   VkMemoryRequirements memoryRequirements {};
   vkGetBufferMemoryRequirements(vuDevice->m_device, m_buffer, &memoryRequirements);
 
-  auto memoryOrErr = vuDevice->allocateMemory(createInfo.vkMemoryPropertyFlags, memoryRequirements);
+  auto memoryOrErr = vuDevice->allocateMemory(VuMemoryStrategy::fromUsage(createInfo.memoryUsage),
+                                              memoryRequirements,
+                                              {.name = createInfo.name, .category = memoryCategoryOf(createInfo)});
   THROW_if_unexpected(memoryOrErr);
-  this->m_deviceMemory = std::move(memoryOrErr.value());
+  this->m_deviceMemory        = memoryOrErr->memory;
+  this->m_memoryPropertyFlags = memoryOrErr->propertyFlags;
 
   VkResult bindRes = vkBindBufferMemory(vuDevice->m_device, m_buffer, m_deviceMemory, MakeVkOffset(0));
   THROW_if_fail(bindRes);
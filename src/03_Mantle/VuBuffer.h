@@ -17,9 +17,8 @@ struct VuBufferCreateInfo {
   VuName             name         = {"VuBuffer"};
   VkDeviceSize       sizeInBytes  = {1};
   VkBufferUsageFlags vkUsageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-
-  VkMemoryPropertyFlags vkMemoryPropertyFlags =
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  // GpuOnly buffers are not mappable, fill them through VuUploadContext
+  VuMemoryUsage memoryUsage = VuMemoryUsage::DynamicPerFrame;
 
   VkMemoryAllocateFlags vkMemoryAllocateFlags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
 };
@@ -30,6 +29,7 @@ struct VuBuffer {
   VkBuffer                  m_buffer {nullptr};
   void*                     m_mapPtr {};
   VkDeviceSize              m_sizeInBytes {};
+  VkMemoryPropertyFlags     m_memoryPropertyFlags {};
   VuName                    m_name {"VuBuffer"};
   zero_optional<u32>        m_bindlessIndex {};
 
@@ -48,6 +48,7 @@ public:
       m_buffer(other.m_buffer),
       m_mapPtr(other.m_mapPtr),
       m_sizeInBytes(other.m_sizeInBytes),
+      m_memoryPropertyFlags(other.m_memoryPropertyFlags),
       m_name(std::move(other.m_name)),
       m_bindlessIndex(other.m_bindlessIndex) {
     other.m_deviceMemory  = VK_NULL_HANDLE;
@@ -61,13 +62,14 @@ public:
   operator=(VuBuffer&& other) noexcept {
     if (this != &other) {
       cleanup();
-      m_vuDevice      = std::move(other.m_vuDevice);
-      m_deviceMemory  = other.m_deviceMemory;
-      m_buffer        = other.m_buffer;
-      m_mapPtr        = other.m_mapPtr;
-      m_sizeInBytes   = other.m_sizeInBytes;
-      m_name          = std::move(other.m_name);
-      m_bindlessIndex = other.m_bindlessIndex;
+      m_vuDevice            = std::move(other.m_vuDevice);
+      m_deviceMemory        = other.m_deviceMemory;
+      m_buffer              = other.m_buffer;
+      m_mapPtr              = other.m_mapPtr;
+      m_sizeInBytes         = other.m_sizeInBytes;
+      m_memoryPropertyFlags = other.m_memoryPropertyFlags;
+      m_name                = std::move(other.m_name);
+      m_bindlessIndex       = other.m_bindlessIndex;
 
       other.m_deviceMemory  = VK_NULL_HANDLE;
       other.m_buffer        = VK_NULL_HANDLE;
@@ -83,12 +85,16 @@ public:
 private:
   void
   cleanup() {
+    if (m_bindlessIndex) {
+      m_vuDevice->releaseBindlessSlot(VuBindlessTable::StorageBuffer, *m_bindlessIndex);
+      m_bindlessIndex = zero_optional<u32> {};
+    }
     if (m_mapPtr) {
       vkUnmapMemory(m_vuDevice->m_device, m_deviceMemory);
       m_mapPtr = nullptr;
     }
     if (m_deviceMemory != VK_NULL_HANDLE) {
-      vkFreeMemory(m_vuDevice->m_device, m_deviceMemory, nullptr);
+      m_vuDevice->freeMemory(m_deviceMemory);
       m_deviceMemory = VK_NULL_HANDLE;
     }
     if (m_buffer != VK_NULL_HANDLE) {
@@ -116,6 +122,9 @@ public:
   [[nodiscard]] VkDeviceSize
   getSizeInBytes() const;
 
+  [[nodiscard]] bool
+  isHostVisible() const;
+
   [[nodiscard]] std::span<byte>
   getMappedSpan(VkDeviceSize start, VkDeviceSize sizeInBytes) const;
 
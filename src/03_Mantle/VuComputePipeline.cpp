@@ -0,0 +1,55 @@
+#include "VuComputePipeline.h"
+
+#include <chrono>
+#include <utility>
+
+#include "02_OuterCore/VuCommon.h"
+#include "VuDevice.h"
+
+Vu::VuComputePipeline::VuComputePipeline() = default;
+Vu::VuComputePipeline::VuComputePipeline(VuComputePipeline&& other) noexcept :
+    m_vuDevice(std::move(other.m_vuDevice)),
+    m_pipeline(other.m_pipeline) {
+  other.m_pipeline = VK_NULL_HANDLE;
+}
+Vu::VuComputePipeline&
+Vu::VuComputePipeline::operator=(VuComputePipeline&& other) noexcept {
+  if (this != &other) {
+    cleanup();
+    m_vuDevice       = std::move(other.m_vuDevice);
+    m_pipeline       = other.m_pipeline;
+    other.m_pipeline = VK_NULL_HANDLE;
+  }
+  return *this;
+}
+Vu::VuComputePipeline::~VuComputePipeline() { cleanup(); }
+void
+Vu::VuComputePipeline::cleanup() {
+  if (m_pipeline != VK_NULL_HANDLE) {
+    vkDestroyPipeline(m_vuDevice->m_device, m_pipeline, nullptr);
+    m_pipeline = VK_NULL_HANDLE;
+  }
+  m_vuDevice.reset();
+}
+Vu::VuComputePipeline::VuComputePipeline(std::shared_ptr<VuDevice> vuDevice,
+                                         const VkPipelineLayout&   pipelineLayout,
+                                         const VkShaderModule&     computeShaderModule) :
+    m_vuDevice(vuDevice) {
+  VkPipelineShaderStageCreateInfo stageInfo {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+  stageInfo.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+  stageInfo.module = computeShaderModule;
+  stageInfo.pName  = "main";
+
+  VkComputePipelineCreateInfo pipelineInfo {.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+  pipelineInfo.stage              = stageInfo;
+  pipelineInfo.layout             = pipelineLayout;
+  pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+  const auto startTime = std::chrono::steady_clock::now();
+  VkResult   cpRes     = vkCreateComputePipelines(
+      vuDevice->m_device, vuDevice->m_pipelineCache->m_pipelineCache, 1, &pipelineInfo, NO_ALLOC_CALLBACK, &m_pipeline);
+  THROW_if_fail(cpRes);
+
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+  vuDevice->m_pipelineCache->recordPipelineCreation(elapsed.count());
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "02_OuterCore/VuCommon.h"
+namespace Vu {
+struct VuDevice;
+
+struct VuComputePipeline {
+  std::shared_ptr<VuDevice> m_vuDevice {nullptr};
+  VkPipeline                m_pipeline {nullptr};
+
+  SETUP_EXPECTED_WRAPPER(VuComputePipeline,
+                         (std::shared_ptr<VuDevice> vuDevice,
+                          const VkPipelineLayout&   pipelineLayout,
+                          const VkShaderModule&     computeShaderModule),
+                         (vuDevice, pipelineLayout, computeShaderModule))
+public:
+  VuComputePipeline();
+
+  VuComputePipeline(const VuComputePipeline&) = delete;
+
+  VuComputePipeline&
+  operator=(const VuComputePipeline&) = delete;
+
+  VuComputePipeline(VuComputePipeline&& other) noexcept;
+
+  VuComputePipeline&
+  operator=(VuComputePipeline&& other) noexcept;
+
+  ~VuComputePipeline();
+
+private:
+  void
+  cleanup();
+
+  VuComputePipeline(std::shared_ptr<VuDevice> vuDevice,
+                    const VkPipelineLayout&   pipelineLayout,
+                    const VkShaderModule&     computeShaderModule);
+};
+} // namespace Vu
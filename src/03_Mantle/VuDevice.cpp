@@ -1,8 +1,12 @@
 #include "VuDevice.h"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <set>
 
 #include "../02_OuterCore/VuCommon.h"
+#include "../02_OuterCore/VuConfig.h"
 #include "VuPhysicalDevice.h"
 
 namespace Vu {
@@ -27,33 +31,103 @@ VuDevice::createPipelineLayout(const std::span<VkDescriptorSetLayout> descriptor
   return pipelineLayout;
 }
 std::expected<VkDeviceMemory, VkResult>
-VuDevice::allocateMemory(const VkMemoryPropertyFlags& memPropFlags, const VkMemoryRequirements& requirements) const {
-  auto memTypeIndex =
-      findMemoryTypeIndex(m_vuPhysicalDevice->m_memoryProperties, requirements.memoryTypeBits, memPropFlags);
-
-  if (!memTypeIndex) { return std::unexpected {memTypeIndex.error()}; }
+VuDevice::allocateMemory(const VkMemoryPropertyFlags& memPropFlags,
+                         const VkMemoryRequirements&  requirements,
+                         const VuMemoryTag&           tag) const {
+  auto allocationOrErr = allocateMemory(VuMemoryStrategy {.required = memPropFlags}, requirements, tag);
+  if (!allocationOrErr) { return std::unexpected {allocationOrErr.error()}; }
+  return allocationOrErr->memory;
+}
+std::expected<VuMemoryAllocation, VkResult>
+VuDevice::allocateMemory(const VuMemoryStrategy&     strategy,
+                         const VkMemoryRequirements& requirements,
+                         const VuMemoryTag&          tag) const {
+  std::vector<uint32_t> candidates = findMemoryTypeCandidates(requirements.memoryTypeBits, strategy, requirements.size);
+  if (candidates.empty()) { return std::unexpected {VK_ERROR_OUT_OF_DEVICE_MEMORY}; }
 
   VkMemoryAllocateFlagsInfo allocFlagsInfo {.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO};
   allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
 
   VkMemoryAllocateInfo allocInfo {.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-  allocInfo.pNext           = &allocFlagsInfo;
-  allocInfo.allocationSize  = requirements.size;
-  allocInfo.memoryTypeIndex = memTypeIndex.value();
-
-  VkDeviceMemory memory {};
-  VkResult       memoryRes = vkAllocateMemory(m_device, &allocInfo, NO_ALLOC_CALLBACK, &memory);
-  RETURN_UNEXPECTED_ON_FAIL(memoryRes);
-  return memory;
+  allocInfo.pNext          = &allocFlagsInfo;
+  allocInfo.allocationSize = requirements.size;
+
+  VkResult memoryRes = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+  for (uint32_t memoryTypeIndex : candidates) {
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkDeviceMemory memory {};
+    memoryRes = vkAllocateMemory(m_device, &allocInfo, NO_ALLOC_CALLBACK, &memory);
+    if (memoryRes == VK_SUCCESS) {
+      const VkMemoryType&         memoryType = m_vuPhysicalDevice->m_memoryProperties.memoryTypes[memoryTypeIndex];
+      const VkMemoryPropertyFlags flags      = memoryType.propertyFlags;
+      m_memoryTracker->onAllocate(memory,
+                                  {.tag             = tag,
+                                   .sizeInBytes     = requirements.size,
+                                   .memoryTypeIndex = memoryTypeIndex,
+                                   .heapIndex       = memoryType.heapIndex});
+      return VuMemoryAllocation {.memory = memory, .memoryTypeIndex = memoryTypeIndex, .propertyFlags = flags};
+    }
+    // heap is full, try the next best type
+    if (memoryRes != VK_ERROR_OUT_OF_DEVICE_MEMORY && memoryRes != VK_ERROR_OUT_OF_HOST_MEMORY) { break; }
+  }
+  return std::unexpected {memoryRes};
+}
+void
+VuDevice::freeMemory(VkDeviceMemory memory) const {
+  if (memory == VK_NULL_HANDLE) { return; }
+  m_memoryTracker->onFree(memory);
+  vkFreeMemory(m_device, memory, NO_ALLOC_CALLBACK);
+}
+std::vector<VuHeapBudget>
+VuDevice::queryMemoryBudget() const {
+  const VkPhysicalDeviceMemoryProperties& memoryProperties = m_vuPhysicalDevice->m_memoryProperties;
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+  if (m_memoryBudgetEnabled) {
+    VkPhysicalDeviceMemoryProperties2 memoryProperties2 {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2};
+    memoryProperties2.pNext = &budgetProperties;
+    vkGetPhysicalDeviceMemoryProperties2(m_vuPhysicalDevice->m_physicalDevice, &memoryProperties2);
+  }
+
+  std::vector<VuHeapBudget> budgets {};
+  budgets.reserve(memoryProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+    const VkMemoryHeap& heap = memoryProperties.memoryHeaps[i];
+
+    VuHeapBudget heapBudget {};
+    heapBudget.heapIndex = i;
+    heapBudget.flags     = heap.flags;
+    heapBudget.size      = heap.size;
+    heapBudget.budget    = m_memoryBudgetEnabled ? budgetProperties.heapBudget[i] : heap.size;
+    heapBudget.usage     = m_memoryBudgetEnabled ? budgetProperties.heapUsage[i] : 0;
+    budgets.push_back(heapBudget);
+  }
+  return budgets;
+}
+bool
+VuDevice::isExtensionEnabled(const char* extensionName) const {
+  return std::ranges::find(m_enabledExtensions, extensionName) != m_enabledExtensions.end();
+}
+void
+VuDevice::releaseBindlessSlot(const VuBindlessTable table, const u32 index) const {
+  if (m_bindlessSlotReleaser) { m_bindlessSlotReleaser(table, index); }
 }
 VuDevice::VuDevice(const std::shared_ptr<VuPhysicalDevice>& vuPhyDevice,
                    const VkPhysicalDeviceFeatures2&         featuresChain,
                    std::span<const char*>                   enabledExtensions) :
-    m_vuPhysicalDevice {vuPhyDevice} {
+    m_vuPhysicalDevice {vuPhyDevice},
+    m_enabledExtensions(enabledExtensions.begin(), enabledExtensions.end()),
+    m_memoryTracker {std::make_unique<VuMemoryTracker>()} {
+
+  m_memoryBudgetEnabled = isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos {};
 
-  std::set<uint32_t> uniqueQueueFamilies = {vuPhyDevice->m_indices.graphicsFamily, vuPhyDevice->m_indices.presentFamily};
+  const VuQueueFamilyIndices& indices             = vuPhyDevice->m_indices;
+  std::set<uint32_t>          uniqueQueueFamilies = {
+      indices.graphicsFamily, indices.presentFamily, indices.transferFamily, indices.computeFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -75,20 +149,82 @@ VuDevice::VuDevice(const std::shared_ptr<VuPhysicalDevice>& vuPhyDevice,
   VkResult deviceRes = vkCreateDevice(vuPhyDevice->m_physicalDevice, &createInfo, NO_ALLOC_CALLBACK, &m_device);
   THROW_if_fail(deviceRes);
 
-  vkGetDeviceQueue(m_device, vuPhyDevice->m_indices.graphicsFamily, 0, &m_graphicsQueue);
-  vkGetDeviceQueue(m_device, vuPhyDevice->m_indices.presentFamily, 0, &m_presentQueue);
+  vkGetDeviceQueue(m_device, indices.graphicsFamily, 0, &m_graphicsQueue);
+  vkGetDeviceQueue(m_device, indices.presentFamily, 0, &m_presentQueue);
+  vkGetDeviceQueue(m_device, indices.transferFamily, 0, &m_transferQueue);
+  vkGetDeviceQueue(m_device, indices.computeFamily, 0, &m_computeQueue);
+
+  m_pipelineCache = std::make_unique<VuPipelineCache>(m_device, vuPhyDevice->m_properties, config::CACHE_DIRECTORY);
+  m_timeline      = std::make_unique<VuTimeline>(m_device);
+
+  if (isExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+    m_dynamicRasterState.vkCmdSetCullMode =
+        reinterpret_cast<PFN_vkCmdSetCullModeEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetCullModeEXT"));
+    m_dynamicRasterState.vkCmdSetDepthTestEnable =
+        reinterpret_cast<PFN_vkCmdSetDepthTestEnableEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetDepthTestEnableEXT"));
+    m_dynamicRasterState.vkCmdSetDepthWriteEnable = reinterpret_cast<PFN_vkCmdSetDepthWriteEnableEXT>(
+        vkGetDeviceProcAddr(m_device, "vkCmdSetDepthWriteEnableEXT"));
+    m_dynamicRasterState.vkCmdSetDepthCompareOp =
+        reinterpret_cast<PFN_vkCmdSetDepthCompareOpEXT>(vkGetDeviceProcAddr(m_device, "vkCmdSetDepthCompareOpEXT"));
+  }
+  if (isExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+    m_dynamicRasterState.vkCmdSetColorBlendEnable = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(
+        vkGetDeviceProcAddr(m_device, "vkCmdSetColorBlendEnableEXT"));
+  }
 }
-std::expected<uint32_t, VkResult>
-VuDevice::findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties& memoryProperties,
-                              uint32_t                                typeFilter,
-                              VkMemoryPropertyFlags                   requiredProperties) {
+std::vector<uint32_t>
+VuDevice::findMemoryTypeCandidates(const uint32_t          typeFilter,
+                                   const VuMemoryStrategy& strategy,
+                                   const VkDeviceSize      size) const {
+  const VkPhysicalDeviceMemoryProperties& memoryProperties = m_vuPhysicalDevice->m_memoryProperties;
+  const std::vector<VuHeapBudget>         budgets          = queryMemoryBudget();
+
+  struct Candidate {
+    uint32_t typeIndex;
+    int      score;
+  };
+  std::vector<Candidate> candidates {};
+
   for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
-    const bool isTypeSuitable = (typeFilter & (1 << i)) != 0;
-    const bool hasRequiredProperties =
-        (memoryProperties.memoryTypes[i].propertyFlags & requiredProperties) == requiredProperties;
+    const VkMemoryPropertyFlags flags          = memoryProperties.memoryTypes[i].propertyFlags;
+    const bool                  isTypeSuitable = (typeFilter & (1 << i)) != 0;
+    const bool hasRequiredProperties           = (flags & strategy.required) == strategy.required;
+
+    if (!isTypeSuitable || !hasRequiredProperties) { continue; }
+
+    int score = std::popcount(flags & strategy.preferred) * 4 - std::popcount(flags & strategy.avoided) * 4;
+
+    // a heap that would go over its budget is still a valid fallback, just the last one
+    const VuHeapBudget& heapBudget = budgets[memoryProperties.memoryTypes[i].heapIndex];
+    if (heapBudget.usage + size > heapBudget.budget) { score -= 64; }
 
-    if (isTypeSuitable && hasRequiredProperties) { return i; }
+    candidates.push_back({i, score});
+  }
+
+  std::ranges::stable_sort(candidates, [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+  std::vector<uint32_t> typeIndices {};
+  typeIndices.reserve(candidates.size());
+  for (const Candidate& candidate : candidates) {
+    typeIndices.push_back(candidate.typeIndex);
+  }
+  return typeIndices;
+}
+VuMemoryStrategy
+VuMemoryStrategy::fromUsage(const VuMemoryUsage usage) {
+  switch (usage) {
+  case VuMemoryUsage::GpuOnly:
+    return {.required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, .avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+  case VuMemoryUsage::Upload:
+    return {.required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .avoided  = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+  case VuMemoryUsage::Readback:
+    return {.required  = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT};
+  case VuMemoryUsage::DynamicPerFrame:
+    return {.required  = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
   }
-  return std::unexpected {VK_ERROR_OUT_OF_DEVICE_MEMORY};
+  return {};
 }
 } // namespace Vu
\ No newline at end of file
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "../02_OuterCore/VuCommon.h"
+#include "VuMemoryTracker.h"
+#include "VuPipelineCache.h"
+#include "VuTimeline.h"
+#include "VuTypes.h"
 
 namespace vk {
 class DescriptorSetLayout;
@@ -73,7 +80,7 @@ struct VuDeviceCreateFeatureChain {
       .descriptorBindingStorageTexelBufferUpdateAfterBind = VK_TRUE,
       .descriptorBindingUpdateUnusedWhilePending          = VK_TRUE,
       .descriptorBindingPartiallyBound                    = VK_TRUE,
-      .descriptorBindingVariableDescriptorCount           = VK_FALSE,
+      .descriptorBindingVariableDescriptorCount           = VK_TRUE,
       .runtimeDescriptorArray                             = VK_TRUE,
       .samplerFilterMinmax                                = VK_FALSE,
       .scalarBlockLayout                                  = VK_TRUE,
@@ -95,8 +102,10 @@ struct VuDeviceCreateFeatureChain {
   };
 
   VkPhysicalDeviceFeatures deviceFeatures {
-      .samplerAnisotropy = VK_TRUE,
-      .shaderInt64       = VK_TRUE,
+      .multiDrawIndirect         = VK_FALSE,
+      .drawIndirectFirstInstance = VK_FALSE,
+      .samplerAnisotropy         = VK_TRUE,
+      .shaderInt64               = VK_TRUE,
   };
 
   VkPhysicalDeviceFeatures2 deviceFeatures2 {
@@ -104,8 +113,87 @@ struct VuDeviceCreateFeatureChain {
       .pNext    = &vk12_features,
       .features = deviceFeatures,
   };
+
+  // optional, linked in only when the matching extension is enabled
+  VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures {
+      .sType                = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+      .pNext                = nullptr,
+      .extendedDynamicState = VK_TRUE,
+  };
+
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features {
+      .sType                                 = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+      .pNext                                 = nullptr,
+      .extendedDynamicState3ColorBlendEnable = VK_TRUE,
+  };
+
+  template <typename T>
+  void
+  link(T& featureStruct) {
+    featureStruct.pNext   = deviceFeatures2.pNext;
+    deviceFeatures2.pNext = &featureStruct;
+  }
+};
+// #####################################################################################################################
+
+// extension commands for raster state a material may change, null when the extension is not enabled.
+// with them one pipeline serves every MaterialSettings instead of one pipeline per combination
+struct VuDynamicRasterState {
+  PFN_vkCmdSetCullModeEXT         vkCmdSetCullMode {nullptr};
+  PFN_vkCmdSetDepthTestEnableEXT  vkCmdSetDepthTestEnable {nullptr};
+  PFN_vkCmdSetDepthWriteEnableEXT vkCmdSetDepthWriteEnable {nullptr};
+  PFN_vkCmdSetDepthCompareOpEXT   vkCmdSetDepthCompareOp {nullptr};
+  PFN_vkCmdSetColorBlendEnableEXT vkCmdSetColorBlendEnable {nullptr};
+
+  // VK_EXT_extended_dynamic_state
+  [[nodiscard]] bool
+  hasCullAndDepth() const {
+    return vkCmdSetCullMode != nullptr;
+  }
+
+  // VK_EXT_extended_dynamic_state3
+  [[nodiscard]] bool
+  hasBlendEnable() const {
+    return vkCmdSetColorBlendEnable != nullptr;
+  }
+};
+
+// #####################################################################################################################
+
+enum class VuMemoryUsage {
+  // static data, written once through staging
+  GpuOnly,
+  // staging source, written by cpu and read once by gpu
+  Upload,
+  // written by gpu, read by cpu
+  Readback,
+  // rewritten by cpu every frame, device local when the device has a host visible one (ReBAR/UMA)
+  DynamicPerFrame,
+};
+
+struct VuMemoryStrategy {
+  VkMemoryPropertyFlags required {};
+  VkMemoryPropertyFlags preferred {};
+  VkMemoryPropertyFlags avoided {};
+
+  static VuMemoryStrategy
+  fromUsage(VuMemoryUsage usage);
+};
+
+struct VuMemoryAllocation {
+  VkDeviceMemory        memory {nullptr};
+  uint32_t              memoryTypeIndex {};
+  VkMemoryPropertyFlags propertyFlags {};
 };
 
+struct VuHeapBudget {
+  uint32_t          heapIndex {};
+  VkMemoryHeapFlags flags {};
+  VkDeviceSize      size {};
+  // without VK_EXT_memory_budget budget is the heap size and usage is unknown (zero)
+  VkDeviceSize budget {};
+  VkDeviceSize usage {};
+};
 // #####################################################################################################################
 
 struct VuDevice {
@@ -113,12 +201,48 @@ struct VuDevice {
   VkDevice                          m_device {nullptr};
   VkQueue                           m_graphicsQueue {nullptr};
   VkQueue                           m_presentQueue {nullptr};
+  // same handle as m_graphicsQueue when the device has no dedicated family
+  VkQueue                           m_transferQueue {nullptr};
+  VkQueue                           m_computeQueue {nullptr};
+  std::vector<std::string>          m_enabledExtensions {};
+  bool                              m_memoryBudgetEnabled {};
+  std::unique_ptr<VuMemoryTracker>  m_memoryTracker {nullptr};
+  // seeded from disk on creation, written back when the device is destroyed
+  std::unique_ptr<VuPipelineCache>  m_pipelineCache {nullptr};
+  // signaled by every tracked graphics queue submit, frames and uploads wait on it instead of fences
+  std::unique_ptr<VuTimeline>       m_timeline {nullptr};
+  VuDynamicRasterState              m_dynamicRasterState {};
+  // set by the owner of the bindless tables, resources destroyed while still holding a slot hand it back through it.
+  // render thread only
+  VuBindlessSlotReleaser            m_bindlessSlotReleaser {};
 
   [[nodiscard]] std::expected<VkPipelineLayout, VkResult>
   createPipelineLayout(std::span<VkDescriptorSetLayout> descriptorSetLayouts, uint32_t pushConstantSizeAsByte) const;
 
   [[nodiscard]] std::expected<VkDeviceMemory, VkResult>
-  allocateMemory(const VkMemoryPropertyFlags& memPropFlags, const VkMemoryRequirements& requirements) const;
+  allocateMemory(const VkMemoryPropertyFlags& memPropFlags,
+                 const VkMemoryRequirements&  requirements,
+                 const VuMemoryTag&           tag = {}) const;
+
+  // tries every suitable memory type from best to worst until one allocation succeeds
+  [[nodiscard]] std::expected<VuMemoryAllocation, VkResult>
+  allocateMemory(const VuMemoryStrategy&     strategy,
+                 const VkMemoryRequirements& requirements,
+                 const VuMemoryTag&          tag = {}) const;
+
+  // counterpart of allocateMemory, keeps the memory tracker in sync
+  void
+  freeMemory(VkDeviceMemory memory) const;
+
+  [[nodiscard]] std::vector<VuHeapBudget>
+  queryMemoryBudget() const;
+
+  [[nodiscard]] bool
+  isExtensionEnabled(const char* extensionName) const;
+
+  // does nothing without a releaser, the tables are gone or were never created
+  void
+  releaseBindlessSlot(VuBindlessTable table, u32 index) const;
 
   //--------------------------------------------------------------------------------------------------------------------
   SETUP_EXPECTED_WRAPPER(VuDevice,
@@ -135,23 +259,45 @@ struct VuDevice {
       m_vuPhysicalDevice(std::move(other.m_vuPhysicalDevice)),
       m_device(other.m_device),
       m_graphicsQueue(other.m_graphicsQueue),
-      m_presentQueue(other.m_presentQueue) {
+      m_presentQueue(other.m_presentQueue),
+      m_transferQueue(other.m_transferQueue),
+      m_computeQueue(other.m_computeQueue),
+      m_enabledExtensions(std::move(other.m_enabledExtensions)),
+      m_memoryBudgetEnabled(other.m_memoryBudgetEnabled),
+      m_memoryTracker(std::move(other.m_memoryTracker)),
+      m_pipelineCache(std::move(other.m_pipelineCache)),
+      m_timeline(std::move(other.m_timeline)),
+      m_dynamicRasterState(other.m_dynamicRasterState),
+      m_bindlessSlotReleaser(std::move(other.m_bindlessSlotReleaser)) {
     other.m_device        = VK_NULL_HANDLE;
     other.m_graphicsQueue = VK_NULL_HANDLE;
     other.m_presentQueue  = VK_NULL_HANDLE;
+    other.m_transferQueue = VK_NULL_HANDLE;
+    other.m_computeQueue  = VK_NULL_HANDLE;
   }
 
   VuDevice&
   operator=(VuDevice&& other) noexcept {
     if (this != &other) {
       cleanup();
-      m_vuPhysicalDevice    = std::move(other.m_vuPhysicalDevice);
-      m_device              = other.m_device;
-      m_graphicsQueue       = other.m_graphicsQueue;
-      m_presentQueue        = other.m_presentQueue;
-      other.m_device        = VK_NULL_HANDLE;
-      other.m_graphicsQueue = VK_NULL_HANDLE;
-      other.m_presentQueue  = VK_NULL_HANDLE;
+      m_vuPhysicalDevice     = std::move(other.m_vuPhysicalDevice);
+      m_device               = other.m_device;
+      m_graphicsQueue        = other.m_graphicsQueue;
+      m_presentQueue         = other.m_presentQueue;
+      m_transferQueue        = other.m_transferQueue;
+      m_computeQueue         = other.m_computeQueue;
+      m_enabledExtensions    = std::move(other.m_enabledExtensions);
+      m_memoryBudgetEnabled  = other.m_memoryBudgetEnabled;
+      m_memoryTracker        = std::move(other.m_memoryTracker);
+      m_pipelineCache        = std::move(other.m_pipelineCache);
+      m_timeline             = std::move(other.m_timeline);
+      m_dynamicRasterState   = other.m_dynamicRasterState;
+      m_bindlessSlotReleaser = std::move(other.m_bindlessSlotReleaser);
+      other.m_device         = VK_NULL_HANDLE;
+      other.m_graphicsQueue  = VK_NULL_HANDLE;
+      other.m_presentQueue   = VK_NULL_HANDLE;
+      other.m_transferQueue  = VK_NULL_HANDLE;
+      other.m_computeQueue   = VK_NULL_HANDLE;
     }
     return *this;
   }
@@ -162,10 +308,17 @@ private:
   void
   cleanup() {
     if (m_device != VK_NULL_HANDLE) {
+      m_timeline.reset();
+      if (m_pipelineCache) {
+        m_pipelineCache->save();
+        m_pipelineCache.reset();
+      }
       vkDestroyDevice(m_device, nullptr);
       m_device = VK_NULL_HANDLE;
       m_graphicsQueue = VK_NULL_HANDLE;
       m_presentQueue  = VK_NULL_HANDLE;
+      m_transferQueue = VK_NULL_HANDLE;
+      m_computeQueue  = VK_NULL_HANDLE;
       m_vuPhysicalDevice.reset();
     }
   }
@@ -174,10 +327,9 @@ private:
            const VkPhysicalDeviceFeatures2&         featuresChain,
            std::span<const char*>                   enabledExtensions);
 
-  static std::expected<uint32_t, VkResult>
-  findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties& memoryProperties,
-                      uint32_t                                typeFilter,
-                      VkMemoryPropertyFlags                   requiredProperties);
+  // suitable memory types ordered from best to worst, empty when nothing has the required properties
+  [[nodiscard]] std::vector<uint32_t>
+  findMemoryTypeCandidates(uint32_t typeFilter, const VuMemoryStrategy& strategy, VkDeviceSize size) const;
 };
 
 } // namespace Vu
@@ -0,0 +1,280 @@
+#include "VuGpuProfiler.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <utility>
+
+#include "01_InnerCore/VuLogger.h"
+#include "02_OuterCore/VuConfig.h"
+#include "VuDevice.h"
+#include "VuPhysicalDevice.h"
+#include "VuTimeline.h"
+
+namespace Vu {
+
+float
+timestampDeltaMs(const u64 begin, const u64 end, const u32 validBits, const float period) {
+  const u64 mask  = validBits >= 64u ? ~u64 {0} : (u64 {1} << validBits) - 1u;
+  const u64 ticks = (end - begin) & mask;
+  return static_cast<float>(static_cast<double>(ticks) * period / 1'000'000.0);
+}
+
+VuGpuTimings::VuGpuTimings(const u32 windowSize) : m_windowSize {std::max(windowSize, 1u)} {}
+
+void
+VuGpuTimings::addSample(const std::string_view name, const float milliseconds) {
+  auto it = std::ranges::find(m_scopes, name, &Scope::name);
+  if (it == m_scopes.end()) {
+    it = m_scopes.insert(m_scopes.end(), Scope {.name = std::string {name}});
+    it->samples.reserve(m_windowSize);
+  }
+  if (it->samples.size() < m_windowSize) {
+    it->samples.push_back(milliseconds);
+  } else {
+    it->samples[it->next] = milliseconds;
+  }
+  it->next = (it->next + 1u) % m_windowSize;
+  it->last = milliseconds;
+}
+
+std::vector<VuGpuScopeStats>
+VuGpuTimings::getStats() const {
+  std::vector<VuGpuScopeStats> stats {};
+  stats.reserve(m_scopes.size());
+  for (const Scope& scope : m_scopes) {
+    VuGpuScopeStats& scopeStats = stats.emplace_back(VuGpuScopeStats {.name = scope.name, .lastMs = scope.last});
+    if (scope.samples.empty()) { continue; }
+
+    const auto [minIt, maxIt] = std::ranges::minmax_element(scope.samples);
+    float sum {};
+    for (const float sample : scope.samples) {
+      sum += sample;
+    }
+    scopeStats.avgMs       = sum / static_cast<float>(scope.samples.size());
+    scopeStats.minMs       = *minIt;
+    scopeStats.maxMs       = *maxIt;
+    scopeStats.sampleCount = static_cast<u32>(scope.samples.size());
+  }
+  return stats;
+}
+
+void
+VuGpuTimings::clear() {
+  m_scopes.clear();
+}
+
+std::string
+VuGpuTimings::toCsv() const {
+  auto quoted = [](std::string_view str) {
+    std::string out {"\""};
+    for (char c : str) {
+      if (c == '"') { out.push_back('"'); }
+      out.push_back(c);
+    }
+    out.push_back('"');
+    return out;
+  };
+
+  std::string csv {"scope,last_ms,avg_ms,min_ms,max_ms,samples\n"};
+  for (const VuGpuScopeStats& stats : getStats()) {
+    csv += std::format("{},{:.4f},{:.4f},{:.4f},{:.4f},{}\n",
+                       quoted(stats.name),
+                       stats.lastMs,
+                       stats.avgMs,
+                       stats.minMs,
+                       stats.maxMs,
+                       stats.sampleCount);
+  }
+  return csv;
+}
+
+bool
+VuGpuTimings::dumpCsv(const std::filesystem::path& path) const {
+  std::ofstream file {path, std::ios::trunc};
+  if (!file.is_open()) { return false; }
+  file << toCsv();
+  return file.good();
+}
+
+VuGpuProfiler::VuGpuProfiler(VuGpuProfiler&& other) noexcept :
+    m_vuDevice(std::move(other.m_vuDevice)),
+    m_queryPool(other.m_queryPool),
+    m_frames(std::move(other.m_frames)),
+    m_timings(std::move(other.m_timings)),
+    m_maxScopesPerFrame(other.m_maxScopesPerFrame),
+    m_timestampValidBits(other.m_timestampValidBits),
+    m_timestampPeriod(other.m_timestampPeriod),
+    m_recordingFrame(other.m_recordingFrame),
+    m_enabled(other.m_enabled) {
+  other.m_queryPool = VK_NULL_HANDLE;
+}
+
+VuGpuProfiler&
+VuGpuProfiler::operator=(VuGpuProfiler&& other) noexcept {
+  if (this != &other) {
+    cleanup();
+    m_vuDevice           = std::move(other.m_vuDevice);
+    m_queryPool          = other.m_queryPool;
+    m_frames             = std::move(other.m_frames);
+    m_timings            = std::move(other.m_timings);
+    m_maxScopesPerFrame  = other.m_maxScopesPerFrame;
+    m_timestampValidBits = other.m_timestampValidBits;
+    m_timestampPeriod    = other.m_timestampPeriod;
+    m_recordingFrame     = other.m_recordingFrame;
+    m_enabled            = other.m_enabled;
+    other.m_queryPool    = VK_NULL_HANDLE;
+  }
+  return *this;
+}
+
+VuGpuProfiler::~VuGpuProfiler() { cleanup(); }
+
+bool
+VuGpuProfiler::isSupported() const {
+  return m_queryPool != VK_NULL_HANDLE;
+}
+
+void
+VuGpuProfiler::beginFrame(const VkCommandBuffer& cb, const u32 frameIndex) {
+  if (!isSupported()) { return; }
+
+  // oldest first, samples of a scope arrive in frame order
+  std::vector<u32> pendingFrames {};
+  for (u32 i = 0; i < m_frames.size(); ++i) {
+    if (m_frames[i].pending) { pendingFrames.push_back(i); }
+  }
+  std::ranges::sort(pendingFrames, {}, [&](const u32 i) { return m_frames[i].timelineValue; });
+
+  VuTimeline& timeline = *m_vuDevice->m_timeline;
+  for (const u32 i : pendingFrames) {
+    if (timeline.isComplete(m_frames[i].timelineValue) && readBack(i)) { m_frames[i].pending = false; }
+  }
+
+  // the frame's queries are reused now, results that are still not available are dropped
+  Frame& frame  = m_frames[frameIndex];
+  frame.pending = false;
+  frame.scopes.clear();
+  m_recordingFrame = frameIndex;
+  vkCmdResetQueryPool(cb, m_queryPool, firstQuery(frameIndex), m_maxScopesPerFrame * 2u);
+}
+
+void
+VuGpuProfiler::endFrame(const u64 timelineValue) {
+  if (!isSupported()) { return; }
+  Frame& frame        = m_frames[m_recordingFrame];
+  frame.timelineValue = timelineValue;
+  frame.pending       = !frame.scopes.empty();
+}
+
+void
+VuGpuProfiler::beginScope(const VkCommandBuffer& cb, const char* name) {
+  if (!isSupported() || !m_enabled) { return; }
+  Frame& frame = m_frames[m_recordingFrame];
+  // scopes over the limit are not timed
+  if (frame.scopes.size() == m_maxScopesPerFrame) { return; }
+
+  const u32 query = firstQuery(m_recordingFrame) + static_cast<u32>(frame.scopes.size()) * 2u;
+  vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, query);
+  frame.scopes.push_back(Scope {.name = name});
+}
+
+void
+VuGpuProfiler::endScope(const VkCommandBuffer& cb, const std::string_view name) {
+  if (!isSupported()) { return; }
+  std::vector<Scope>& scopes = m_frames[m_recordingFrame].scopes;
+  for (u32 i = static_cast<u32>(scopes.size()); i-- > 0;) {
+    if (scopes[i].ended || scopes[i].name != name) { continue; }
+
+    const u32 query = firstQuery(m_recordingFrame) + i * 2u + 1u;
+    vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, query);
+    scopes[i].ended = true;
+    return;
+  }
+}
+
+bool
+VuGpuProfiler::readBack(const u32 frameIndex) {
+  const std::vector<Scope>& scopes     = m_frames[frameIndex].scopes;
+  const u32                 queryCount = static_cast<u32>(scopes.size()) * 2u;
+
+  // value and availability per query. without WAIT a missing result only reports VK_NOT_READY
+  std::vector<u64> results(queryCount * 2u);
+  const VkResult   resultsRes = vkGetQueryPoolResults(m_vuDevice->m_device,
+                                                    m_queryPool,
+                                                    firstQuery(frameIndex),
+                                                    queryCount,
+                                                    results.size() * sizeof(u64),
+                                                    results.data(),
+                                                    2u * sizeof(u64),
+                                                    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  if (resultsRes != VK_SUCCESS && resultsRes != VK_NOT_READY) {
+    Logger::Warn("gpu profiler readback failed, frame dropped");
+    return true;
+  }
+
+  // scopes left open never wrote their end timestamp, they are skipped instead of waited for
+  for (u32 i = 0; i < scopes.size(); ++i) {
+    if (scopes[i].ended && (results[i * 4u + 1u] == 0 || results[i * 4u + 3u] == 0)) { return false; }
+  }
+
+  std::vector<std::pair<std::string_view, float>> totals {};
+  for (u32 i = 0; i < scopes.size(); ++i) {
+    if (!scopes[i].ended) { continue; }
+    const float ms = timestampDeltaMs(results[i * 4u], results[i * 4u + 2u], m_timestampValidBits, m_timestampPeriod);
+
+    const std::string_view name = scopes[i].name;
+    auto it = std::ranges::find(totals, name, &std::pair<std::string_view, float>::first);
+    if (it == totals.end()) {
+      totals.emplace_back(name, ms);
+    } else {
+      it->second += ms;
+    }
+  }
+  for (const auto& [name, ms] : totals) {
+    m_timings.addSample(name, ms);
+  }
+  return true;
+}
+
+u32
+VuGpuProfiler::firstQuery(const u32 frameIndex) const {
+  return frameIndex * m_maxScopesPerFrame * 2u;
+}
+
+void
+VuGpuProfiler::cleanup() {
+  if (m_vuDevice && m_queryPool != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(m_vuDevice->m_device, m_queryPool, NO_ALLOC_CALLBACK);
+  }
+  m_queryPool = VK_NULL_HANDLE;
+  m_frames.clear();
+  m_vuDevice.reset();
+}
+
+VuGpuProfiler::VuGpuProfiler(std::shared_ptr<VuDevice> vuDevice, const VuGpuProfilerCreateInfo& createInfo) :
+    m_vuDevice(vuDevice),
+    m_frames(config::MAX_FRAMES_IN_FLIGHT),
+    m_timings(createInfo.windowSize),
+    m_maxScopesPerFrame(createInfo.maxScopesPerFrame) {
+  const VuPhysicalDevice& physicalDevice = *vuDevice->m_vuPhysicalDevice;
+
+  u32 queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.m_physicalDevice, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+  // zero when the queue cannot write timestamps, software drivers like lavapipe report all 64 bits
+  m_timestampValidBits = queueFamilies[physicalDevice.m_indices.graphicsFamily].timestampValidBits;
+  m_timestampPeriod    = physicalDevice.m_properties.limits.timestampPeriod;
+  if (m_timestampValidBits == 0 || m_timestampPeriod <= 0.0f) {
+    Logger::Info("Timestamp queries not supported on the graphics queue, gpu profiler is off");
+    return;
+  }
+
+  VkQueryPoolCreateInfo queryPoolInfo {.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+  queryPoolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+  queryPoolInfo.queryCount = config::MAX_FRAMES_IN_FLIGHT * m_maxScopesPerFrame * 2u;
+  THROW_if_fail(vkCreateQueryPool(vuDevice->m_device, &queryPoolInfo, NO_ALLOC_CALLBACK, &m_queryPool));
+}
+} // namespace Vu
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "01_InnerCore/TypeDefs.h"
+#include "02_OuterCore/VuCommon.h"
+
+namespace Vu {
+struct VuDevice;
+
+// milliseconds between two timestamps of a queue with validBits significant bits, a counter that wrapped in between
+// is handled. period is VkPhysicalDeviceLimits::timestampPeriod, nanoseconds per tick
+[[nodiscard]] float
+timestampDeltaMs(u64 begin, u64 end, u32 validBits, float period);
+
+struct VuGpuScopeStats {
+  std::string name {};
+  float       lastMs {};
+  // over the samples still in the window
+  float avgMs {};
+  float minMs {};
+  float maxMs {};
+  u32   sampleCount {};
+};
+// #####################################################################################################################
+// Rolling per scope timings, one sample per scope and frame. Scopes keep the order they were first seen in.
+struct VuGpuTimings {
+private:
+  struct Scope {
+    std::string        name {};
+    // ring of the last window size samples
+    std::vector<float> samples {};
+    u32                next {};
+    float              last {};
+  };
+
+  std::vector<Scope> m_scopes {};
+  u32                m_windowSize {};
+
+public:
+  explicit VuGpuTimings(u32 windowSize = 120u);
+
+  void
+  addSample(std::string_view name, float milliseconds);
+
+  [[nodiscard]] std::vector<VuGpuScopeStats>
+  getStats() const;
+
+  void
+  clear();
+
+  [[nodiscard]] std::string
+  toCsv() const;
+
+  [[nodiscard]] bool
+  dumpCsv(const std::filesystem::path& path) const;
+};
+// #####################################################################################################################
+
+struct VuGpuProfilerCreateInfo {
+  // scopes one frame can time, every scope takes two timestamps
+  u32 maxScopesPerFrame {32u};
+  // frames the averages, minimums and maximums are taken over
+  u32 windowSize {120u};
+};
+
+// GPU time of named scopes of a frame's command buffer, from a timestamp query pool with one range per frame in
+// flight. Results are read without waiting once the frame's timeline value completed, a frame whose results are not
+// available yet is retried on the next beginFrame. A device without timestamps on the graphics queue makes every call
+// a no-op. Only used from the render thread.
+struct VuGpuProfiler {
+  struct Scope {
+    // string literals, scope names have to outlive the frame's readback
+    const char* name {};
+    bool        ended {};
+  };
+
+  struct Frame {
+    std::vector<Scope> scopes {};
+    u64                timelineValue {};
+    bool               pending {};
+  };
+
+  std::shared_ptr<VuDevice> m_vuDevice {};
+  VkQueryPool               m_queryPool {nullptr};
+  // indexed by frame in flight
+  std::vector<Frame>        m_frames {};
+  VuGpuTimings              m_timings {};
+  u32                       m_maxScopesPerFrame {};
+  u32                       m_timestampValidBits {};
+  float                     m_timestampPeriod {};
+  // frame whose command buffer is being recorded, set by beginFrame
+  u32                       m_recordingFrame {};
+  // scopes are skipped while false, what was recorded before is still read back
+  bool                      m_enabled {true};
+
+  SETUP_EXPECTED_WRAPPER(VuGpuProfiler,
+                         (std::shared_ptr<VuDevice> vuDevice, const VuGpuProfilerCreateInfo& createInfo),
+                         (vuDevice, createInfo))
+public:
+  VuGpuProfiler() = default;
+
+  VuGpuProfiler(const VuGpuProfiler&) = delete;
+
+  VuGpuProfiler&
+  operator=(const VuGpuProfiler&) = delete;
+
+  VuGpuProfiler(VuGpuProfiler&& other) noexcept;
+
+  VuGpuProfiler&
+  operator=(VuGpuProfiler&& other) noexcept;
+
+  ~VuGpuProfiler();
+
+  [[nodiscard]] bool
+  isSupported() const;
+
+  // right after the frame's command buffer began, outside of any render pass. reads back every completed frame, the
+  // frame's previous submission must have completed
+  void
+  beginFrame(const VkCommandBuffer& cb, u32 frameIndex);
+
+  // value the frame's submit signals on the device timeline
+  void
+  endFrame(u64 timelineValue);
+
+  // scopes may nest and may span render passes, inside a pass taking secondary command buffers none can begin or end.
+  // a name timed more than once in a frame adds up
+  void
+  beginScope(const VkCommandBuffer& cb, const char* name);
+
+  // ends the last open scope with the name, does nothing when there is none
+  void
+  endScope(const VkCommandBuffer& cb, std::string_view name);
+
+private:
+  VuGpuProfiler(std::shared_ptr<VuDevice> vuDevice, const VuGpuProfilerCreateInfo& createInfo);
+
+  void
+  cleanup();
+
+  // false while the frame's results are not available yet
+  bool
+  readBack(u32 frameIndex);
+
+  [[nodiscard]] u32
+  firstQuery(u32 frameIndex) const;
+};
+} // namespace Vu
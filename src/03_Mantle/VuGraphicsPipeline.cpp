@@ -1,6 +1,7 @@
 #include "VuGraphicsPipeline.h"
 
 #include <array> // for array
+#include <chrono>
 #include <stdint.h>
 #include <utility>
 #include <vector> // for vector
@@ -38,7 +39,9 @@ Vu::VuGraphicsPipeline::VuGraphicsPipeline(std::shared_ptr<VuDevice>
                                            const VkShaderModule&                          vertShaderModule,
                                            const VkShaderModule&                          fragShaderModule,
                                            const VkRenderPass&                            renderPass,
-                                           std::span<VkPipelineColorBlendAttachmentState> colorBlends) :
+                                           const u32                                      subpass,
+                                           std::span<VkPipelineColorBlendAttachmentState> colorBlends,
+                                           const VuPipelineRasterState&                   rasterState) :
     m_vuDevice(vuDevice) {
   VkPipelineShaderStageCreateInfo vertShaderStageInfo {};
   vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -52,7 +55,8 @@ Vu::VuGraphicsPipeline::VuGraphicsPipeline(std::shared_ptr<VuDevice>
   fragShaderStageInfo.module = fragShaderModule;
   fragShaderStageInfo.pName  = "main";
 
-  std::array shaderStages = {vertShaderStageInfo, fragShaderStageInfo};
+  std::array   shaderStages = {vertShaderStageInfo, fragShaderStageInfo};
+  const size_t stageCount   = fragShaderModule != VK_NULL_HANDLE ? shaderStages.size() : 1;
 
   VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
   vertexInputInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -76,7 +80,7 @@ Vu::VuGraphicsPipeline::VuGraphicsPipeline(std::shared_ptr<VuDevice>
   rasterizer.depthClampEnable        = VK_FALSE;
   rasterizer.rasterizerDiscardEnable = VK_FALSE;
   rasterizer.polygonMode             = VK_POLYGON_MODE_FILL;
-  rasterizer.cullMode                = VK_CULL_MODE_BACK_BIT;
+  rasterizer.cullMode                = rasterState.cullMode;
   rasterizer.frontFace               = VK_FRONT_FACE_COUNTER_CLOCKWISE;
   rasterizer.depthBiasEnable         = VK_FALSE;
   rasterizer.lineWidth               = 1.0f;
@@ -86,24 +90,48 @@ Vu::VuGraphicsPipeline::VuGraphicsPipeline(std::shared_ptr<VuDevice>
   multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
   multisampling.sampleShadingEnable  = VK_FALSE;
 
+  const VuDynamicRasterState& dynamicRasterState = vuDevice->m_dynamicRasterState;
+
+  // with dynamic blend enable the factors stay set up and only the enable bit changes per material
+  const bool useBlendFactors = rasterState.blendEnable || dynamicRasterState.hasBlendEnable();
+
+  std::vector<VkPipelineColorBlendAttachmentState> blendStates(colorBlends.begin(), colorBlends.end());
+  for (VkPipelineColorBlendAttachmentState& blendState : blendStates) {
+    if (!useBlendFactors) { continue; }
+    blendState.blendEnable         = rasterState.blendEnable ? VK_TRUE : VK_FALSE;
+    blendState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendState.colorBlendOp        = VK_BLEND_OP_ADD;
+    blendState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendState.alphaBlendOp        = VK_BLEND_OP_ADD;
+  }
+
   VkPipelineColorBlendStateCreateInfo colorBlending {.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
   colorBlending.logicOpEnable     = VK_FALSE;
   colorBlending.logicOp           = VK_LOGIC_OP_COPY;
-  colorBlending.attachmentCount   = (uint32_t)colorBlends.size();
-  colorBlending.pAttachments      = colorBlends.data();
+  colorBlending.attachmentCount   = (uint32_t)blendStates.size();
+  colorBlending.pAttachments      = blendStates.data();
   colorBlending.blendConstants[0] = 0.0f;
   colorBlending.blendConstants[1] = 0.0f;
   colorBlending.blendConstants[2] = 0.0f;
   colorBlending.blendConstants[3] = 0.0f;
 
   std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+  if (dynamicRasterState.hasCullAndDepth()) {
+    dynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+    dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT);
+    dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT);
+    dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT);
+  }
+  if (dynamicRasterState.hasBlendEnable()) { dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT); }
 
   VkPipelineDynamicStateCreateInfo dynamicState {.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
   dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
   dynamicState.pDynamicStates    = dynamicStates.data();
 
   VkGraphicsPipelineCreateInfo pipelineInfo {.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
-  pipelineInfo.stageCount          = shaderStages.size();
+  pipelineInfo.stageCount          = static_cast<uint32_t>(stageCount);
   pipelineInfo.pStages             = shaderStages.data();
   pipelineInfo.pVertexInputState   = &vertexInputInfo;
   pipelineInfo.pInputAssemblyState = &inputAssembly;
@@ -114,15 +142,19 @@ Vu::VuGraphicsPipeline::VuGraphicsPipeline(std::shared_ptr<VuDevice>
   pipelineInfo.pDynamicState       = &dynamicState;
   pipelineInfo.layout              = pipelineLayout;
   pipelineInfo.renderPass          = renderPass;
-  pipelineInfo.subpass             = 0;
+  pipelineInfo.subpass             = subpass;
   pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE;
 
-  VkPipelineDepthStencilStateCreateInfo depth = fillDepthStencilCreateInfo(true, true, VK_COMPARE_OP_LESS_OR_EQUAL);
+  VkPipelineDepthStencilStateCreateInfo depth =
+      fillDepthStencilCreateInfo(rasterState.depthTest, rasterState.depthWrite, rasterState.depthCompareOp);
   pipelineInfo.pDepthStencilState             = &depth;
-  VkResult gpRes =
-      vkCreateGraphicsPipelines(vuDevice->m_device, VK_NULL_HANDLE, 1, &pipelineInfo, NO_ALLOC_CALLBACK, &m_pipeline);
-
+  const auto startTime = std::chrono::steady_clock::now();
+  VkResult   gpRes     = vkCreateGraphicsPipelines(
+      vuDevice->m_device, vuDevice->m_pipelineCache->m_pipelineCache, 1, &pipelineInfo, NO_ALLOC_CALLBACK, &m_pipeline);
   THROW_if_fail(gpRes);
+
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+  vuDevice->m_pipelineCache->recordPipelineCreation(elapsed.count());
 }
 
 VkPipelineDepthStencilStateCreateInfo
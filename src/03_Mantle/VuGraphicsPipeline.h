@@ -2,6 +2,20 @@
 #include "02_OuterCore/VuCommon.h"
 namespace Vu {
 struct VuDevice;
+
+// fixed function state a material can change. ignored for the parts the device sets dynamically
+struct VuPipelineRasterState {
+  VkCullModeFlags cullMode {VK_CULL_MODE_BACK_BIT};
+  bool            depthTest {true};
+  bool            depthWrite {true};
+  // EQUAL once a depth prepass laid the depth down
+  VkCompareOp depthCompareOp {VK_COMPARE_OP_LESS_OR_EQUAL};
+  // standard alpha blending on every color attachment
+  bool blendEnable {false};
+};
+// #####################################################################################################################
+
+// a null fragment shader module builds a depth only pipeline
 struct VuGraphicsPipeline {
   std::shared_ptr<VuDevice> m_vuDevice {nullptr};
   VkPipeline                m_pipeline {nullptr};
@@ -12,8 +26,17 @@ struct VuGraphicsPipeline {
                           const VkShaderModule&                          vertShaderModule,
                           const VkShaderModule&                          fragShaderModule,
                           const VkRenderPass&                            renderPass,
-                          std::span<VkPipelineColorBlendAttachmentState> colorBlends),
-                         (vuDevice, pipelineLayout, vertShaderModule, fragShaderModule, renderPass, colorBlends))
+                          u32                                            subpass,
+                          std::span<VkPipelineColorBlendAttachmentState> colorBlends,
+                          const VuPipelineRasterState&                   rasterState),
+                         (vuDevice,
+                          pipelineLayout,
+                          vertShaderModule,
+                          fragShaderModule,
+                          renderPass,
+                          subpass,
+                          colorBlends,
+                          rasterState))
 public:
   VuGraphicsPipeline();
 
@@ -38,7 +61,9 @@ private:
                      const VkShaderModule&                          vertShaderModule,
                      const VkShaderModule&                          fragShaderModule,
                      const VkRenderPass&                            renderPass,
-                     std::span<VkPipelineColorBlendAttachmentState> colorBlends);
+                     u32                                            subpass,
+                     std::span<VkPipelineColorBlendAttachmentState> colorBlends,
+                     const VuPipelineRasterState&                   rasterState);
 
 public:
   static VkPipelineDepthStencilStateCreateInfo
@@ -25,29 +25,67 @@ Vu::VuImage::VuImage(const std::shared_ptr<VuDevice>& vuDevice, const VuImageCre
   VkResult imageRes = vkCreateImage(vuDevice->m_device, &imageCreateInfo, nullptr, &m_image);
   THROW_if_fail(imageRes);
 
-  VkMemoryRequirements memRequirements;
-  vkGetImageMemoryRequirements(vuDevice->m_device, m_image, &memRequirements);
+  if (createInfo.externalMemory) { return; }
 
-  auto memoryOrErr = vuDevice->allocateMemory(createInfo.memProperties, memRequirements);
+  VkMemoryRequirements memRequirements = getMemoryRequirements();
+
+  constexpr VkImageUsageFlags attachmentUsage =
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  const VuMemoryCategory category =
+      (createInfo.usage & attachmentUsage) != 0 ? VuMemoryCategory::RenderTarget : VuMemoryCategory::Texture;
+
+  VuMemoryStrategy strategy {.required = createInfo.memProperties};
+  if (createInfo.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) {
+    strategy.preferred = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+  }
+
+  auto memoryOrErr =
+      vuDevice->allocateMemory(strategy, memRequirements, {.name = createInfo.name, .category = category});
   THROW_if_unexpected(memoryOrErr);
-  m_imageMemory = std::move(memoryOrErr.value());
+  m_imageMemory         = memoryOrErr->memory;
+  m_memoryPropertyFlags = memoryOrErr->propertyFlags;
 
   VkResult bindRes = vkBindImageMemory(vuDevice->m_device, m_image, m_imageMemory, MakeVkOffset(0));
   THROW_if_fail(bindRes);
 
+  THROW_if_fail(createImageView());
+}
+
+VkMemoryRequirements
+Vu::VuImage::getMemoryRequirements() const {
+  VkMemoryRequirements memRequirements {};
+  vkGetImageMemoryRequirements(m_vuDevice->m_device, m_image, &memRequirements);
+  return memRequirements;
+}
+
+VkResult
+Vu::VuImage::bindExternalMemory(VkDeviceMemory memory, VkDeviceSize offset) {
+  if (!m_lastCreateInfo.externalMemory || m_imageView != VK_NULL_HANDLE) { return VK_ERROR_INITIALIZATION_FAILED; }
+
+  VkResult bindRes = vkBindImageMemory(m_vuDevice->m_device, m_image, memory, offset);
+  if (bindRes != VK_SUCCESS) { return bindRes; }
+  return createImageView();
+}
+
+bool
+Vu::VuImage::isLazilyAllocated() const {
+  return (m_memoryPropertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+}
+
+VkResult
+Vu::VuImage::createImageView() {
   VkImageViewCreateInfo viewInfo {};
   viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
   viewInfo.image                           = m_image;
   viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
-  viewInfo.format                          = createInfo.format;
-  viewInfo.subresourceRange.aspectMask     = createInfo.aspectMask;
+  viewInfo.format                          = m_lastCreateInfo.format;
+  viewInfo.subresourceRange.aspectMask     = m_lastCreateInfo.aspectMask;
   viewInfo.subresourceRange.baseMipLevel   = 0;
   viewInfo.subresourceRange.levelCount     = 1;
   viewInfo.subresourceRange.baseArrayLayer = 0;
   viewInfo.subresourceRange.layerCount     = 1;
 
-  VkResult viewRes = vkCreateImageView(vuDevice->m_device, &viewInfo, NO_ALLOC_CALLBACK, &m_imageView);
-  THROW_if_fail(viewRes);
+  return vkCreateImageView(m_vuDevice->m_device, &viewInfo, NO_ALLOC_CALLBACK, &m_imageView);
 }
 
 void
@@ -64,7 +102,8 @@ Vu::VuImage::VuImage(VuImage&& other) noexcept :
     m_image(other.m_image),
     m_imageView(other.m_imageView),
     m_lastCreateInfo(std::move(other.m_lastCreateInfo)),
-    m_bindlessIndex(other.m_bindlessIndex) {
+    m_bindlessIndex(other.m_bindlessIndex),
+    m_memoryPropertyFlags(other.m_memoryPropertyFlags) {
   other.m_imageMemory   = VK_NULL_HANDLE;
   other.m_image         = VK_NULL_HANDLE;
   other.m_imageView     = VK_NULL_HANDLE;
@@ -75,12 +114,13 @@ Vu::VuImage&
 Vu::VuImage::operator=(VuImage&& other) noexcept {
   if (this != &other) {
     cleanup();
-    m_vuDevice       = std::move(other.m_vuDevice);
-    m_imageMemory    = other.m_imageMemory;
-    m_image          = other.m_image;
-    m_imageView      = other.m_imageView;
-    m_lastCreateInfo = std::move(other.m_lastCreateInfo);
-    m_bindlessIndex  = other.m_bindlessIndex;
+    m_vuDevice            = std::move(other.m_vuDevice);
+    m_imageMemory         = other.m_imageMemory;
+    m_image               = other.m_image;
+    m_imageView           = other.m_imageView;
+    m_lastCreateInfo      = std::move(other.m_lastCreateInfo);
+    m_bindlessIndex       = other.m_bindlessIndex;
+    m_memoryPropertyFlags = other.m_memoryPropertyFlags;
 
     other.m_imageMemory   = VK_NULL_HANDLE;
     other.m_image         = VK_NULL_HANDLE;
@@ -94,6 +134,10 @@ Vu::VuImage::~VuImage() { cleanup(); }
 
 void
 Vu::VuImage::cleanup() {
+  if (m_bindlessIndex) {
+    m_vuDevice->releaseBindlessSlot(Vu::VuBindlessTable::SampledImage, *m_bindlessIndex);
+    m_bindlessIndex = zero_optional<uint32_t> {};
+  }
   if (m_imageView != VK_NULL_HANDLE) {
     vkDestroyImageView(m_vuDevice->m_device, m_imageView, nullptr);
     m_imageView = VK_NULL_HANDLE;
@@ -103,7 +147,7 @@ Vu::VuImage::cleanup() {
     m_image = VK_NULL_HANDLE;
   }
   if (m_imageMemory != VK_NULL_HANDLE) {
-    vkFreeMemory(m_vuDevice->m_device, m_imageMemory, nullptr);
+    m_vuDevice->freeMemory(m_imageMemory);
     m_imageMemory = VK_NULL_HANDLE;
   }
   m_vuDevice.reset();
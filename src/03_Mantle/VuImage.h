@@ -3,6 +3,7 @@
 #include "01_InnerCore/zero_optional.h"
 #include "02_OuterCore/VuCommon.h"
 #include "stb_image.h"
+#include "VuTypes.h"
 
 namespace Vu {
 struct VuDevice;
@@ -15,6 +16,9 @@ struct VuImageCreateInfo {
   VkImageUsageFlags     usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
   VkMemoryPropertyFlags memProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
   VkImageAspectFlags    aspectMask    = VK_IMAGE_ASPECT_COLOR_BIT;
+  VuName                name          = {"VuImage"};
+  // no memory is allocated, the caller binds its own with bindExternalMemory, used for aliasing
+  bool externalMemory = false;
 };
 // #####################################################################################################################
 struct VuImage {
@@ -24,6 +28,7 @@ struct VuImage {
   VkImageView               m_imageView {nullptr};
   VuImageCreateInfo         m_lastCreateInfo = {};
   zero_optional<uint32_t>   m_bindlessIndex  = {};
+  VkMemoryPropertyFlags     m_memoryPropertyFlags {};
 
   static void
   loadImageFile(
@@ -46,9 +51,24 @@ struct VuImage {
   SETUP_EXPECTED_WRAPPER(VuImage,
                          (const std::shared_ptr<VuDevice>& vuDevice, const VuImageCreateInfo& createInfo),
                          (vuDevice, createInfo))
+
+  [[nodiscard]] VkMemoryRequirements
+  getMemoryRequirements() const;
+
+  // only for images created with externalMemory, also creates the image view
+  [[nodiscard]] VkResult
+  bindExternalMemory(VkDeviceMemory memory, VkDeviceSize offset);
+
+  // true when backed by lazily allocated memory, transient attachments on tiled gpus take no real memory then
+  [[nodiscard]] bool
+  isLazilyAllocated() const;
+
 private:
   void
   cleanup();
+
+  VkResult
+  createImageView();
   //--------------------------------------------------------------------------------------------------------------------
 
   VuImage(const std::shared_ptr<VuDevice>& vuDevice, const VuImageCreateInfo& createInfo);
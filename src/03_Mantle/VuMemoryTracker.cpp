@@ -0,0 +1,134 @@
+#include "VuMemoryTracker.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+
+namespace Vu {
+
+const char*
+toString(const VuMemoryCategory category) {
+  switch (category) {
+  case VuMemoryCategory::Other: return "Other";
+  case VuMemoryCategory::Geometry: return "Geometry";
+  case VuMemoryCategory::Uniform: return "Uniform";
+  case VuMemoryCategory::Storage: return "Storage";
+  case VuMemoryCategory::Staging: return "Staging";
+  case VuMemoryCategory::Texture: return "Texture";
+  case VuMemoryCategory::RenderTarget: return "RenderTarget";
+  case VuMemoryCategory::COUNT: break;
+  }
+  return "Unknown";
+}
+
+void
+VuMemoryTracker::onAllocate(VkDeviceMemory memory, const VuMemoryRecord& record) {
+  std::lock_guard lock {m_mutex};
+  m_records[memory] = record;
+
+  VuMemoryCategoryStats& category = m_stats.categories[static_cast<u32>(record.tag.category)];
+  category.currentBytes += record.sizeInBytes;
+  category.peakBytes = std::max(category.peakBytes, category.currentBytes);
+  category.liveAllocationCount++;
+
+  m_stats.totalBytes += record.sizeInBytes;
+  m_stats.peakTotalBytes = std::max(m_stats.peakTotalBytes, m_stats.totalBytes);
+  m_stats.liveAllocationCount++;
+  m_stats.allocateCallCount++;
+}
+
+void
+VuMemoryTracker::onFree(VkDeviceMemory memory) {
+  std::lock_guard lock {m_mutex};
+  auto            it = m_records.find(memory);
+  if (it == m_records.end()) { return; }
+
+  const VuMemoryRecord&  record   = it->second;
+  VuMemoryCategoryStats& category = m_stats.categories[static_cast<u32>(record.tag.category)];
+  category.currentBytes -= record.sizeInBytes;
+  category.liveAllocationCount--;
+
+  m_stats.totalBytes -= record.sizeInBytes;
+  m_stats.liveAllocationCount--;
+  m_records.erase(it);
+}
+
+VuMemoryStats
+VuMemoryTracker::getStats() const {
+  std::lock_guard lock {m_mutex};
+  return m_stats;
+}
+
+std::vector<VuMemoryRecord>
+VuMemoryTracker::getRecords() const {
+  std::vector<VuMemoryRecord> records {};
+  {
+    std::lock_guard lock {m_mutex};
+    records.reserve(m_records.size());
+    for (const auto& [memory, record] : m_records) {
+      records.push_back(record);
+    }
+  }
+  std::ranges::sort(records,
+                    [](const VuMemoryRecord& a, const VuMemoryRecord& b) { return a.sizeInBytes > b.sizeInBytes; });
+  return records;
+}
+
+std::string
+VuMemoryTracker::toJson() const {
+  const VuMemoryStats               stats   = getStats();
+  const std::vector<VuMemoryRecord> records = getRecords();
+
+  auto escaped = [](std::string_view str) {
+    std::string out {};
+    for (char c : str) {
+      if (c == '"' || c == '\\') { out.push_back('\\'); }
+      out.push_back(c);
+    }
+    return out;
+  };
+
+  std::string json {};
+  json += "{\n";
+  json += std::format("  \"totalBytes\": {},\n", stats.totalBytes);
+  json += std::format("  \"peakTotalBytes\": {},\n", stats.peakTotalBytes);
+  json += std::format("  \"liveAllocationCount\": {},\n", stats.liveAllocationCount);
+  json += std::format("  \"allocateCallCount\": {},\n", stats.allocateCallCount);
+
+  json += "  \"categories\": {\n";
+  for (u32 i = 0; i < stats.categories.size(); ++i) {
+    const VuMemoryCategoryStats& category = stats.categories[i];
+    json += std::format("    \"{}\": {{\"currentBytes\": {}, \"peakBytes\": {}, \"liveAllocationCount\": {}}}{}\n",
+                        toString(static_cast<VuMemoryCategory>(i)),
+                        category.currentBytes,
+                        category.peakBytes,
+                        category.liveAllocationCount,
+                        i + 1 < stats.categories.size() ? "," : "");
+  }
+  json += "  },\n";
+
+  json += "  \"allocations\": [\n";
+  for (size_t i = 0; i < records.size(); ++i) {
+    const VuMemoryRecord& record = records[i];
+    json += std::format("    {{\"name\": \"{}\", \"category\": \"{}\", \"sizeInBytes\": {}, \"memoryTypeIndex\": {}, "
+                        "\"heapIndex\": {}}}{}\n",
+                        escaped(record.tag.name.c_str()),
+                        toString(record.tag.category),
+                        record.sizeInBytes,
+                        record.memoryTypeIndex,
+                        record.heapIndex,
+                        i + 1 < records.size() ? "," : "");
+  }
+  json += "  ]\n";
+  json += "}\n";
+  return json;
+}
+
+bool
+VuMemoryTracker::dumpJson(const std::filesystem::path& path) const {
+  std::ofstream file {path, std::ios::trunc};
+  if (!file.is_open()) { return false; }
+  file << toJson();
+  return file.good();
+}
+} // namespace Vu
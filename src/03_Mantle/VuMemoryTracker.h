@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "01_InnerCore/TypeDefs.h"
+#include "02_OuterCore/VuCommon.h"
+#include "VuTypes.h"
+
+namespace Vu {
+
+enum class VuMemoryCategory : u32 {
+  Other,
+  Geometry,
+  Uniform,
+  Storage,
+  Staging,
+  Texture,
+  RenderTarget,
+  COUNT,
+};
+
+const char*
+toString(VuMemoryCategory category);
+
+// what a device memory allocation is used for, passed to VuDevice::allocateMemory
+struct VuMemoryTag {
+  VuName           name {"Unnamed"};
+  VuMemoryCategory category {VuMemoryCategory::Other};
+};
+
+struct VuMemoryRecord {
+  VuMemoryTag  tag {};
+  VkDeviceSize sizeInBytes {};
+  u32          memoryTypeIndex {};
+  u32          heapIndex {};
+};
+
+struct VuMemoryCategoryStats {
+  VkDeviceSize currentBytes {};
+  VkDeviceSize peakBytes {};
+  u32          liveAllocationCount {};
+};
+
+struct VuMemoryStats {
+  std::array<VuMemoryCategoryStats, static_cast<u32>(VuMemoryCategory::COUNT)> categories {};
+
+  VkDeviceSize totalBytes {};
+  VkDeviceSize peakTotalBytes {};
+  u32          liveAllocationCount {};
+  // every vkAllocateMemory call since device creation, including freed ones
+  u64 allocateCallCount {};
+};
+// #####################################################################################################################
+// Book-keeping of every live VkDeviceMemory owned by a VuDevice, safe to use from multiple threads.
+struct VuMemoryTracker {
+private:
+  mutable std::mutex                                 m_mutex {};
+  std::unordered_map<VkDeviceMemory, VuMemoryRecord> m_records {};
+  VuMemoryStats                                      m_stats {};
+
+public:
+  void
+  onAllocate(VkDeviceMemory memory, const VuMemoryRecord& record);
+
+  // unknown handles are ignored
+  void
+  onFree(VkDeviceMemory memory);
+
+  [[nodiscard]] VuMemoryStats
+  getStats() const;
+
+  // live allocations, largest first
+  [[nodiscard]] std::vector<VuMemoryRecord>
+  getRecords() const;
+
+  [[nodiscard]] std::string
+  toJson() const;
+
+  [[nodiscard]] bool
+  dumpJson(const std::filesystem::path& path) const;
+};
+} // namespace Vu
@@ -1,6 +1,7 @@
 
 #include "VuPhysicalDevice.h"
 
+#include <cstring>
 #include <iostream>
 #include <set>
 
@@ -43,10 +44,46 @@ VuQueueFamilyIndices::make(const VkPhysicalDevice& physDevice, const VkSurfaceKH
 
   indices.graphicsFamily = graphicsOrNull.value();
   indices.presentFamily  = presentOrNull.value();
+  indices.transferFamily = indices.graphicsFamily;
+  indices.computeFamily  = indices.graphicsFamily;
+
+  // prefer a transfer-only family (usually backed by DMA engines), then any non-graphics family that can transfer
+  std::optional<uint32_t> transferOnlyOrNull = {std::nullopt};
+  std::optional<uint32_t> transferOrNull     = {std::nullopt};
+  std::optional<uint32_t> computeOrNull      = {std::nullopt};
+
+  for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+    const VkQueueFlags flags = queueFamilies[i].queueFlags;
+    if (flags & VK_QUEUE_GRAPHICS_BIT) { continue; }
+
+    if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT) && !transferOnlyOrNull) {
+      transferOnlyOrNull = i;
+    }
+    // compute queues always support transfer even if the bit is not reported
+    if ((flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) && !transferOrNull) { transferOrNull = i; }
+    if ((flags & VK_QUEUE_COMPUTE_BIT) && !computeOrNull) { computeOrNull = i; }
+  }
+
+  if (transferOnlyOrNull) {
+    indices.transferFamily = transferOnlyOrNull.value();
+  } else if (transferOrNull) {
+    indices.transferFamily = transferOrNull.value();
+  }
+  if (computeOrNull) { indices.computeFamily = computeOrNull.value(); }
 
   return indices;
 }
 
+bool
+VuQueueFamilyIndices::hasDedicatedTransfer() const {
+  return transferFamily != graphicsFamily;
+}
+
+bool
+VuQueueFamilyIndices::hasAsyncCompute() const {
+  return computeFamily != graphicsFamily;
+}
+
 VuQueueFamilyIndices::VuQueueFamilyIndices() = default;
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 std::expected<VuSwapChainSupportDetails, VkResult>
@@ -95,6 +132,19 @@ VuPhysicalDevice::VuPhysicalDevice(std::shared_ptr<VuInstance> vuInstance,
       vkGetPhysicalDeviceProperties(phyDevice, &this->m_properties);
       vkGetPhysicalDeviceMemoryProperties(phyDevice, &this->m_memoryProperties);
       vkGetPhysicalDeviceFeatures(phyDevice, &this->m_features);
+
+      m_descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+      VkPhysicalDeviceProperties2 properties2 {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+      properties2.pNext = &m_descriptorIndexingProperties;
+      vkGetPhysicalDeviceProperties2(phyDevice, &properties2);
+      m_descriptorIndexingProperties.pNext = nullptr;
+
+      VkPhysicalDeviceVulkan12Features vk12Features {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+      VkPhysicalDeviceFeatures2        features2 {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+      features2.pNext = &vk12Features;
+      vkGetPhysicalDeviceFeatures2(phyDevice, &features2);
+      m_supportsIndirectDraw = m_features.multiDrawIndirect && m_features.drawIndirectFirstInstance &&
+                               vk12Features.drawIndirectCount;
       return;
     }
   }
@@ -142,4 +192,29 @@ VuPhysicalDevice::isExtensionsSupported(const VkPhysicalDevice& device, std::spa
   }
   return false;
 }
-} // namespace Vu
\ No newline at end of file
+
+bool
+VuPhysicalDevice::isExtensionAvailable(const char* extensionName) const {
+  uint32_t extensionCount = 0;
+  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+  for (const VkExtensionProperties& extension : availableExtensions) {
+    if (std::strcmp(extension.extensionName, extensionName) == 0) { return true; }
+  }
+  return false;
+}
+bool
+VuPhysicalDevice::supportsDynamicColorBlendEnable() const {
+  if (!isExtensionAvailable(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) { return false; }
+
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3Features {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT};
+  VkPhysicalDeviceFeatures2 features2 {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+  features2.pNext = &dynamicState3Features;
+  vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+  return dynamicState3Features.extendedDynamicState3ColorBlendEnable == VK_TRUE;
+}
+} // namespace Vu
@@ -9,9 +9,18 @@ struct VuInstance;
 struct VuQueueFamilyIndices {
   uint32_t graphicsFamily {};
   uint32_t presentFamily {};
+  // equals graphicsFamily when the device has no separate family for it
+  uint32_t transferFamily {};
+  uint32_t computeFamily {};
 
   VuQueueFamilyIndices(std::nullptr_t);
 
+  [[nodiscard]] bool
+  hasDedicatedTransfer() const;
+
+  [[nodiscard]] bool
+  hasAsyncCompute() const;
+
   static std::expected<VuQueueFamilyIndices, VkResult>
   make(const VkPhysicalDevice& physDevice, const VkSurfaceKHR& surface) noexcept;
 
@@ -31,13 +40,17 @@ struct VuSwapChainSupportDetails {
 // #####################################################################################################################
 
 struct VuPhysicalDevice {
-  std::shared_ptr<VuInstance>      m_vuInstance {nullptr};
-  VkPhysicalDevice                 m_physicalDevice {nullptr};
-  VuQueueFamilyIndices             m_indices {nullptr};
-  VuSwapChainSupportDetails        m_swapChainSupport {};
-  VkPhysicalDeviceProperties       m_properties {};
-  VkPhysicalDeviceMemoryProperties m_memoryProperties {};
-  VkPhysicalDeviceFeatures         m_features {};
+  std::shared_ptr<VuInstance>                  m_vuInstance {nullptr};
+  VkPhysicalDevice                             m_physicalDevice {nullptr};
+  VuQueueFamilyIndices                         m_indices {nullptr};
+  VuSwapChainSupportDetails                    m_swapChainSupport {};
+  VkPhysicalDeviceProperties                   m_properties {};
+  VkPhysicalDeviceMemoryProperties             m_memoryProperties {};
+  VkPhysicalDeviceFeatures                     m_features {};
+  // update after bind limits, the bindless tables are sized from these
+  VkPhysicalDeviceDescriptorIndexingProperties m_descriptorIndexingProperties {};
+  // multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount, what VuGpuScene draws with
+  bool                                         m_supportsIndirectDraw {};
   //--------------------------------------------------------------------------------------------------------------------
   VuPhysicalDevice()                        = default;
   VuPhysicalDevice(const VuPhysicalDevice&) = delete;
@@ -51,7 +64,9 @@ struct VuPhysicalDevice {
       m_swapChainSupport(std::move(other.m_swapChainSupport)),
       m_properties(other.m_properties),
       m_memoryProperties(other.m_memoryProperties),
-      m_features(other.m_features) {
+      m_features(other.m_features),
+      m_descriptorIndexingProperties(other.m_descriptorIndexingProperties),
+      m_supportsIndirectDraw(other.m_supportsIndirectDraw) {
     other.m_physicalDevice = VK_NULL_HANDLE;
   }
 
@@ -59,13 +74,15 @@ struct VuPhysicalDevice {
   operator=(VuPhysicalDevice&& other) noexcept {
     if (this != &other) {
       cleanup();
-      m_vuInstance       = std::move(other.m_vuInstance);
-      m_physicalDevice   = other.m_physicalDevice;
-      m_indices          = std::move(other.m_indices);
-      m_swapChainSupport = std::move(other.m_swapChainSupport);
-      m_properties       = other.m_properties;
-      m_memoryProperties = other.m_memoryProperties;
-      m_features         = other.m_features;
+      m_vuInstance                   = std::move(other.m_vuInstance);
+      m_physicalDevice               = other.m_physicalDevice;
+      m_indices                      = std::move(other.m_indices);
+      m_swapChainSupport             = std::move(other.m_swapChainSupport);
+      m_properties                   = other.m_properties;
+      m_memoryProperties             = other.m_memoryProperties;
+      m_features                     = other.m_features;
+      m_descriptorIndexingProperties = other.m_descriptorIndexingProperties;
+      m_supportsIndirectDraw         = other.m_supportsIndirectDraw;
 
       other.m_physicalDevice = VK_NULL_HANDLE;
     }
@@ -79,6 +96,15 @@ struct VuPhysicalDevice {
                           const VkSurfaceKHR&         surface,
                           std::span<const char*>      enabledExtensions),
                          (vuInstance, surface, enabledExtensions))
+
+  // for optional extensions, does not log anything when missing
+  [[nodiscard]] bool
+  isExtensionAvailable(const char* extensionName) const;
+
+  // VK_EXT_extended_dynamic_state3 features are individually optional, only color blend enable is used
+  [[nodiscard]] bool
+  supportsDynamicColorBlendEnable() const;
+
 private:
   void
   cleanup() {
@@ -0,0 +1,120 @@
+#include "VuPipelineCache.h"
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <vector>
+
+#include "01_InnerCore/VuLogger.h"
+
+namespace Vu {
+
+VuPipelineCache::VuPipelineCache(VkDevice                          device,
+                                 const VkPhysicalDeviceProperties& properties,
+                                 const std::filesystem::path&      directory) :
+    m_device(device),
+    m_filePath(directory / makeFileName(properties)) {
+
+  std::vector<std::byte> initialData {};
+  if (std::ifstream file {m_filePath, std::ios::binary | std::ios::ate}; file.is_open()) {
+    initialData.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(initialData.data()), static_cast<std::streamsize>(initialData.size()));
+    if (!file || !isCompatible(initialData, properties)) {
+      Logger::Warn("Pipeline cache {} is invalid, starting cold", m_filePath.string());
+      initialData.clear();
+    }
+  }
+  m_isWarm = !initialData.empty();
+
+  VkPipelineCacheCreateInfo createInfo {.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+  createInfo.initialDataSize = initialData.size();
+  createInfo.pInitialData    = initialData.data();
+  THROW_if_fail(vkCreatePipelineCache(m_device, &createInfo, NO_ALLOC_CALLBACK, &m_pipelineCache));
+
+  Logger::Info("Pipeline cache {}: {} ({} bytes)",
+               m_isWarm ? "warm" : "cold",
+               m_filePath.string(),
+               initialData.size());
+}
+
+VuPipelineCache::~VuPipelineCache() {
+  if (m_pipelineCache != VK_NULL_HANDLE) { vkDestroyPipelineCache(m_device, m_pipelineCache, NO_ALLOC_CALLBACK); }
+}
+
+bool
+VuPipelineCache::save() const {
+  {
+    std::lock_guard lock {m_statsMutex};
+    Logger::Info("Pipeline cache: {} pipelines created in {:.2f} ms in total",
+                 m_createdPipelineCount,
+                 m_totalCreateMilliseconds);
+  }
+
+  size_t dataSize = 0;
+  if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, nullptr) != VK_SUCCESS) { return false; }
+  std::vector<std::byte> data(dataSize);
+  if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, data.data()) != VK_SUCCESS) { return false; }
+
+  std::error_code errorCode {};
+  std::filesystem::create_directories(m_filePath.parent_path(), errorCode);
+
+  // written next to the target and renamed, a crash mid write must not leave a truncated cache behind
+  std::filesystem::path tempPath = m_filePath;
+  tempPath += ".tmp";
+  {
+    std::ofstream file {tempPath, std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) { return false; }
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(dataSize));
+    if (!file.good()) { return false; }
+  }
+  std::filesystem::rename(tempPath, m_filePath, errorCode);
+  return !errorCode;
+}
+
+bool
+VuPipelineCache::isWarm() const {
+  return m_isWarm;
+}
+
+void
+VuPipelineCache::recordPipelineCreation(const double milliseconds) {
+  std::lock_guard lock {m_statsMutex};
+  m_createdPipelineCount++;
+  m_totalCreateMilliseconds += milliseconds;
+}
+
+void
+VuPipelineCache::logStartupStats() const {
+  std::lock_guard lock {m_statsMutex};
+  Logger::Info("Pipeline cache {}: {} startup pipelines created in {:.2f} ms",
+               m_isWarm ? "warm" : "cold",
+               m_createdPipelineCount,
+               m_totalCreateMilliseconds);
+}
+
+std::filesystem::path
+VuPipelineCache::makeFileName(const VkPhysicalDeviceProperties& properties) {
+  std::string uuid {};
+  for (const uint8_t byte : properties.pipelineCacheUUID) {
+    uuid += std::format("{:02x}", byte);
+  }
+  return std::format("pipeline_{:04x}_{:04x}_{:08x}_{}.bin",
+                     properties.vendorID,
+                     properties.deviceID,
+                     properties.driverVersion,
+                     uuid);
+}
+
+bool
+VuPipelineCache::isCompatible(std::span<const std::byte> data, const VkPhysicalDeviceProperties& properties) {
+  VkPipelineCacheHeaderVersionOne header {};
+  if (data.size() < sizeof(header)) { return false; }
+  std::memcpy(&header, data.data(), sizeof(header));
+
+  return header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+         header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header.vendorID == properties.vendorID &&
+         header.deviceID == properties.deviceID &&
+         std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+} // namespace Vu
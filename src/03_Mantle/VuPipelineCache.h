@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <span>
+
+#include "01_InnerCore/TypeDefs.h"
+#include "02_OuterCore/VuCommon.h"
+
+namespace Vu {
+
+// #####################################################################################################################
+// VkPipelineCache persisted between runs, one file per device and driver version.
+// The file is only trusted when its header matches the device, otherwise the cache starts cold.
+struct VuPipelineCache {
+private:
+  VkDevice              m_device {nullptr};
+  std::filesystem::path m_filePath {};
+  bool                  m_isWarm {};
+  mutable std::mutex    m_statsMutex {};
+  u32                   m_createdPipelineCount {};
+  double                m_totalCreateMilliseconds {};
+
+public:
+  VkPipelineCache m_pipelineCache {nullptr};
+
+  VuPipelineCache(VkDevice                          device,
+                  const VkPhysicalDeviceProperties& properties,
+                  const std::filesystem::path&      directory);
+
+  VuPipelineCache(const VuPipelineCache&) = delete;
+  VuPipelineCache&
+  operator=(const VuPipelineCache&) = delete;
+
+  ~VuPipelineCache();
+
+  // writes the current cache content back to disk
+  bool
+  save() const;
+
+  // true when the cache was seeded from a valid file
+  [[nodiscard]] bool
+  isWarm() const;
+
+  void
+  recordPipelineCreation(double milliseconds);
+
+  // logs the creation time accumulated so far, called once the startup pipelines exist to compare cold and warm runs
+  void
+  logStartupStats() const;
+
+  // vendorID/deviceID/driverVersion/pipelineCacheUUID, a driver update starts a new file
+  [[nodiscard]] static std::filesystem::path
+  makeFileName(const VkPhysicalDeviceProperties& properties);
+
+  // checks the VkPipelineCacheHeaderVersionOne at the start of the data against the device
+  [[nodiscard]] static bool
+  isCompatible(std::span<const std::byte> data, const VkPhysicalDeviceProperties& properties);
+};
+} // namespace Vu
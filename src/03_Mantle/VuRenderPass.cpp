@@ -1,31 +1,114 @@
 #include "VuRenderPass.h"
 
+#include <array>
+
 void
-Vu::VuRenderPass::initAsGBufferPass(std::shared_ptr<VuDevice> vuDevice,
-                                    const VkFormat            colorFormat,
-                                    const VkFormat            normalFormat,
-                                    const VkFormat            aoRoughMetalFormat,
-                                    const VkFormat            worldPosFormat,
-                                    const VkFormat            depthStencilFormat) {
+Vu::VuRenderPass::initAsGBufferPass(std::shared_ptr<VuDevice>       vuDevice,
+                                    const std::span<const VkFormat> colorFormats,
+                                    const VkFormat                  depthStencilFormat,
+                                    const VkAttachmentStoreOp       depthStoreOp,
+                                    const VkAttachmentLoadOp        loadOp,
+                                    const bool                      depthPrepassed) {
   this->m_vuDevice                          = vuDevice;
   VkAttachmentDescription colorAttachment = {};
-  colorAttachment.format                  = colorFormat;
   colorAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
-  colorAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  colorAttachment.loadOp                  = loadOp;
   colorAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
   colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachment.finalLayout             = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  colorAttachment.initialLayout =
+      loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  std::vector<VkAttachmentDescription> attachments {};
+  std::vector<VkAttachmentReference>   colorRefs {};
+  for (const VkFormat format : colorFormats) {
+    colorAttachment.format = format;
+    colorRefs.push_back({static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+    attachments.push_back(colorAttachment);
+  }
+
+  VkAttachmentDescription depthAttachment = {};
+  depthAttachment.format                  = depthStencilFormat;
+  depthAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+  depthAttachment.loadOp                  = loadOp;
+  depthAttachment.storeOp                 = depthStoreOp;
+  depthAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  depthAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depthAttachment.initialLayout =
+      loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+  if (depthPrepassed) {
+    depthAttachment.loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  }
+  // stored depth is sampled by the lightning pass to reconstruct world position, otherwise it is transient
+  depthAttachment.finalLayout = depthStoreOp == VK_ATTACHMENT_STORE_OP_STORE
+                                    ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                                    : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  VkAttachmentReference depthRef = {.attachment = static_cast<uint32_t>(attachments.size()),
+                                    .layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+  attachments.push_back(depthAttachment);
+
+  VkSubpassDescription subpass    = {};
+  subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount    = static_cast<uint32_t>(colorRefs.size());
+  subpass.pColorAttachments       = colorRefs.data();
+  subpass.pDepthStencilAttachment = &depthRef;
+
+  std::array<VkSubpassDependency, 2> dependencies = {};
+  dependencies[0].srcSubpass                      = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass                      = 0;
+  dependencies[0].srcStageMask                    = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  dependencies[0].dstStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependencies[0].srcAccessMask = 0;
+  dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+    // the previous gbuffer pass wrote the attachments and the depth pyramid build read them in between
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                   VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dependencies[0].srcAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstAccessMask |=
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+  } else if (depthPrepassed) {
+    dependencies[0].srcStageMask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+  }
+
+  // make the attachment writes visible to the lightning pass fragment shader and the depth pyramid build
+  dependencies[1].srcSubpass = 0;
+  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[1].srcStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[1].dstStageMask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+  VkRenderPassCreateInfo renderPassInfo = {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+  renderPassInfo.attachmentCount        = static_cast<uint32_t>(attachments.size());
+  renderPassInfo.pAttachments           = attachments.data();
+  renderPassInfo.subpassCount           = 1;
+  renderPassInfo.pSubpasses             = &subpass;
+  renderPassInfo.dependencyCount        = static_cast<uint32_t>(dependencies.size());
+  renderPassInfo.pDependencies          = dependencies.data();
 
-  VkAttachmentDescription normalAttachment = colorAttachment;
-  normalAttachment.format                  = normalFormat;
+  VkResult rpRes = vkCreateRenderPass(this->m_vuDevice->m_device, &renderPassInfo, NO_ALLOC_CALLBACK, &this->m_renderPass);
+  THROW_if_fail(rpRes);
 
-  VkAttachmentDescription armAttachment = colorAttachment;
-  armAttachment.format                  = aoRoughMetalFormat;
+  m_colorBlendAttachmentStates.resize(colorFormats.size());
+  for (auto& blendAttachment : m_colorBlendAttachmentStates) {
+    blendAttachment.blendEnable = VK_FALSE; // No blending in GBuffer
+    blendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  }
+}
 
-  VkAttachmentDescription worldPosAttachment = colorAttachment;
-  worldPosAttachment.format                  = worldPosFormat;
+void
+Vu::VuRenderPass::initAsDepthPrepass(std::shared_ptr<VuDevice> vuDevice, const VkFormat depthStencilFormat) {
+  this->m_vuDevice = vuDevice;
 
   VkAttachmentDescription depthAttachment = {};
   depthAttachment.format                  = depthStencilFormat;
@@ -33,52 +116,50 @@ Vu::VuRenderPass::initAsGBufferPass(std::shared_ptr<VuDevice> vuDevice,
   depthAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
   depthAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
   depthAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-  depthAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_STORE;
+  depthAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   depthAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
   depthAttachment.finalLayout             = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
-  VkAttachmentDescription attachments[] = {
-      colorAttachment, normalAttachment, armAttachment, worldPosAttachment, depthAttachment};
-
-  VkAttachmentReference colorRefs[] = {{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-                                       {1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-                                       {2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
-                                       {3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL}};
-
-  VkAttachmentReference depthRef = {.attachment = 4, .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+  VkAttachmentReference depthRef = {.attachment = 0, .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
 
   VkSubpassDescription subpass    = {};
   subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-  subpass.colorAttachmentCount    = 4;
-  subpass.pColorAttachments       = colorRefs;
+  subpass.colorAttachmentCount    = 0;
   subpass.pDepthStencilAttachment = &depthRef;
 
-  VkSubpassDependency dependency = {};
-  dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
-  dependency.dstSubpass          = 0;
-  dependency.srcStageMask        = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-  dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-  dependency.srcAccessMask = 0;
-  dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-  dependency.dependencyFlags = 0;
+  std::array<VkSubpassDependency, 2> dependencies = {};
+  // the previous frame's gbuffer passes and depth pyramid build may still use the same depth image
+  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass = 0;
+  dependencies[0].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  dependencies[0].dstStageMask =
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+  // the gbuffer pass loads the depth and tests against it
+  dependencies[1].srcSubpass    = 0;
+  dependencies[1].dstSubpass    = VK_SUBPASS_EXTERNAL;
+  dependencies[1].srcStageMask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[1].dstStageMask =
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
 
   VkRenderPassCreateInfo renderPassInfo = {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
-  renderPassInfo.attachmentCount        = 5;
-  renderPassInfo.pAttachments           = attachments;
+  renderPassInfo.attachmentCount        = 1;
+  renderPassInfo.pAttachments           = &depthAttachment;
   renderPassInfo.subpassCount           = 1;
   renderPassInfo.pSubpasses             = &subpass;
-  renderPassInfo.dependencyCount        = 1;
-  renderPassInfo.pDependencies          = &dependency;
+  renderPassInfo.dependencyCount        = static_cast<uint32_t>(dependencies.size());
+  renderPassInfo.pDependencies          = dependencies.data();
 
   VkResult rpRes = vkCreateRenderPass(this->m_vuDevice->m_device, &renderPassInfo, NO_ALLOC_CALLBACK, &this->m_renderPass);
   THROW_if_fail(rpRes);
 
-  m_colorBlendAttachmentStates.resize(4);
-  for (auto& blendAttachment : m_colorBlendAttachmentStates) {
-    blendAttachment.blendEnable = VK_FALSE; // No blending in GBuffer
-    blendAttachment.colorWriteMask =
-        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-  }
+  // no color attachment, nothing to blend
+  m_colorBlendAttachmentStates.clear();
 }
 
 void
@@ -138,4 +219,126 @@ Vu::VuRenderPass::initAsLightningPass(std::shared_ptr<VuDevice> vuDevice, VkForm
     blendAttachment.colorWriteMask =
         VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
   }
-}
\ No newline at end of file
+}
+void
+Vu::VuRenderPass::initAsDeferredPass(std::shared_ptr<VuDevice>       vuDevice,
+                                     const std::span<const VkFormat> colorFormats,
+                                     const VkFormat                  depthStencilFormat,
+                                     const VkFormat                  presentFormat,
+                                     const std::span<const u32>      inputAttachments) {
+  this->m_vuDevice = vuDevice;
+
+  // gbuffer contents never leave the pass, on tilers they stay in tile memory
+  VkAttachmentDescription colorAttachment = {};
+  colorAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+  colorAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  colorAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+  colorAttachment.finalLayout             = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  std::vector<VkAttachmentDescription> attachments {};
+  std::vector<VkAttachmentReference>   colorRefs {};
+  for (const VkFormat format : colorFormats) {
+    colorAttachment.format = format;
+    colorRefs.push_back({static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+    attachments.push_back(colorAttachment);
+  }
+
+  VkAttachmentDescription depthAttachment = colorAttachment;
+  depthAttachment.format                  = depthStencilFormat;
+  depthAttachment.finalLayout             = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+  const VkAttachmentReference depthRef = {.attachment = static_cast<uint32_t>(attachments.size()),
+                                          .layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+  attachments.push_back(depthAttachment);
+
+  VkAttachmentDescription presentAttachment = colorAttachment;
+  presentAttachment.format                  = presentFormat;
+  presentAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+  presentAttachment.finalLayout             = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+  const VkAttachmentReference presentRef = {.attachment = static_cast<uint32_t>(attachments.size()),
+                                            .layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+  attachments.push_back(presentAttachment);
+
+  std::vector<VkAttachmentReference> inputRefs {};
+  for (const u32 attachment : inputAttachments) {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    if (attachment == depthRef.attachment) { layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL; }
+    inputRefs.push_back({attachment, layout});
+  }
+
+  std::array<VkSubpassDescription, 2> subpasses = {};
+  subpasses[0].pipelineBindPoint                = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpasses[0].colorAttachmentCount             = static_cast<uint32_t>(colorRefs.size());
+  subpasses[0].pColorAttachments                = colorRefs.data();
+  subpasses[0].pDepthStencilAttachment          = &depthRef;
+
+  subpasses[1].pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpasses[1].colorAttachmentCount = 1;
+  subpasses[1].pColorAttachments    = &presentRef;
+  subpasses[1].inputAttachmentCount = static_cast<uint32_t>(inputRefs.size());
+  subpasses[1].pInputAttachments    = inputRefs.data();
+
+  std::array<VkSubpassDependency, 3> dependencies = {};
+  dependencies[0].srcSubpass                      = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass                      = 0;
+  dependencies[0].srcStageMask                    = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+  dependencies[0].dstStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependencies[0].srcAccessMask = 0;
+  dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+  // the swapchain image acquire and the cluster light lists written by compute before the pass
+  dependencies[1].srcSubpass   = VK_SUBPASS_EXTERNAL;
+  dependencies[1].dstSubpass   = 1;
+  dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  dependencies[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  dependencies[1].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+  // lightning reads the gbuffer texel of its own pixel only
+  dependencies[2].srcSubpass = 0;
+  dependencies[2].dstSubpass = 1;
+  dependencies[2].srcStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[2].dstStageMask    = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  dependencies[2].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[2].dstAccessMask   = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+  dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+  VkRenderPassCreateInfo renderPassInfo = {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+  renderPassInfo.attachmentCount        = static_cast<uint32_t>(attachments.size());
+  renderPassInfo.pAttachments           = attachments.data();
+  renderPassInfo.subpassCount           = static_cast<uint32_t>(subpasses.size());
+  renderPassInfo.pSubpasses             = subpasses.data();
+  renderPassInfo.dependencyCount        = static_cast<uint32_t>(dependencies.size());
+  renderPassInfo.pDependencies          = dependencies.data();
+
+  VkResult rpRes = vkCreateRenderPass(this->m_vuDevice->m_device, &renderPassInfo, NO_ALLOC_CALLBACK, &this->m_renderPass);
+  THROW_if_fail(rpRes);
+
+  m_subpass = 0;
+  m_colorBlendAttachmentStates.resize(colorFormats.size());
+  for (auto& blendAttachment : m_colorBlendAttachmentStates) {
+    blendAttachment.blendEnable = VK_FALSE; // No blending in GBuffer
+    blendAttachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  }
+}
+
+void
+Vu::VuRenderPass::initAsSubpassOf(std::shared_ptr<VuRenderPass> owner, const u32 subpass) {
+  this->m_vuDevice   = owner->m_vuDevice;
+  this->m_renderPass = owner->m_renderPass;
+  this->m_subpass    = subpass;
+  this->m_owner      = std::move(owner);
+
+  VkPipelineColorBlendAttachmentState blendAttachment {};
+  blendAttachment.blendEnable = VK_FALSE;
+  blendAttachment.colorWriteMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  m_colorBlendAttachmentStates = {blendAttachment};
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <vector>
 
 #include "02_OuterCore/VuCommon.h"
@@ -10,18 +11,44 @@ struct VuRenderPass {
   std::shared_ptr<VuDevice>                        m_vuDevice {nullptr};
   VkRenderPass                                     m_renderPass {nullptr};
   std::vector<VkPipelineColorBlendAttachmentState> m_colorBlendAttachmentStates {};
+  // subpass the pipelines of this pass are built for
+  u32 m_subpass {};
+  // set on subpass views, the render pass belongs to it and is kept alive by it
+  std::shared_ptr<VuRenderPass> m_owner {};
 
+  // one color attachment per format, depth is the last attachment
+  // color ends up in SHADER_READ_ONLY_OPTIMAL for the lightning pass, depth too unless its store op is DONT_CARE
+  // LOAD continues a finished gbuffer pass, it expects color and stored depth in SHADER_READ_ONLY_OPTIMAL
+  // depthPrepassed clears color but loads the depth an initAsDepthPrepass pass left in DEPTH_STENCIL_ATTACHMENT_OPTIMAL
   void
   initAsGBufferPass(std::shared_ptr<VuDevice> vuDevice,
-                    VkFormat                  colorFormat,
-                    VkFormat                  normalFormat,
-                    VkFormat                  aoRoughMetalFormat,
-                    VkFormat                  worldPosFormat,
-                    VkFormat                  depthStencilFormat);
+                    std::span<const VkFormat> colorFormats,
+                    VkFormat                  depthStencilFormat,
+                    VkAttachmentStoreOp       depthStoreOp,
+                    VkAttachmentLoadOp        loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                    bool                      depthPrepassed = false);
+
+  // depth only, cleared and stored for the gbuffer pass that follows
+  void
+  initAsDepthPrepass(std::shared_ptr<VuDevice> vuDevice, VkFormat depthStencilFormat);
 
   void
   initAsLightningPass(std::shared_ptr<VuDevice> vuDevice, VkFormat colorFormat);
 
+  // gbuffer and lightning as two subpasses of one pass. subpass 0 writes the color attachments and depth, subpass 1
+  // writes the present attachment and reads inputAttachments through subpassLoad, in input_attachment_index order.
+  // attachments are the colors, depth, then the present image. only the present image is stored
+  void
+  initAsDeferredPass(std::shared_ptr<VuDevice> vuDevice,
+                     std::span<const VkFormat> colorFormats,
+                     VkFormat                  depthStencilFormat,
+                     VkFormat                  presentFormat,
+                     std::span<const u32>      inputAttachments);
+
+  // pipelines built against the view target the given subpass of the owner, which has a single color attachment
+  void
+  initAsSubpassOf(std::shared_ptr<VuRenderPass> owner, u32 subpass);
+
   //--------------------------------------------------------------------------------------------------------------------
   VuRenderPass(std::nullptr_t) {};
   VuRenderPass()                    = default;
@@ -32,7 +59,9 @@ struct VuRenderPass {
   VuRenderPass(VuRenderPass&& other) noexcept :
       m_vuDevice(std::move(other.m_vuDevice)),
       m_renderPass(other.m_renderPass),
-      m_colorBlendAttachmentStates(std::move(other.m_colorBlendAttachmentStates)) {
+      m_colorBlendAttachmentStates(std::move(other.m_colorBlendAttachmentStates)),
+      m_subpass(other.m_subpass),
+      m_owner(std::move(other.m_owner)) {
     other.m_renderPass = VK_NULL_HANDLE;
   }
 
@@ -43,6 +72,8 @@ struct VuRenderPass {
       m_vuDevice                   = std::move(other.m_vuDevice);
       m_renderPass                 = other.m_renderPass;
       m_colorBlendAttachmentStates = std::move(other.m_colorBlendAttachmentStates);
+      m_subpass                    = other.m_subpass;
+      m_owner                      = std::move(other.m_owner);
       other.m_renderPass           = VK_NULL_HANDLE;
     }
     return *this;
@@ -54,10 +85,11 @@ private:
   void
   cleanup() {
     if (m_renderPass != VK_NULL_HANDLE) {
-      vkDestroyRenderPass(m_vuDevice->m_device, m_renderPass, nullptr);
+      if (!m_owner) { vkDestroyRenderPass(m_vuDevice->m_device, m_renderPass, nullptr); }
       m_renderPass = VK_NULL_HANDLE;
       m_vuDevice.reset();
     }
+    m_owner.reset();
   }
   //--------------------------------------------------------------------------------------------------------------------
 };
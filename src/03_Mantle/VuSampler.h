@@ -56,6 +56,10 @@ struct VuSampler {
 private:
   void
   cleanup() {
+    if (m_bindlessIndex) {
+      m_vuDevice->releaseBindlessSlot(VuBindlessTable::Sampler, *m_bindlessIndex);
+      m_bindlessIndex = zero_optional<u32> {};
+    }
     if (m_sampler != VK_NULL_HANDLE) {
       vkDestroySampler(m_vuDevice->m_device, m_sampler, nullptr);
       m_sampler = VK_NULL_HANDLE;
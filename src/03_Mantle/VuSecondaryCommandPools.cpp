@@ -0,0 +1,112 @@
+#include "VuSecondaryCommandPools.h"
+
+#include <utility>
+
+#include "02_OuterCore/VuCommon.h"
+#include "VuDevice.h"
+
+namespace Vu {
+
+VuSecondaryCommandPools::VuSecondaryCommandPools(VuSecondaryCommandPools&& other) noexcept :
+    m_vuDevice(std::move(other.m_vuDevice)),
+    m_commandPools(std::move(other.m_commandPools)),
+    m_commandBuffers(std::move(other.m_commandBuffers)),
+    m_slotCount(other.m_slotCount) {
+  other.m_commandPools.clear();
+  other.m_commandBuffers.clear();
+  other.m_slotCount = 0;
+}
+
+VuSecondaryCommandPools&
+VuSecondaryCommandPools::operator=(VuSecondaryCommandPools&& other) noexcept {
+  if (this != &other) {
+    cleanup();
+    m_vuDevice       = std::move(other.m_vuDevice);
+    m_commandPools   = std::move(other.m_commandPools);
+    m_commandBuffers = std::move(other.m_commandBuffers);
+    m_slotCount      = other.m_slotCount;
+    other.m_commandPools.clear();
+    other.m_commandBuffers.clear();
+    other.m_slotCount = 0;
+  }
+  return *this;
+}
+
+VuSecondaryCommandPools::~VuSecondaryCommandPools() { cleanup(); }
+
+void
+VuSecondaryCommandPools::resetFrame(const u32 frameIndex) const {
+  for (u32 slot = 0; slot < m_slotCount; ++slot) {
+    THROW_if_fail(vkResetCommandPool(m_vuDevice->m_device, m_commandPools[frameIndex * m_slotCount + slot], ZERO_FLAG));
+  }
+}
+
+VkCommandBuffer
+VuSecondaryCommandPools::begin(const u32           frameIndex,
+                               const u32           slot,
+                               const VkRenderPass  renderPass,
+                               const VkFramebuffer framebuffer,
+                               const bool          occlusionQuery) const {
+  const VkCommandBuffer cb = m_commandBuffers[frameIndex * m_slotCount + slot];
+
+  VkCommandBufferInheritanceInfo inheritanceInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+  inheritanceInfo.renderPass  = renderPass;
+  inheritanceInfo.subpass     = 0;
+  inheritanceInfo.framebuffer = framebuffer;
+  if (occlusionQuery) {
+    inheritanceInfo.occlusionQueryEnable = VK_TRUE;
+    inheritanceInfo.queryFlags           = VK_QUERY_CONTROL_PRECISE_BIT;
+  }
+
+  VkCommandBufferBeginInfo beginInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  beginInfo.pInheritanceInfo = &inheritanceInfo;
+  THROW_if_fail(vkBeginCommandBuffer(cb, &beginInfo));
+  return cb;
+}
+
+u32
+VuSecondaryCommandPools::getSlotCount() const {
+  return m_slotCount;
+}
+
+void
+VuSecondaryCommandPools::cleanup() {
+  // destroying a pool frees its command buffers
+  for (VkCommandPool commandPool : m_commandPools) {
+    vkDestroyCommandPool(m_vuDevice->m_device, commandPool, NO_ALLOC_CALLBACK);
+  }
+  m_commandPools.clear();
+  m_commandBuffers.clear();
+  m_vuDevice.reset();
+}
+
+VuSecondaryCommandPools::VuSecondaryCommandPools(std::shared_ptr<VuDevice> vuDevice,
+                                                 const u32                 queueFamilyIndex,
+                                                 const u32                 frameCount,
+                                                 const u32                 slotCount) :
+    m_vuDevice(vuDevice),
+    m_slotCount(slotCount) {
+  m_commandPools.reserve(frameCount * slotCount);
+  m_commandBuffers.reserve(frameCount * slotCount);
+  for (u32 i = 0; i < frameCount * slotCount; ++i) {
+    // pools are reset as a whole every frame, buffers are never reset one by one
+    VkCommandPoolCreateInfo poolInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+    VkCommandPool commandPool {};
+    THROW_if_fail(vkCreateCommandPool(vuDevice->m_device, &poolInfo, NO_ALLOC_CALLBACK, &commandPool));
+    m_commandPools.push_back(commandPool);
+
+    VkCommandBufferAllocateInfo allocInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocInfo.commandPool        = commandPool;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer {};
+    THROW_if_fail(vkAllocateCommandBuffers(vuDevice->m_device, &allocInfo, &commandBuffer));
+    m_commandBuffers.push_back(commandBuffer);
+  }
+}
+} // namespace Vu
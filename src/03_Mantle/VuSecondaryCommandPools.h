@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+
+#include "02_OuterCore/VuCommon.h"
+
+namespace Vu {
+struct VuDevice;
+
+// One command pool with one secondary command buffer per recording slot and frame in flight. A slot belongs to a
+// single thread while it records, so no pool is ever touched from two threads at once.
+struct VuSecondaryCommandPools {
+  std::shared_ptr<VuDevice> m_vuDevice {nullptr};
+  // indexed by frameIndex * m_slotCount + slot
+  std::vector<VkCommandPool>   m_commandPools {};
+  std::vector<VkCommandBuffer> m_commandBuffers {};
+  u32                          m_slotCount {};
+
+  SETUP_EXPECTED_WRAPPER(VuSecondaryCommandPools,
+                         (std::shared_ptr<VuDevice> vuDevice, u32 queueFamilyIndex, u32 frameCount, u32 slotCount),
+                         (vuDevice, queueFamilyIndex, frameCount, slotCount))
+public:
+  VuSecondaryCommandPools() = default;
+
+  VuSecondaryCommandPools(const VuSecondaryCommandPools&) = delete;
+
+  VuSecondaryCommandPools&
+  operator=(const VuSecondaryCommandPools&) = delete;
+
+  VuSecondaryCommandPools(VuSecondaryCommandPools&& other) noexcept;
+
+  VuSecondaryCommandPools&
+  operator=(VuSecondaryCommandPools&& other) noexcept;
+
+  ~VuSecondaryCommandPools();
+
+  // the frame's previous submission must have completed
+  void
+  resetFrame(u32 frameIndex) const;
+
+  // begins the slot's buffer as a continuation of subpass 0 of renderPass, nothing is inherited but the pass and, when
+  // the primary has one active, a precise occlusion query
+  [[nodiscard]] VkCommandBuffer
+  begin(u32           frameIndex,
+        u32           slot,
+        VkRenderPass  renderPass,
+        VkFramebuffer framebuffer,
+        bool          occlusionQuery = false) const;
+
+  [[nodiscard]] u32
+  getSlotCount() const;
+
+private:
+  void
+  cleanup();
+
+  VuSecondaryCommandPools(std::shared_ptr<VuDevice> vuDevice, u32 queueFamilyIndex, u32 frameCount, u32 slotCount);
+};
+} // namespace Vu
@@ -1,21 +1,44 @@
 #include "VuSwapChain.h"
 
+#include <algorithm>
+#include <array>
+
+#include "01_InnerCore/VuLogger.h"
 #include "VuDevice.h"
 #include "VuPhysicalDevice.h"
 #include "VuSurface.h"
 
 namespace Vu {
-VuSwapChain::VuSwapChain(std::shared_ptr<VuDevice> vuDevice, std::shared_ptr<VuSurface> surface) :
+
+const char*
+toString(const VkPresentModeKHR presentMode) {
+  switch (presentMode) {
+  case VK_PRESENT_MODE_IMMEDIATE_KHR: return "Immediate";
+  case VK_PRESENT_MODE_MAILBOX_KHR: return "Mailbox";
+  case VK_PRESENT_MODE_FIFO_KHR: return "Fifo";
+  case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FifoRelaxed";
+  default: break;
+  }
+  return "Unknown";
+}
+
+VuSwapChain::VuSwapChain(std::shared_ptr<VuDevice>    vuDevice,
+                         std::shared_ptr<VuSurface>   surface,
+                         const VuSwapChainCreateInfo& createInfo) :
     m_vuDevice {std::move(vuDevice)},
     m_vuSurface{std::move(surface)} {
 
   auto& physicalDevice = m_vuDevice->m_vuPhysicalDevice;
 
-  const auto& [capabilities, formats, presentModes] = physicalDevice->m_swapChainSupport;
+  // queried again, the capabilities taken at device selection are stale after a resize
+  const VuSwapChainSupportDetails support =
+      move_or_THROW(VuSwapChainSupportDetails::make(physicalDevice->m_physicalDevice, m_vuSurface->m_surface));
+
+  const auto& [capabilities, formats, presentModes] = support;
   VkExtent2D         extend                         = chooseSwapExtent(capabilities);
   VkSurfaceFormatKHR surfaceFormat                  = chooseSwapSurfaceFormat(formats);
-  VkPresentModeKHR   presentMode                    = chooseSwapPresentMode(presentModes);
-  uint32_t           minImageCount                     = capabilities.minImageCount;
+  VkPresentModeKHR   presentMode                    = chooseSwapPresentMode(presentModes, createInfo.presentMode);
+  uint32_t           minImageCount                  = chooseImageCount(capabilities, createInfo.imageCount);
 
   VkSwapchainCreateInfoKHR swapChainCreateInfo {};
   swapChainCreateInfo.sType            = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -59,6 +82,8 @@ VuSwapChain::VuSwapChain(std::shared_ptr<VuDevice> vuDevice, std::shared_ptr<VuS
 
   m_imageFormat = surfaceFormat.format;
   m_extend2D    = extend;
+  m_presentMode = presentMode;
+  Logger::Info("Swapchain: {} images, present mode {}", m_images.size(), toString(presentMode));
 
   {
     m_imageViews.resize(m_images.size());
@@ -97,17 +122,31 @@ VuSwapChain::chooseSwapSurfaceFormat(std::span<const VkSurfaceFormatKHR> availab
   return availableFormats[0];
 }
 VkPresentModeKHR
-VuSwapChain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-  // TODO present mode
-  //  for (const auto& availablePresentMode: availablePresentModes) {
-  //      if (availablePresentMode == VK_PRESENT_MODE_FIFO_KHR) {
-  //          return availablePresentMode;
-  //      }
-  //  }
-  return VK_PRESENT_MODE_IMMEDIATE_KHR;
-  return VK_PRESENT_MODE_MAILBOX_KHR;
+VuSwapChain::chooseSwapPresentMode(std::span<const VkPresentModeKHR> availablePresentModes,
+                                   const VkPresentModeKHR            preferred) {
+  std::array<VkPresentModeKHR, 3> candidates {preferred, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR};
+  if (preferred == VK_PRESENT_MODE_IMMEDIATE_KHR) { candidates[1] = VK_PRESENT_MODE_MAILBOX_KHR; }
+
+  for (VkPresentModeKHR candidate : candidates) {
+    if (std::ranges::find(availablePresentModes, candidate) != availablePresentModes.end()) {
+      if (candidate != preferred) {
+        Logger::Warn("Present mode {} is not supported, using {}", toString(preferred), toString(candidate));
+      }
+      return candidate;
+    }
+  }
+  // the spec requires FIFO, only reached with a broken mode list
   return VK_PRESENT_MODE_FIFO_KHR;
 }
+u32
+VuSwapChain::chooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities, const u32 requested) {
+  // one image over the minimum lets the cpu acquire the next image while the compositor holds one
+  u32 count = requested == 0 ? capabilities.minImageCount + 1 : requested;
+  count     = std::max(count, capabilities.minImageCount);
+  // zero means no limit
+  if (capabilities.maxImageCount != 0) { count = std::min(count, capabilities.maxImageCount); }
+  return count;
+}
 VkExtent2D
 VuSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
   if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) { return capabilities.currentExtent; }
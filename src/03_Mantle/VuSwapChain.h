@@ -1,4 +1,5 @@
 #pragma once
+#include <span>
 #include <vector>
 
 #include "02_OuterCore/VuCommon.h"
@@ -8,6 +9,17 @@ namespace Vu {
 struct VuDevice;
 struct VuSurface;
 
+const char*
+toString(VkPresentModeKHR presentMode);
+
+struct VuSwapChainCreateInfo {
+  // falls back to the closest supported mode, FIFO is always available
+  VkPresentModeKHR presentMode {VK_PRESENT_MODE_IMMEDIATE_KHR};
+  // 0 asks for one image more than the surface minimum, clamped to the surface limits
+  u32 imageCount {0};
+};
+// #####################################################################################################################
+
 struct VuSwapChain {
   std::shared_ptr<VuDevice>  m_vuDevice {nullptr};
   std::shared_ptr<VuSurface> m_vuSurface {nullptr};
@@ -16,12 +28,17 @@ struct VuSwapChain {
   std::vector<VkImageView>   m_imageViews {};
   VkFormat                   m_imageFormat {};
   VkExtent2D                 m_extend2D {};
+  VkPresentModeKHR           m_presentMode {};
 
   static VkSurfaceFormatKHR
   chooseSwapSurfaceFormat(std::span<const VkSurfaceFormatKHR> availableFormats);
 
+  // IMMEDIATE falls back to MAILBOX, then FIFO, MAILBOX falls back to FIFO so it never tears
   static VkPresentModeKHR
-  chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+  chooseSwapPresentMode(std::span<const VkPresentModeKHR> availablePresentModes, VkPresentModeKHR preferred);
+
+  [[nodiscard]] static u32
+  chooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities, u32 requested);
 
   [[nodiscard]] static VkExtent2D
   chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
@@ -39,7 +56,8 @@ struct VuSwapChain {
       m_images(std::move(other.m_images)),
       m_imageViews(std::move(other.m_imageViews)),
       m_imageFormat(other.m_imageFormat),
-      m_extend2D(other.m_extend2D) {
+      m_extend2D(other.m_extend2D),
+      m_presentMode(other.m_presentMode) {
     other.m_swapchain = VK_NULL_HANDLE;
   }
 
@@ -54,6 +72,7 @@ struct VuSwapChain {
       m_imageViews  = std::move(other.m_imageViews);
       m_imageFormat = other.m_imageFormat;
       m_extend2D    = other.m_extend2D;
+      m_presentMode = other.m_presentMode;
 
       other.m_swapchain = VK_NULL_HANDLE;
     }
@@ -63,8 +82,10 @@ struct VuSwapChain {
   ~VuSwapChain() { cleanup(); }
 
   SETUP_EXPECTED_WRAPPER(VuSwapChain,
-                         (std::shared_ptr<VuDevice> vuDevice, std::shared_ptr<VuSurface> surface),
-                         (vuDevice, surface))
+                         (std::shared_ptr<VuDevice>    vuDevice,
+                          std::shared_ptr<VuSurface>   surface,
+                          const VuSwapChainCreateInfo& createInfo),
+                         (vuDevice, surface, createInfo))
 private:
   void
   cleanup() {
@@ -85,7 +106,9 @@ private:
   //--------------------------------------------------------------------------------------------------------------------
 
 private:
-  VuSwapChain(std::shared_ptr<VuDevice> vuDevice, std::shared_ptr<VuSurface> surface);
+  VuSwapChain(std::shared_ptr<VuDevice>    vuDevice,
+              std::shared_ptr<VuSurface>   surface,
+              const VuSwapChainCreateInfo& createInfo);
 };
 
 } // namespace Vu
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "VuTimeline.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Vu {
+
+VuTimeline::VuTimeline(VkDevice device) : m_device(device) {
+  VkSemaphoreTypeCreateInfo typeInfo {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue  = 0;
+
+  VkSemaphoreCreateInfo createInfo {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+  createInfo.pNext = &typeInfo;
+  THROW_if_fail(vkCreateSemaphore(m_device, &createInfo, NO_ALLOC_CALLBACK, &m_semaphore));
+}
+
+VuTimeline::~VuTimeline() {
+  if (m_semaphore == VK_NULL_HANDLE) { return; }
+  waitIdle();
+  vkDestroySemaphore(m_device, m_semaphore, NO_ALLOC_CALLBACK);
+}
+
+u64
+VuTimeline::nextValue() {
+  return ++m_lastSubmittedValue;
+}
+
+u64
+VuTimeline::getLastSubmittedValue() const {
+  return m_lastSubmittedValue;
+}
+
+u64
+VuTimeline::getCompletedValue() {
+  u64 value {};
+  THROW_if_fail(vkGetSemaphoreCounterValue(m_device, m_semaphore, &value));
+  m_completedValue = std::max(m_completedValue, value);
+  return m_completedValue;
+}
+
+bool
+VuTimeline::isComplete(const u64 value) {
+  if (value <= m_completedValue) { return true; }
+  return value <= getCompletedValue();
+}
+
+void
+VuTimeline::waitFor(const u64 value) {
+  if (isComplete(value)) { return; }
+
+  VkSemaphoreWaitInfo waitInfo {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores    = &m_semaphore;
+  waitInfo.pValues        = &value;
+  THROW_if_fail(vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX));
+  m_completedValue = std::max(m_completedValue, value);
+}
+
+void
+VuTimeline::onComplete(const u64 value, std::function<void()> callback) {
+  if (isComplete(value)) {
+    callback();
+    return;
+  }
+  m_callbacks.emplace(value, std::move(callback));
+}
+
+void
+VuTimeline::poll() {
+  if (m_callbacks.empty()) { return; }
+  const u64 completed = getCompletedValue();
+  // a callback may register new ones, take the due entries out before running any of them
+  auto                               end = m_callbacks.upper_bound(completed);
+  std::vector<std::function<void()>> due {};
+  for (auto it = m_callbacks.begin(); it != end; ++it) {
+    due.push_back(std::move(it->second));
+  }
+  m_callbacks.erase(m_callbacks.begin(), end);
+  for (std::function<void()>& callback : due) {
+    callback();
+  }
+}
+
+void
+VuTimeline::waitIdle() {
+  waitFor(m_lastSubmittedValue);
+  poll();
+}
+} // namespace Vu
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <map>
+
+#include "01_InnerCore/TypeDefs.h"
+#include "02_OuterCore/VuCommon.h"
+
+namespace Vu {
+
+// #####################################################################################################################
+// Device-wide timeline semaphore. Every tracked submit signals the next value on the graphics queue, so values
+// complete in the order they were handed out and a single counter tells whether frames, uploads or readbacks are done.
+// Only used from the render thread.
+struct VuTimeline {
+private:
+  VkDevice m_device {nullptr};
+  u64      m_lastSubmittedValue {};
+  // last value read back from the semaphore, completion never goes backwards so it is safe to cache
+  u64                                       m_completedValue {};
+  std::multimap<u64, std::function<void()>> m_callbacks {};
+
+public:
+  VkSemaphore m_semaphore {nullptr};
+
+  explicit VuTimeline(VkDevice device);
+
+  VuTimeline(const VuTimeline&) = delete;
+  VuTimeline&
+  operator=(const VuTimeline&) = delete;
+
+  ~VuTimeline();
+
+  // value the caller's next submit has to signal, submits must happen in the order values were taken
+  [[nodiscard]] u64
+  nextValue();
+
+  [[nodiscard]] u64
+  getLastSubmittedValue() const;
+
+  // queries the semaphore, never blocks
+  [[nodiscard]] u64
+  getCompletedValue();
+
+  // zero is always complete
+  [[nodiscard]] bool
+  isComplete(u64 value);
+
+  // blocks until value is reached, does not run callbacks
+  void
+  waitFor(u64 value);
+
+  // runs callback right away when value is already complete, otherwise from the first poll that sees it complete
+  void
+  onComplete(u64 value, std::function<void()> callback);
+
+  // runs the callbacks of completed values in value order
+  void
+  poll();
+
+  // waits for everything submitted so far and runs every callback
+  void
+  waitIdle();
+};
+} // namespace Vu
@@ -12,6 +12,15 @@
 namespace Vu {
 using VuName = FixedString64;
 
+// tables of the global descriptor set a resource can hold a slot in
+enum class VuBindlessTable {
+  SampledImage,
+  Sampler,
+  StorageBuffer,
+};
+
+using VuBindlessSlotReleaser = std::function<void(VuBindlessTable table, u32 index)>;
+
 // struct GPU_Mesh {
 //   u32 vertexBufferHandle = {};
 //   u32 vertexCount        = {};
@@ -0,0 +1,386 @@
+#include "VuUploadContext.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "01_InnerCore/VuLogger.h"
+#include "02_OuterCore/VuCommon.h"
+#include "VuDevice.h"
+#include "VuImage.h"
+#include "VuPhysicalDevice.h"
+#include "VuSync.h"
+
+namespace Vu {
+
+VuUploadContext::VuUploadContext(const std::shared_ptr<VuDevice>& vuDevice, const VuUploadContextCreateInfo& createInfo) :
+    m_vuDevice {vuDevice},
+    m_ringAllocator {createInfo.ringSizeInBytes},
+    m_queue {vuDevice->m_transferQueue},
+    m_transferFamily {vuDevice->m_vuPhysicalDevice->m_indices.transferFamily},
+    m_graphicsFamily {vuDevice->m_vuPhysicalDevice->m_indices.graphicsFamily} {
+
+  const VkPhysicalDeviceLimits& limits = vuDevice->m_vuPhysicalDevice->m_properties.limits;
+  m_copyOffsetAlignment = std::max<VkDeviceSize>(m_copyOffsetAlignment, limits.optimalBufferCopyOffsetAlignment);
+
+  VuBufferCreateInfo ringCreateInfo {};
+  ringCreateInfo.name         = "UploadRing";
+  ringCreateInfo.sizeInBytes  = createInfo.ringSizeInBytes;
+  ringCreateInfo.vkUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  ringCreateInfo.memoryUsage  = VuMemoryUsage::Upload;
+
+  m_ringBuffer = move_or_THROW(VuBuffer::make(vuDevice, ringCreateInfo));
+  THROW_if_fail(m_ringBuffer.map());
+
+  VkCommandPoolCreateInfo poolInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+  poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  poolInfo.queueFamilyIndex = m_transferFamily;
+  THROW_if_fail(vkCreateCommandPool(vuDevice->m_device, &poolInfo, NO_ALLOC_CALLBACK, &m_commandPool));
+
+  if (usesDedicatedTransferQueue()) {
+    poolInfo.queueFamilyIndex = m_graphicsFamily;
+    THROW_if_fail(vkCreateCommandPool(vuDevice->m_device, &poolInfo, NO_ALLOC_CALLBACK, &m_acquireCommandPool));
+    Logger::Info("Uploads use dedicated transfer queue family {}", m_transferFamily);
+  } else {
+    Logger::Info("No dedicated transfer queue family, uploads use the graphics queue");
+  }
+
+  m_batches.resize(createInfo.batchCount);
+  for (VuUploadBatch& batch : m_batches) {
+    VkCommandBufferAllocateInfo allocInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocInfo.commandPool        = m_commandPool;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    THROW_if_fail(vkAllocateCommandBuffers(vuDevice->m_device, &allocInfo, &batch.m_commandBuffer));
+
+    if (usesDedicatedTransferQueue()) {
+      allocInfo.commandPool = m_acquireCommandPool;
+      THROW_if_fail(vkAllocateCommandBuffers(vuDevice->m_device, &allocInfo, &batch.m_acquireCommandBuffer));
+
+      VkSemaphoreCreateInfo semaphoreInfo {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+      THROW_if_fail(
+          vkCreateSemaphore(vuDevice->m_device, &semaphoreInfo, NO_ALLOC_CALLBACK, &batch.m_transferDoneSemaphore));
+    }
+  }
+}
+
+void
+VuUploadContext::cleanup() {
+  if (m_commandPool != VK_NULL_HANDLE) {
+    waitIdle();
+    for (VuUploadBatch& batch : m_batches) {
+      if (batch.m_transferDoneSemaphore != VK_NULL_HANDLE) {
+        vkDestroySemaphore(m_vuDevice->m_device, batch.m_transferDoneSemaphore, NO_ALLOC_CALLBACK);
+      }
+    }
+    m_batches.clear();
+    vkDestroyCommandPool(m_vuDevice->m_device, m_commandPool, NO_ALLOC_CALLBACK);
+    m_commandPool = VK_NULL_HANDLE;
+  }
+  if (m_acquireCommandPool != VK_NULL_HANDLE) {
+    vkDestroyCommandPool(m_vuDevice->m_device, m_acquireCommandPool, NO_ALLOC_CALLBACK);
+    m_acquireCommandPool = VK_NULL_HANDLE;
+  }
+  m_ringBuffer = VuBuffer {};
+  m_vuDevice.reset();
+}
+
+bool
+VuUploadContext::usesDedicatedTransferQueue() const {
+  return m_transferFamily != m_graphicsFamily;
+}
+
+void
+VuUploadContext::uploadToImage(const VuImage& vuImage, const void* data, const VkDeviceSize size) {
+  RingAllocation allocation = stage(data, size);
+  VuUploadBatch& batch      = getRecordingBatch();
+  batch.m_consumedBytes += allocation.consumed;
+
+  VkImageSubresourceRange range {};
+  range.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  range.baseMipLevel   = 0;
+  range.levelCount     = 1;
+  range.baseArrayLayer = 0;
+  range.layerCount     = 1;
+
+  InsertImageMemoryBarrier(batch.m_commandBuffer,
+                           vuImage.m_image,
+                           0,
+                           VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_IMAGE_LAYOUT_UNDEFINED,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           range);
+
+  VkBufferImageCopy region {};
+  region.bufferOffset                    = allocation.offset;
+  region.bufferRowLength                 = 0;
+  region.bufferImageHeight               = 0;
+  region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel       = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount     = 1;
+  region.imageOffset                     = VkOffset3D {0, 0, 0};
+  region.imageExtent = VkExtent3D {vuImage.m_lastCreateInfo.width, vuImage.m_lastCreateInfo.height, 1};
+
+  vkCmdCopyBufferToImage(batch.m_commandBuffer,
+                         m_ringBuffer.m_buffer,
+                         vuImage.m_image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         1,
+                         &region);
+
+  if (!usesDedicatedTransferQueue()) {
+    InsertImageMemoryBarrier(batch.m_commandBuffer,
+                             vuImage.m_image,
+                             VK_ACCESS_TRANSFER_WRITE_BIT,
+                             VK_ACCESS_SHADER_READ_BIT,
+                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             range);
+  } else {
+    // release on the transfer queue, acquire on the graphics queue, both barriers must describe the same transition
+    VkImageMemoryBarrier handover = ImageMemoryBarrier();
+    handover.srcQueueFamilyIndex  = m_transferFamily;
+    handover.dstQueueFamilyIndex  = m_graphicsFamily;
+    handover.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    handover.newLayout            = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    handover.image                = vuImage.m_image;
+    handover.subresourceRange     = range;
+
+    handover.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    handover.dstAccessMask = 0;
+    vkCmdPipelineBarrier(batch.m_commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         ZERO_FLAG,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &handover);
+
+    handover.srcAccessMask = 0;
+    handover.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(batch.m_acquireCommandBuffer,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         ZERO_FLAG,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &handover);
+  }
+  ++batch.m_copyCount;
+}
+
+void
+VuUploadContext::uploadToBuffer(const VuBuffer& dstBuffer, const void* data, const VkDeviceSize size) {
+  // the handover releases the whole buffer from the transfer family, so only first uploads are allowed here
+  assert(size <= dstBuffer.m_sizeInBytes);
+  RingAllocation allocation = stage(data, size);
+  VuUploadBatch& batch      = getRecordingBatch();
+  batch.m_consumedBytes += allocation.consumed;
+
+  VkBufferCopy copyRegion {};
+  copyRegion.srcOffset = allocation.offset;
+  copyRegion.dstOffset = 0;
+  copyRegion.size      = size;
+  vkCmdCopyBuffer(batch.m_commandBuffer, m_ringBuffer.m_buffer, dstBuffer.m_buffer, 1, &copyRegion);
+
+  recordBufferHandover(batch, dstBuffer.m_buffer);
+  ++batch.m_copyCount;
+}
+
+void
+VuUploadContext::recordBufferHandover(VuUploadBatch& batch, VkBuffer buffer) const {
+  if (!usesDedicatedTransferQueue()) {
+    // a single barrier at flush covers every buffer copy of the batch
+    batch.m_hasBufferCopies = true;
+    return;
+  }
+  VkBufferMemoryBarrier handover {.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+  handover.srcQueueFamilyIndex = m_transferFamily;
+  handover.dstQueueFamilyIndex = m_graphicsFamily;
+  handover.buffer              = buffer;
+  handover.offset              = 0;
+  handover.size                = VK_WHOLE_SIZE;
+
+  handover.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  handover.dstAccessMask = 0;
+  vkCmdPipelineBarrier(batch.m_commandBuffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       ZERO_FLAG,
+                       0,
+                       nullptr,
+                       1,
+                       &handover,
+                       0,
+                       nullptr);
+
+  handover.srcAccessMask = 0;
+  handover.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+  vkCmdPipelineBarrier(batch.m_acquireCommandBuffer,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       ZERO_FLAG,
+                       0,
+                       nullptr,
+                       1,
+                       &handover,
+                       0,
+                       nullptr);
+}
+
+void
+VuUploadContext::flush() {
+  VuUploadBatch& batch = m_batches[m_recordingBatch];
+  if (!batch.m_isRecording) { return; }
+
+  if (batch.m_hasBufferCopies) {
+    // one barrier for every buffer copy in the batch, buffers have no layout to care about
+    VkMemoryBarrier memoryBarrier {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    vkCmdPipelineBarrier(batch.m_commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         ZERO_FLAG,
+                         1,
+                         &memoryBarrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+  }
+  THROW_if_fail(vkEndCommandBuffer(batch.m_commandBuffer));
+
+  VuTimeline& timeline  = *m_vuDevice->m_timeline;
+  batch.m_timelineValue = timeline.nextValue();
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo {.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues    = &batch.m_timelineValue;
+
+  VkSubmitInfo submitInfo {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers    = &batch.m_commandBuffer;
+
+  if (!usesDedicatedTransferQueue()) {
+    // m_queue is the graphics queue here
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &timeline.m_semaphore;
+    THROW_if_fail(vkQueueSubmit(m_queue, 1, &submitInfo, VK_NULL_HANDLE));
+  } else {
+    THROW_if_fail(vkEndCommandBuffer(batch.m_acquireCommandBuffer));
+
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &batch.m_transferDoneSemaphore;
+    THROW_if_fail(vkQueueSubmit(m_queue, 1, &submitInfo, VK_NULL_HANDLE));
+
+    // graphics work submitted after this is ordered behind the acquire barriers,
+    // and the acquire waits for the copies, so its timeline value covers the whole batch
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSubmitInfo         acquireSubmitInfo {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    acquireSubmitInfo.pNext                = &timelineInfo;
+    acquireSubmitInfo.waitSemaphoreCount   = 1;
+    acquireSubmitInfo.pWaitSemaphores      = &batch.m_transferDoneSemaphore;
+    acquireSubmitInfo.pWaitDstStageMask    = &waitStage;
+    acquireSubmitInfo.commandBufferCount   = 1;
+    acquireSubmitInfo.pCommandBuffers      = &batch.m_acquireCommandBuffer;
+    acquireSubmitInfo.signalSemaphoreCount = 1;
+    acquireSubmitInfo.pSignalSemaphores    = &timeline.m_semaphore;
+    THROW_if_fail(vkQueueSubmit(m_vuDevice->m_graphicsQueue, 1, &acquireSubmitInfo, VK_NULL_HANDLE));
+  }
+
+  batch.m_isRecording = false;
+  batch.m_isInFlight  = true;
+  m_inFlightBatches.push_back(m_recordingBatch);
+  m_recordingBatch = (m_recordingBatch + 1) % static_cast<u32>(m_batches.size());
+}
+
+void
+VuUploadContext::collect() {
+  while (!m_inFlightBatches.empty()) {
+    const VuUploadBatch& oldest = m_batches[m_inFlightBatches.front()];
+    if (!m_vuDevice->m_timeline->isComplete(oldest.m_timelineValue)) { return; }
+    retireOldestBatch();
+  }
+}
+
+void
+VuUploadContext::waitIdle() {
+  while (!m_inFlightBatches.empty()) {
+    waitOldestBatch();
+  }
+}
+
+RingAllocation
+VuUploadContext::stage(const void* data, const VkDeviceSize size) {
+  if (size > m_ringAllocator.getCapacity()) {
+    throw std::runtime_error("VuUploadContext: upload is larger than the staging ring");
+  }
+  while (true) {
+    if (auto allocation = m_ringAllocator.allocate(size, m_copyOffsetAlignment)) {
+      std::memcpy(static_cast<byte*>(m_ringBuffer.m_mapPtr) + allocation->offset, data, size);
+      return allocation.value();
+    }
+    // ring is full, submit what we have and wait for the oldest batch to give its space back
+    flush();
+    if (m_inFlightBatches.empty()) { throw std::runtime_error("VuUploadContext: staging ring exhausted"); }
+    waitOldestBatch();
+  }
+}
+
+VuUploadBatch&
+VuUploadContext::getRecordingBatch() {
+  VuUploadBatch& batch = m_batches[m_recordingBatch];
+  if (batch.m_isRecording) { return batch; }
+
+  // batches are used round-robin, so waiting on the oldest ones eventually frees this one
+  while (batch.m_isInFlight) {
+    waitOldestBatch();
+  }
+
+  VkCommandBufferBeginInfo beginInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  THROW_if_fail(vkResetCommandBuffer(batch.m_commandBuffer, ZERO_FLAG));
+  THROW_if_fail(vkBeginCommandBuffer(batch.m_commandBuffer, &beginInfo));
+  if (usesDedicatedTransferQueue()) {
+    THROW_if_fail(vkResetCommandBuffer(batch.m_acquireCommandBuffer, ZERO_FLAG));
+    THROW_if_fail(vkBeginCommandBuffer(batch.m_acquireCommandBuffer, &beginInfo));
+  }
+
+  batch.m_consumedBytes   = 0;
+  batch.m_copyCount       = 0;
+  batch.m_hasBufferCopies = false;
+  batch.m_isRecording     = true;
+  return batch;
+}
+
+void
+VuUploadContext::waitOldestBatch() {
+  const VuUploadBatch& oldest = m_batches[m_inFlightBatches.front()];
+  m_vuDevice->m_timeline->waitFor(oldest.m_timelineValue);
+  retireOldestBatch();
+}
+
+void
+VuUploadContext::retireOldestBatch() {
+  VuUploadBatch& oldest = m_batches[m_inFlightBatches.front()];
+  m_ringAllocator.release(oldest.m_consumedBytes);
+  oldest.m_consumedBytes = 0;
+  oldest.m_isInFlight    = false;
+  m_inFlightBatches.pop_front();
+}
+} // namespace Vu
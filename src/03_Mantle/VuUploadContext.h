@@ -0,0 +1,153 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "01_InnerCore/RingAllocator.h"
+#include "01_InnerCore/TypeDefs.h"
+#include "02_OuterCore/VuCommon.h"
+#include "VuBuffer.h"
+#include "VuDevice.h"
+
+namespace Vu {
+struct VuImage;
+
+struct VuUploadContextCreateInfo {
+  VkDeviceSize ringSizeInBytes = {1024 * 1024 * 64};
+  u32          batchCount      = {4};
+};
+
+// one command buffer worth of recorded copies, recycled when the device timeline reaches its value
+struct VuUploadBatch {
+  VkCommandBuffer m_commandBuffer {nullptr};
+  // only used with a dedicated transfer queue, acquires ownership on the graphics queue
+  VkCommandBuffer m_acquireCommandBuffer {nullptr};
+  VkSemaphore     m_transferDoneSemaphore {nullptr};
+  // signaled on the graphics queue once the copies (and acquires) of the batch completed
+  u64             m_timelineValue {};
+  u64             m_consumedBytes {};
+  u32             m_copyCount {};
+  bool            m_hasBufferCopies {};
+  bool            m_isRecording {};
+  bool            m_isInFlight {};
+};
+// #####################################################################################################################
+// Batches many staging copies into a single submit.
+// Source data is copied into a persistently mapped ring right away, so callers can free it after the call returns.
+// Ring space is given back when the device timeline reaches the value of the batch that used it.
+// When the device has a dedicated transfer family, copies run there and resources are handed over to the graphics
+// family with release/acquire barriers, ordered by a semaphore. The timeline is signaled by the acquire submit then, so
+// every value still comes from the graphics queue.
+struct VuUploadContext {
+  std::shared_ptr<VuDevice>  m_vuDevice {nullptr};
+  VuBuffer                   m_ringBuffer {};
+  RingAllocator              m_ringAllocator {};
+  VkCommandPool              m_commandPool {nullptr};
+  VkCommandPool              m_acquireCommandPool {nullptr};
+  VkQueue                    m_queue {nullptr};
+  u32                        m_transferFamily {};
+  u32                        m_graphicsFamily {};
+  std::vector<VuUploadBatch> m_batches {};
+  std::deque<u32>            m_inFlightBatches {};
+  u32                        m_recordingBatch {};
+  VkDeviceSize               m_copyOffsetAlignment {16};
+
+  //--------------------------------------------------------------------------------------------------------------------
+  VuUploadContext()                       = default;
+  VuUploadContext(const VuUploadContext&) = delete;
+  VuUploadContext&
+  operator=(const VuUploadContext&) = delete;
+
+  VuUploadContext(VuUploadContext&& other) noexcept :
+      m_vuDevice(std::move(other.m_vuDevice)),
+      m_ringBuffer(std::move(other.m_ringBuffer)),
+      m_ringAllocator(other.m_ringAllocator),
+      m_commandPool(other.m_commandPool),
+      m_acquireCommandPool(other.m_acquireCommandPool),
+      m_queue(other.m_queue),
+      m_transferFamily(other.m_transferFamily),
+      m_graphicsFamily(other.m_graphicsFamily),
+      m_batches(std::move(other.m_batches)),
+      m_inFlightBatches(std::move(other.m_inFlightBatches)),
+      m_recordingBatch(other.m_recordingBatch),
+      m_copyOffsetAlignment(other.m_copyOffsetAlignment) {
+    other.m_commandPool        = VK_NULL_HANDLE;
+    other.m_acquireCommandPool = VK_NULL_HANDLE;
+    other.m_queue              = VK_NULL_HANDLE;
+  }
+
+  VuUploadContext&
+  operator=(VuUploadContext&& other) noexcept {
+    if (this != &other) {
+      cleanup();
+      m_vuDevice            = std::move(other.m_vuDevice);
+      m_ringBuffer          = std::move(other.m_ringBuffer);
+      m_ringAllocator       = other.m_ringAllocator;
+      m_commandPool         = other.m_commandPool;
+      m_acquireCommandPool  = other.m_acquireCommandPool;
+      m_queue               = other.m_queue;
+      m_transferFamily      = other.m_transferFamily;
+      m_graphicsFamily      = other.m_graphicsFamily;
+      m_batches             = std::move(other.m_batches);
+      m_inFlightBatches     = std::move(other.m_inFlightBatches);
+      m_recordingBatch      = other.m_recordingBatch;
+      m_copyOffsetAlignment = other.m_copyOffsetAlignment;
+
+      other.m_commandPool        = VK_NULL_HANDLE;
+      other.m_acquireCommandPool = VK_NULL_HANDLE;
+      other.m_queue              = VK_NULL_HANDLE;
+    }
+    return *this;
+  }
+
+  ~VuUploadContext() { cleanup(); }
+
+  SETUP_EXPECTED_WRAPPER(VuUploadContext,
+                         (const std::shared_ptr<VuDevice>& vuDevice, const VuUploadContextCreateInfo& createInfo),
+                         (vuDevice, createInfo))
+
+  // records a full upload of mip 0, image ends up in SHADER_READ_ONLY_OPTIMAL layout
+  void
+  uploadToImage(const VuImage& vuImage, const void* data, VkDeviceSize size);
+
+  // records a first upload to offset 0 of a buffer no other queue has touched yet,
+  // live buffers must not go through here since ownership of the whole buffer moves to the graphics family
+  void
+  uploadToBuffer(const VuBuffer& dstBuffer, const void* data, VkDeviceSize size);
+
+  // submits the recorded batch, does not wait
+  void
+  flush();
+
+  // gives back the ring space of finished batches, never blocks
+  void
+  collect();
+
+  void
+  waitIdle();
+
+  [[nodiscard]] bool
+  usesDedicatedTransferQueue() const;
+
+private:
+  void
+  cleanup();
+
+  VuUploadContext(const std::shared_ptr<VuDevice>& vuDevice, const VuUploadContextCreateInfo& createInfo);
+
+  RingAllocation
+  stage(const void* data, VkDeviceSize size);
+
+  VuUploadBatch&
+  getRecordingBatch();
+
+  void
+  waitOldestBatch();
+
+  void
+  retireOldestBatch();
+
+  void
+  recordBufferHandover(VuUploadBatch& batch, VkBuffer buffer) const;
+};
+} // namespace Vu
@@ -1,6 +1,7 @@
 #include "VuAssetLoader.h"
 
 #include <iostream>
+#include <vector>
 
 #include "02_OuterCore/CollectionUtils.h"
 #include "02_OuterCore/math/VuFloat2.h"
@@ -134,67 +135,61 @@ VuAssetLoader::loadGLTF(VuRenderer& vuRenderer, const std::filesystem::path& glt
   fastgltf::Accessor& indexAccessor = asset->accessors[primitive.indicesAccessor.value()];
   u32                 indexCount    = static_cast<u32>(indexAccessor.count);
 
+  // geometry is filled on the cpu and staged into device local memory
+  std::vector<u32> indexData(indexCount);
+  std::span<u32>   indexSpan = indexData;
+  fastgltf::iterateAccessorWithIndex<u32>(
+      asset.get(), indexAccessor, [&](u32 index, std::size_t idx) { indexSpan[idx] = index; });
+
   auto indexBufferOrErr = VuBuffer::make(vuRenderer.m_vuDevice,
                                          {.name         = "IndexBuffer",
                                           .sizeInBytes  = indexCount * sizeof(uint32_t),
-                                          .vkUsageFlags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT});
+                                          .vkUsageFlags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                                          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                          .memoryUsage  = VuMemoryUsage::GpuOnly});
   THROW_if_unexpected(indexBufferOrErr);
   dstMesh.m_indexBuffer = std::make_shared<VuBuffer>(std::move(indexBufferOrErr.value()));
   // vuRenderer.registerToBindless( *dstMesh.indexBuffer);
 
-  auto& indexBuffer = dstMesh.m_indexBuffer;
-
-  indexBuffer->map();
-  std::span<byte> indexSpanByte = indexBuffer->getMappedSpan(0, indexCount * sizeof(u32));
-  std::span<u32>  indexSpan     = std::span(reinterpret_cast<u32*>(indexSpanByte.data()), indexCount);
-  fastgltf::iterateAccessorWithIndex<u32>(
-      asset.get(), indexAccessor, [&](u32 index, std::size_t idx) { indexSpan[idx] = index; });
-  // indexBuffer->unmap();
-
   // Position
   fastgltf::Attribute* positionIt       = primitive.findAttribute("POSITION");
   fastgltf::Accessor&  positionAccessor = asset->accessors[positionIt->accessorIndex];
 
   dstMesh.m_vertexCount = positionAccessor.count;
-  // vuDevice.createBuffer(
-  //     {.name          = "VertexBuffer",
-  //      .length        = dstMesh.vertexCount * dstMesh.totalAttributesSizePerVertex(),
-  //      .strideInBytes = 1u,
-  //      .vkUsageFlags  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT});
-  // dstMesh.vertexBuffer = ;
 
   auto vertexBufferOrErr = VuBuffer::make(
       vuRenderer.m_vuDevice,
       {
           .name         = "VertexBuffer",
           .sizeInBytes  = dstMesh.m_vertexCount * VuMesh::totalAttributesSizePerVertex(),
-          .vkUsageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+          .vkUsageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          .memoryUsage  = VuMemoryUsage::GpuOnly,
       });
   THROW_if_unexpected(vertexBufferOrErr);
   dstMesh.m_vertexBuffer = std::make_shared<VuBuffer>(std::move(vertexBufferOrErr.value()));
   vuRenderer.registerToBindless(*dstMesh.m_vertexBuffer);
 
-  VuBuffer* vertexBuffer = dstMesh.m_vertexBuffer.get();
-  vertexBuffer->map();
+  std::vector<byte> vertexData(dstMesh.m_vertexCount * VuMesh::totalAttributesSizePerVertex());
 
   std::span<byte> vertexSpanByte =
-      vertexBuffer->getMappedSpan(0, sizeof(fastgltf::math::f32vec3) * dstMesh.m_vertexCount);
+      std::span(vertexData).subspan(0, sizeof(fastgltf::math::f32vec3) * dstMesh.m_vertexCount);
   std::span<fastgltf::math::f32vec3> vertexSpan =
       std::span(reinterpret_cast<fastgltf::math::f32vec3*>(vertexSpanByte.data()), dstMesh.m_vertexCount);
 
-  std::span<byte>                    normalSpanByte = vertexBuffer->getMappedSpan(dstMesh.getNormalOffsetAsByte(),
-                                                               sizeof(fastgltf::math::f32vec3) * dstMesh.m_vertexCount);
+  std::span<byte> normalSpanByte = std::span(vertexData).subspan(dstMesh.getNormalOffsetAsByte(),
+                                                                 sizeof(fastgltf::math::f32vec3) * dstMesh.m_vertexCount);
   std::span<fastgltf::math::f32vec3> normalSpan =
       std::span(reinterpret_cast<fastgltf::math::f32vec3*>(normalSpanByte.data()), dstMesh.m_vertexCount);
 
-  std::span<byte> tangentSpanByte = vertexBuffer->getMappedSpan(dstMesh.getTangentOffsetAsByte(),
-                                                                sizeof(fastgltf::math::f32vec4) * dstMesh.m_vertexCount);
+  std::span<byte> tangentSpanByte = std::span(vertexData).subspan(
+      dstMesh.getTangentOffsetAsByte(), sizeof(fastgltf::math::f32vec4) * dstMesh.m_vertexCount);
 
   std::span<fastgltf::math::f32vec4> tangentSpan =
       std::span(reinterpret_cast<fastgltf::math::f32vec4*>(tangentSpanByte.data()), dstMesh.m_vertexCount);
 
-  std::span<byte> uvSpanByte =
-      vertexBuffer->getMappedSpan(dstMesh.getUV_OffsetAsByte(), sizeof(fastgltf::math::f32vec2) * dstMesh.m_vertexCount);
+  std::span<byte> uvSpanByte = std::span(vertexData).subspan(dstMesh.getUV_OffsetAsByte(),
+                                                             sizeof(fastgltf::math::f32vec2) * dstMesh.m_vertexCount);
 
   std::span<fastgltf::math::f32vec2> uvSpan =
       std::span(reinterpret_cast<fastgltf::math::f32vec2*>(uvSpanByte.data()), dstMesh.m_vertexCount);
@@ -248,6 +243,9 @@ VuAssetLoader::loadGLTF(VuRenderer& vuRenderer, const std::filesystem::path& glt
     }
   }
 
-  vertexBuffer->unmap();
+  dstMesh.m_boundingSphere = VuMesh::calculateBoundingSphere(rpCastSpan<fastgltf::math::f32vec3, float3>(vertexSpan));
+
+  vuRenderer.uploadToBuffer(*dstMesh.m_indexBuffer, indexData.data(), indexData.size() * sizeof(u32));
+  vuRenderer.uploadToBuffer(*dstMesh.m_vertexBuffer, vertexData.data(), vertexData.size());
 }
 } // namespace Vu
\ No newline at end of file
@@ -2,9 +2,13 @@
 
 #include <array>
 #include <expected>
+#include <span>
 #include <stdint.h>
 #include <utility>
+#include <vector>
 
+#include "01_InnerCore/MemoryAliasPlanner.h"
+#include "01_InnerCore/VuLogger.h"
 #include "02_OuterCore/VuCommon.h"
 #include "03_Mantle/VuDevice.h"
 #include "03_Mantle/VuImage.h"
@@ -13,99 +17,344 @@
 
 namespace Vu {
 
-VuDeferredRenderSpace::VuDeferredRenderSpace(std::shared_ptr<VuDevice>     vuDevice,
-                                             std::shared_ptr<VuSurface> surface) :
-    m_vuDevice(vuDevice) {
+namespace {
+struct AttachmentLifetime {
+  VuImage*       image;
+  VuDeferredPass firstPass;
+  VuDeferredPass lastPass;
+};
 
-  auto swpChain       = VuSwapChain::make(vuDevice, surface);
+constexpr double BYTES_PER_MIB = 1024.0 * 1024.0;
+
+// attachments used by a single pass never leave tile memory, they become transient
+// the rest get their memory bound later by allocateAliasedMemory
+std::shared_ptr<VuImage>
+createAttachment(const std::shared_ptr<VuDevice>& vuDevice,
+                 const VkExtent2D                 extent,
+                 const VuName&                    name,
+                 const VkFormat                   format,
+                 const VkImageUsageFlags          attachmentUsage,
+                 const VkImageAspectFlags         aspectMask,
+                 const VuDeferredPass             firstPass,
+                 const VuDeferredPass             lastPass) {
+  const bool        isTransient = firstPass == lastPass;
+  VkImageUsageFlags usage       = attachmentUsage;
+  usage |= isTransient ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : VK_IMAGE_USAGE_SAMPLED_BIT;
+
+  auto imageOrErr = VuImage::make(vuDevice,
+                                  VuImageCreateInfo {
+                                      .width          = extent.width,
+                                      .height         = extent.height,
+                                      .format         = format,
+                                      .usage          = usage,
+                                      .aspectMask     = aspectMask,
+                                      .name           = name,
+                                      .externalMemory = !isTransient,
+                                  });
+  THROW_if_unexpected(imageOrErr);
+  return std::make_shared<VuImage>(std::move(imageOrErr.value()));
+}
+
+std::vector<VkDeviceMemory>
+allocateAliasedMemory(VuDevice& vuDevice, std::span<const AttachmentLifetime> lifetimes) {
+  std::vector<AliasResource> resources {};
+  for (const AttachmentLifetime& lifetime : lifetimes) {
+    const VkMemoryRequirements requirements = lifetime.image->getMemoryRequirements();
+    resources.push_back(AliasResource {
+        .size           = requirements.size,
+        .alignment      = requirements.alignment,
+        .memoryTypeBits = requirements.memoryTypeBits,
+        .firstPass      = lifetime.firstPass,
+        .lastPass       = lifetime.lastPass,
+    });
+  }
+  const AliasPlan plan = planMemoryAliasing(resources);
+
+  std::vector<VkDeviceMemory> memories {};
+  for (const AliasBlock& block : plan.blocks) {
+    const VkMemoryRequirements requirements {
+        .size           = block.size,
+        .alignment      = block.alignment,
+        .memoryTypeBits = block.memoryTypeBits,
+    };
+    auto memoryOrErr = vuDevice.allocateMemory(VuMemoryStrategy {.required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT},
+                                               requirements,
+                                               {.name = "GBufferAliased", .category = VuMemoryCategory::RenderTarget});
+    THROW_if_unexpected(memoryOrErr);
+    memories.push_back(memoryOrErr->memory);
+  }
+  for (size_t i = 0; i < lifetimes.size(); ++i) {
+    THROW_if_fail(lifetimes[i].image->bindExternalMemory(memories[plan.blockOfResource[i]], MakeVkOffset(0)));
+  }
+
+  Logger::Info("GBuffer aliasing: {} attachments in {} blocks, {:.2f} MiB allocated, {:.2f} MiB saved",
+               lifetimes.size(),
+               plan.blocks.size(),
+               plan.aliasedBytes / BYTES_PER_MIB,
+               (plan.unaliasedBytes - plan.aliasedBytes) / BYTES_PER_MIB);
+  return memories;
+}
+} // namespace
+
+VuDeferredRenderSpace::VuDeferredRenderSpace(std::shared_ptr<VuDevice>    vuDevice,
+                                             std::shared_ptr<VuSurface>   surface,
+                                             GPU::GBufferLayout           gBufferLayout,
+                                             const bool                   singlePass,
+                                             const bool                   depthPrepass,
+                                             const VuSwapChainCreateInfo& swapChainCreateInfo) :
+    m_vuDevice(vuDevice),
+    m_gBufferLayout(gBufferLayout),
+    m_singlePass(singlePass),
+    m_depthPrepass(depthPrepass && !singlePass) {
+
+  // full: 4 + 16 + 16 + 16 + 4 depth = 56 bytes per pixel
+  // compact: 4 + 4 + 4 + 4 depth = 16 bytes per pixel
+  const bool     isCompact    = gBufferLayout == GPU::GBufferCompact;
+  const VkFormat normalFormat = isCompact ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32B32A32_SFLOAT;
+  const VkFormat armFormat    = isCompact ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R32G32B32A32_SFLOAT;
+  // the lightning subpass of the single pass variant is part of the gbuffer render pass, nothing outlives it
+  const VuDeferredPass    colorLastPass = singlePass ? GBufferPass : LightningPass;
+  const VkImageUsageFlags inputUsage    = singlePass ? VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT : 0;
+  // full layout stores world position, depth is only needed for the depth test
+  const VuDeferredPass    depthLastPass = isCompact ? colorLastPass : GBufferPass;
+  // the prepass hands its depth to the gbuffer pass, it can no longer be transient
+  const VuDeferredPass    depthFirstPass = m_depthPrepass ? DepthPrepass : GBufferPass;
+
+  auto swpChain       = VuSwapChain::make(vuDevice, surface, swapChainCreateInfo);
   this->m_vuSwapChain = move_or_THROW(swpChain);
-  // Color image handle
-  auto colorImgOrrErr = VuImage::make(vuDevice,
-                                      VuImageCreateInfo {
-                                          .width  = m_vuSwapChain.m_extend2D.width,
-                                          .height = m_vuSwapChain.m_extend2D.height,
-                                          .format = VK_FORMAT_R8G8B8A8_UNORM,
-                                          .usage  = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                      });
-  THROW_if_unexpected(colorImgOrrErr);
-  m_colorImage = std::make_shared<VuImage>(std::move(colorImgOrrErr.value()));
-
-  // Normal image handle
-  auto normalImgOrrErr = VuImage::make(vuDevice,
-                                       VuImageCreateInfo {
-                                           .width  = m_vuSwapChain.m_extend2D.width,
-                                           .height = m_vuSwapChain.m_extend2D.height,
-                                           .format = VK_FORMAT_R32G32B32A32_SFLOAT,
-                                           .usage  = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                       });
-  THROW_if_unexpected(normalImgOrrErr);
-  m_normalImage = std::make_shared<VuImage>(std::move(normalImgOrrErr.value()));
-
-  // Arm image handle
-  auto armImgOrrErr = VuImage::make(vuDevice,
-                                    VuImageCreateInfo {
-                                        .width      = m_vuSwapChain.m_extend2D.width,
-                                        .height     = m_vuSwapChain.m_extend2D.height,
-                                        .format     = VK_FORMAT_R32G32B32A32_SFLOAT,
-                                        .usage      = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                    });
-  THROW_if_unexpected(armImgOrrErr);
-  m_aoRoughMetalImage = std::make_shared<VuImage>(std::move(armImgOrrErr.value()));
-
-  // world space pos image handle
-  auto wsPosImageOrErr = VuImage::make(vuDevice,
-                                       VuImageCreateInfo {
-                                           .width  = m_vuSwapChain.m_extend2D.width,
-                                           .height = m_vuSwapChain.m_extend2D.height,
-                                           .format = VK_FORMAT_R32G32B32A32_SFLOAT,
-                                           .usage  = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                                           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                       });
-  THROW_if_unexpected(wsPosImageOrErr);
-  m_worldSpacePosImage = std::make_shared<VuImage>(std::move(wsPosImageOrErr.value()));
-
-  // Depth-stencil image handle
-  auto depthStencilImgOrrErr =
-      VuImage::make(vuDevice,
-                    VuImageCreateInfo {
-                        .width      = m_vuSwapChain.m_extend2D.width,
-                        .height     = m_vuSwapChain.m_extend2D.height,
-                        .format     = VK_FORMAT_D32_SFLOAT,
-                        .usage      = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-                        .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
-                    });
-  THROW_if_unexpected(depthStencilImgOrrErr);
-  m_depthStencilImage = std::make_shared<VuImage>(std::move(depthStencilImgOrrErr.value()));
+
+  const VkExtent2D                extent = m_vuSwapChain.m_extend2D;
+  std::vector<AttachmentLifetime> lifetimes {};
+  auto colorAttachment = [&](const VuName& name, VkFormat format) {
+    auto image = createAttachment(vuDevice,
+                                  extent,
+                                  name,
+                                  format,
+                                  VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | inputUsage,
+                                  VK_IMAGE_ASPECT_COLOR_BIT,
+                                  GBufferPass,
+                                  colorLastPass);
+    if (colorLastPass != GBufferPass) { lifetimes.push_back({image.get(), GBufferPass, colorLastPass}); }
+    return image;
+  };
+
+  m_colorImage        = colorAttachment("GBufferColor", VK_FORMAT_R8G8B8A8_UNORM);
+  m_normalImage       = colorAttachment("GBufferNormal", normalFormat);
+  m_aoRoughMetalImage = colorAttachment("GBufferAoRoughMetal", armFormat);
+  if (!isCompact) { m_worldSpacePosImage = colorAttachment("GBufferWorldPos", VK_FORMAT_R32G32B32A32_SFLOAT); }
+
+  m_depthStencilImage = createAttachment(vuDevice,
+                                         extent,
+                                         "GBufferDepth",
+                                         VK_FORMAT_D32_SFLOAT,
+                                         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | (isCompact ? inputUsage : 0),
+                                         VK_IMAGE_ASPECT_DEPTH_BIT,
+                                         depthFirstPass,
+                                         depthLastPass);
+  if (depthFirstPass != depthLastPass) {
+    lifetimes.push_back({m_depthStencilImage.get(), depthFirstPass, depthLastPass});
+  }
+
+  if (!lifetimes.empty()) { m_aliasedMemory = allocateAliasedMemory(*vuDevice, lifetimes); }
+
+  if (m_depthStencilImage->isLazilyAllocated()) {
+    const VkDeviceSize transientBytes = m_depthStencilImage->getMemoryRequirements().size;
+    const double       scaleTo4K      = (3840.0 * 2160.0) / (static_cast<double>(extent.width) * extent.height);
+    Logger::Info("GBuffer transient depth is lazily allocated, {:.2f} MiB saved at {}x{}, ~{:.2f} MiB at 3840x2160",
+                 transientBytes / BYTES_PER_MIB,
+                 extent.width,
+                 extent.height,
+                 transientBytes * scaleTo4K / BYTES_PER_MIB);
+  }
 
   m_gBufferPass   = std::make_shared<VuRenderPass>(nullptr);
   m_lightningPass = std::make_shared<VuRenderPass>(nullptr);
 
+  std::vector<VkFormat> colorFormats {};
+  for (const VuImage* image : getGBufferColorImages()) {
+    colorFormats.push_back(image->m_lastCreateInfo.format);
+  }
+
+  if (singlePass) {
+    // attachment indices follow getGBufferColorImages, depth comes right after the colors
+    const u32                          depthAttachment = static_cast<u32>(colorFormats.size());
+    std::array<u32, GBufferInputCount> inputAttachments {};
+    inputAttachments[GBufferInputColor]        = 0;
+    inputAttachments[GBufferInputNormal]       = 1;
+    inputAttachments[GBufferInputAoRoughMetal] = 2;
+    inputAttachments[GBufferInputDepth]        = isCompact ? depthAttachment : VK_ATTACHMENT_UNUSED;
+    inputAttachments[GBufferInputWorldPos]     = isCompact ? VK_ATTACHMENT_UNUSED : 3;
+
+    m_gBufferPass->initAsDeferredPass(vuDevice,
+                                      colorFormats,
+                                      m_depthStencilImage->m_lastCreateInfo.format,
+                                      m_vuSwapChain.m_imageFormat,
+                                      inputAttachments);
+    m_lightningPass->initAsSubpassOf(m_gBufferPass, 1);
+    // nothing is stored for a second gbuffer pass, gpu scene occlusion culling stays off
+    createFramebuffers(*vuDevice);
+    return;
+  }
+
   m_gBufferPass->initAsGBufferPass(vuDevice,
-                                   m_colorImage->m_lastCreateInfo.format,
-                                   m_normalImage->m_lastCreateInfo.format,
-                                   m_aoRoughMetalImage->m_lastCreateInfo.format,
-                                   m_worldSpacePosImage->m_lastCreateInfo.format,
-                                   m_depthStencilImage->m_lastCreateInfo.format);
+                                   colorFormats,
+                                   m_depthStencilImage->m_lastCreateInfo.format,
+                                   depthLastPass == GBufferPass ? VK_ATTACHMENT_STORE_OP_DONT_CARE
+                                                                : VK_ATTACHMENT_STORE_OP_STORE);
+  if (depthLastPass != GBufferPass) {
+    m_gBufferLoadPass = std::make_shared<VuRenderPass>(nullptr);
+    m_gBufferLoadPass->initAsGBufferPass(vuDevice,
+                                         colorFormats,
+                                         m_depthStencilImage->m_lastCreateInfo.format,
+                                         VK_ATTACHMENT_STORE_OP_STORE,
+                                         VK_ATTACHMENT_LOAD_OP_LOAD);
+  }
+  if (m_depthPrepass) {
+    m_depthPrepassPass = std::make_shared<VuRenderPass>(nullptr);
+    m_depthPrepassPass->initAsDepthPrepass(vuDevice, m_depthStencilImage->m_lastCreateInfo.format);
+    m_gBufferPrepassedPass = std::make_shared<VuRenderPass>(nullptr);
+    m_gBufferPrepassedPass->initAsGBufferPass(vuDevice,
+                                              colorFormats,
+                                              m_depthStencilImage->m_lastCreateInfo.format,
+                                              depthLastPass == GBufferPass ? VK_ATTACHMENT_STORE_OP_DONT_CARE
+                                                                           : VK_ATTACHMENT_STORE_OP_STORE,
+                                              VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                              true);
+  }
   m_lightningPass->initAsLightningPass(vuDevice, m_vuSwapChain.m_imageFormat);
 
   createFramebuffers(*vuDevice);
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuDeferredRenderSpace&
+VuDeferredRenderSpace::operator=(VuDeferredRenderSpace&& other) noexcept {
+  if (this != &other) {
+    cleanup();
+    m_vuRenderer                = std::move(other.m_vuRenderer);
+    m_vuDevice                  = std::move(other.m_vuDevice);
+    m_colorImage                = std::move(other.m_colorImage);
+    m_normalImage               = std::move(other.m_normalImage);
+    m_aoRoughMetalImage         = std::move(other.m_aoRoughMetalImage);
+    m_worldSpacePosImage        = std::move(other.m_worldSpacePosImage);
+    m_depthStencilImage         = std::move(other.m_depthStencilImage);
+    m_gPassFrameBuffers         = std::move(other.m_gPassFrameBuffers);
+    m_lightningPassFrameBuffers = std::move(other.m_lightningPassFrameBuffers);
+    m_depthPrepassFrameBuffers  = std::move(other.m_depthPrepassFrameBuffers);
+    m_gBufferPass               = std::move(other.m_gBufferPass);
+    m_gBufferLoadPass           = std::move(other.m_gBufferLoadPass);
+    m_depthPrepassPass          = std::move(other.m_depthPrepassPass);
+    m_gBufferPrepassedPass      = std::move(other.m_gBufferPrepassedPass);
+    m_lightningPass             = std::move(other.m_lightningPass);
+    m_lightningPassMaterialData = other.m_lightningPassMaterialData;
+    m_vuSwapChain               = std::move(other.m_vuSwapChain);
+    m_gBufferLayout             = other.m_gBufferLayout;
+    m_aliasedMemory             = std::move(other.m_aliasedMemory);
+    m_singlePass                = other.m_singlePass;
+    m_depthPrepass              = other.m_depthPrepass;
+
+    other.m_gPassFrameBuffers.clear();
+    other.m_lightningPassFrameBuffers.clear();
+    other.m_depthPrepassFrameBuffers.clear();
+    other.m_aliasedMemory.clear();
+  }
+  return *this;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDeferredRenderSpace::cleanup() {
+  if (!m_vuDevice) { return; }
+  for (VkFramebuffer frameBuffer : m_gPassFrameBuffers) {
+    vkDestroyFramebuffer(m_vuDevice->m_device, frameBuffer, NO_ALLOC_CALLBACK);
+  }
+  for (VkFramebuffer frameBuffer : m_lightningPassFrameBuffers) {
+    vkDestroyFramebuffer(m_vuDevice->m_device, frameBuffer, NO_ALLOC_CALLBACK);
+  }
+  for (VkFramebuffer frameBuffer : m_depthPrepassFrameBuffers) {
+    vkDestroyFramebuffer(m_vuDevice->m_device, frameBuffer, NO_ALLOC_CALLBACK);
+  }
+  m_gPassFrameBuffers.clear();
+  m_lightningPassFrameBuffers.clear();
+  m_depthPrepassFrameBuffers.clear();
+
+  // images go before the memory they are bound to
+  m_colorImage.reset();
+  m_normalImage.reset();
+  m_aoRoughMetalImage.reset();
+  m_worldSpacePosImage.reset();
+  m_depthStencilImage.reset();
+  for (VkDeviceMemory memory : m_aliasedMemory) {
+    m_vuDevice->freeMemory(memory);
+  }
+  m_aliasedMemory.clear();
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool
+VuDeferredRenderSpace::isSinglePass() const {
+  return m_singlePass;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool
+VuDeferredRenderSpace::hasDepthPrepass() const {
+  return m_depthPrepass;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDeferredRenderSpace::writeInputAttachmentSet(const VkDescriptorSet set) const {
+  std::array<VuImage*, GBufferInputCount> inputs {};
+  inputs[GBufferInputColor]        = m_colorImage.get();
+  inputs[GBufferInputNormal]       = m_normalImage.get();
+  inputs[GBufferInputAoRoughMetal] = m_aoRoughMetalImage.get();
+  inputs[GBufferInputDepth]        = m_gBufferLayout == GPU::GBufferCompact ? m_depthStencilImage.get() : nullptr;
+  inputs[GBufferInputWorldPos]     = m_worldSpacePosImage.get();
+
+  // the set is partially bound, the slot the layout does not use is left empty
+  std::array<VkDescriptorImageInfo, GBufferInputCount> imageInfos {};
+  std::vector<VkWriteDescriptorSet>                    writes {};
+  for (u32 i = 0; i < GBufferInputCount; ++i) {
+    if (inputs[i] == nullptr) { continue; }
+    imageInfos[i] = {.imageView   = inputs[i]->m_imageView,
+                     .imageLayout = inputs[i] == m_depthStencilImage.get()
+                                        ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                                        : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    writes.push_back({.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                      .dstSet          = set,
+                      .dstBinding      = i,
+                      .descriptorCount = 1,
+                      .descriptorType  = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+                      .pImageInfo      = &imageInfos[i]});
+  }
+  vkUpdateDescriptorSets(m_vuDevice->m_device, static_cast<u32>(writes.size()), writes.data(), 0, nullptr);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void
 VuDeferredRenderSpace::registerImagesToBindless(VuRenderer& vuRenderer) {
-  vuRenderer.registerToBindless(*m_colorImage);
-  vuRenderer.registerToBindless(*m_normalImage);
-  vuRenderer.registerToBindless(*m_aoRoughMetalImage);
-  vuRenderer.registerToBindless(*m_worldSpacePosImage);
-  vuRenderer.registerToBindless(*m_depthStencilImage);
-  m_lightningPassMaterialData.colorTexture         = m_colorImage->m_bindlessIndex.value_or_THROW();
-  m_lightningPassMaterialData.normalTexture        = m_normalImage->m_bindlessIndex.value_or_THROW();
-  m_lightningPassMaterialData.aoRoughMetalTexture  = m_aoRoughMetalImage->m_bindlessIndex.value_or_THROW();
-  m_lightningPassMaterialData.worldSpacePosTexture = m_worldSpacePosImage->m_bindlessIndex.value_or_THROW();
-  m_lightningPassMaterialData.depthTexture         = m_depthStencilImage->m_bindlessIndex.value_or_THROW();
+  // transient attachments have no SAMPLED usage and keep 0, the default image
+  auto registerSampled = [&vuRenderer](VuImage* image) -> u32 {
+    if (image == nullptr || !(image->m_lastCreateInfo.usage & VK_IMAGE_USAGE_SAMPLED_BIT)) { return 0; }
+    vuRenderer.registerToBindless(*image);
+    return image->m_bindlessIndex.value_or_THROW();
+  };
+  m_lightningPassMaterialData.colorTexture        = registerSampled(m_colorImage.get());
+  m_lightningPassMaterialData.normalTexture       = registerSampled(m_normalImage.get());
+  m_lightningPassMaterialData.aoRoughMetalTexture = registerSampled(m_aoRoughMetalImage.get());
+  // only the compact layout reads depth, the full one samples world position instead
+  m_lightningPassMaterialData.depthTexture         = registerSampled(m_depthStencilImage.get());
+  m_lightningPassMaterialData.worldSpacePosTexture = registerSampled(m_worldSpacePosImage.get());
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDeferredRenderSpace::unregisterImagesFromBindless(VuRenderer& vuRenderer) {
+  for (VuImage* image : getGBufferColorImages()) {
+    vuRenderer.unregisterFromBindless(*image);
+  }
+  if (m_depthStencilImage) { vuRenderer.unregisterFromBindless(*m_depthStencilImage); }
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<VuImage*>
+VuDeferredRenderSpace::getGBufferColorImages() const {
+  std::vector<VuImage*> images {m_colorImage.get(), m_normalImage.get(), m_aoRoughMetalImage.get()};
+  if (m_worldSpacePosImage) { images.push_back(m_worldSpacePosImage.get()); }
+  return images;
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void
@@ -113,16 +362,15 @@ VuDeferredRenderSpace::createFramebuffers(const VuDevice& vuDevice) {
   m_gPassFrameBuffers.clear();
   m_gPassFrameBuffers.resize(m_vuSwapChain.m_imageViews.size());
   for (size_t i = 0; i < m_vuSwapChain.m_imageViews.size(); i++) {
-    std::array<VkImageView, 5> attachments = {
-        m_colorImage->m_imageView,
-        m_normalImage->m_imageView,
-        m_aoRoughMetalImage->m_imageView,
-        m_worldSpacePosImage->m_imageView,
-        m_depthStencilImage->m_imageView,
-    };
+    std::vector<VkImageView> attachments {};
+    for (const VuImage* image : getGBufferColorImages()) {
+      attachments.push_back(image->m_imageView);
+    }
+    attachments.push_back(m_depthStencilImage->m_imageView);
+    if (m_singlePass) { attachments.push_back(m_vuSwapChain.m_imageViews[i]); }
     VkFramebufferCreateInfo framebufferInfo {.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
     framebufferInfo.renderPass      = m_gBufferPass->m_renderPass;
-    framebufferInfo.attachmentCount = attachments.size();
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
     framebufferInfo.pAttachments    = attachments.data();
     framebufferInfo.width           = m_vuSwapChain.m_extend2D.width;
     framebufferInfo.height          = m_vuSwapChain.m_extend2D.height;
@@ -133,7 +381,25 @@ VuDeferredRenderSpace::createFramebuffers(const VuDevice& vuDevice) {
     THROW_if_fail(frameBufferRes);
   }
 
+  m_depthPrepassFrameBuffers.clear();
+  if (m_depthPrepass) {
+    m_depthPrepassFrameBuffers.resize(m_vuSwapChain.m_imageViews.size());
+    for (VkFramebuffer& framebuffer : m_depthPrepassFrameBuffers) {
+      VkFramebufferCreateInfo framebufferInfo {.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+      framebufferInfo.renderPass      = m_depthPrepassPass->m_renderPass;
+      framebufferInfo.attachmentCount = 1;
+      framebufferInfo.pAttachments    = &m_depthStencilImage->m_imageView;
+      framebufferInfo.width           = m_vuSwapChain.m_extend2D.width;
+      framebufferInfo.height          = m_vuSwapChain.m_extend2D.height;
+      framebufferInfo.layers          = 1;
+
+      THROW_if_fail(vkCreateFramebuffer(vuDevice.m_device, &framebufferInfo, NO_ALLOC_CALLBACK, &framebuffer));
+    }
+  }
+
+  // the lightning subpass renders through the gbuffer framebuffers
   m_lightningPassFrameBuffers.clear();
+  if (m_singlePass) { return; }
   m_lightningPassFrameBuffers.resize(m_vuSwapChain.m_imageViews.size());
   for (size_t i = 0; i < m_vuSwapChain.m_imageViews.size(); i++) {
     std::array<VkImageView, 1> attachments = {
@@ -155,6 +421,11 @@ VuDeferredRenderSpace::createFramebuffers(const VuDevice& vuDevice) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void
 VuDeferredRenderSpace::beginLightningPass(const VkCommandBuffer& commandBuffer, const u32 frameIndex) const {
+  if (m_singlePass) {
+    vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    return;
+  }
+
   std::array<VkClearValue, 1> clearValues {};
   clearValues[0].color = {0.0f, 0.0f, 0.0f, 1.0f};
 
@@ -170,23 +441,53 @@ VuDeferredRenderSpace::beginLightningPass(const VkCommandBuffer& commandBuffer,
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void
-VuDeferredRenderSpace::beginGBufferPass(const VkCommandBuffer& commandBuffer, const u32 frameIndex) const {
-  std::array<VkClearValue, 5> clearValues {
-      {{.color = {0, 0, 0, 1}},
-       {.color = {0, 0, 0, 1}},
-       {.color = {0, 0, 0, 1}},
-       {.color = {0, 0, 0, 1}},
-       {.depthStencil = {.depth = 1}}},
-  };
+VuDeferredRenderSpace::beginDepthPrepass(const VkCommandBuffer& commandBuffer, const u32 frameIndex) const {
+  const VkClearValue clearValue {.depthStencil = {.depth = 1}};
 
   VkRenderPassBeginInfo renderPassInfo {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
-  renderPassInfo.renderPass        = m_gBufferPass->m_renderPass;
+  renderPassInfo.renderPass        = m_depthPrepassPass->m_renderPass;
+  renderPassInfo.framebuffer       = m_depthPrepassFrameBuffers[frameIndex];
+  renderPassInfo.renderArea.offset = VkOffset2D {0, 0};
+  renderPassInfo.renderArea.extent = m_vuSwapChain.m_extend2D;
+  renderPassInfo.clearValueCount   = 1;
+  renderPassInfo.pClearValues      = &clearValue;
+
+  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDeferredRenderSpace::beginGBufferPass(const VkCommandBuffer&  commandBuffer,
+                                        const u32               frameIndex,
+                                        const VkSubpassContents contents,
+                                        const bool              depthPrepassed) const {
+  const size_t colorAttachmentCount = m_gBufferPass->m_colorBlendAttachmentStates.size();
+
+  std::vector<VkClearValue> clearValues(colorAttachmentCount, VkClearValue {.color = {0, 0, 0, 1}});
+  clearValues.push_back({.depthStencil = {.depth = 1}});
+  if (m_singlePass) { clearValues.push_back(VkClearValue {.color = {0.0f, 0.0f, 0.0f, 1.0f}}); }
+
+  const VuRenderPass& renderPass = depthPrepassed ? *m_gBufferPrepassedPass : *m_gBufferPass;
+
+  VkRenderPassBeginInfo renderPassInfo {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+  renderPassInfo.renderPass        = renderPass.m_renderPass;
   renderPassInfo.framebuffer       = m_gPassFrameBuffers[frameIndex];
   renderPassInfo.renderArea.offset = VkOffset2D {0, 0};
   renderPassInfo.renderArea.extent = m_vuSwapChain.m_extend2D;
   renderPassInfo.clearValueCount   = static_cast<uint32_t>(clearValues.size());
   renderPassInfo.pClearValues      = clearValues.data();
 
+  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDeferredRenderSpace::beginGBufferLoadPass(const VkCommandBuffer& commandBuffer, const u32 frameIndex) const {
+  // render pass compatibility only depends on formats and samples, the gbuffer framebuffers can be reused
+  VkRenderPassBeginInfo renderPassInfo {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+  renderPassInfo.renderPass        = m_gBufferLoadPass->m_renderPass;
+  renderPassInfo.framebuffer       = m_gPassFrameBuffers[frameIndex];
+  renderPassInfo.renderArea.offset = VkOffset2D {0, 0};
+  renderPassInfo.renderArea.extent = m_vuSwapChain.m_extend2D;
+
   vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
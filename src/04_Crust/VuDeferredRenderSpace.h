@@ -8,31 +8,59 @@ struct VuDevice;
 struct VuImage;
 struct VuRenderPass;
 
+// passes of the deferred pipeline in execution order, attachment lifetimes are expressed in these
+enum VuDeferredPass : uint32_t {
+  // optional, only depth is written
+  DepthPrepass,
+  GBufferPass,
+  LightningPass,
+};
+
+// input_attachment_index and binding in the input attachment set of the single pass lightning subpass
+enum VuGBufferInput : uint32_t {
+  GBufferInputColor,
+  GBufferInputNormal,
+  GBufferInputAoRoughMetal,
+  // compact layout only
+  GBufferInputDepth,
+  // full layout only
+  GBufferInputWorldPos,
+  GBufferInputCount,
+};
+
 struct VuDeferredRenderSpace {
   std::shared_ptr<VuRenderer>   m_vuRenderer {};
   std::shared_ptr<VuDevice>     m_vuDevice {};
   std::shared_ptr<VuImage>      m_colorImage {};
   std::shared_ptr<VuImage>      m_normalImage {};
   std::shared_ptr<VuImage>      m_aoRoughMetalImage {};
+  // only allocated with GBufferFull, compact layout reconstructs position from depth
   std::shared_ptr<VuImage>      m_worldSpacePosImage {};
   std::shared_ptr<VuImage>      m_depthStencilImage {};
   std::vector<VkFramebuffer>    m_gPassFrameBuffers {};
   std::vector<VkFramebuffer>    m_lightningPassFrameBuffers {};
+  // depth attachment only, created with depthPrepass
+  std::vector<VkFramebuffer>    m_depthPrepassFrameBuffers {};
+  // in single pass mode owns the lightning subpass as well, see initAsDeferredPass
   std::shared_ptr<VuRenderPass> m_gBufferPass {};
+  // continues the gbuffer pass after occlusion culling, only created when depth is stored
+  std::shared_ptr<VuRenderPass> m_gBufferLoadPass {};
+  // depth only pass, and the gbuffer pass variant that loads its depth instead of clearing it
+  std::shared_ptr<VuRenderPass> m_depthPrepassPass {};
+  std::shared_ptr<VuRenderPass> m_gBufferPrepassedPass {};
+  // in single pass mode a view of subpass 1 of m_gBufferPass
   std::shared_ptr<VuRenderPass> m_lightningPass {};
-  GPU::MatData_PbrDeferred           m_lightningPassMaterialData {};
+  GPU::MatData_PbrDeferred      m_lightningPassMaterialData {};
   VuSwapChain                   m_vuSwapChain {};
+  GPU::GBufferLayout            m_gBufferLayout {GPU::GBufferCompact};
+  // shared by attachments whose pass lifetimes do not overlap, see planMemoryAliasing
+  std::vector<VkDeviceMemory>   m_aliasedMemory {};
+  // gbuffer and lightning are subpasses of one render pass, the gbuffer is read with subpassLoad and never stored
+  bool                          m_singlePass {};
+  // depth survives from the prepass into the gbuffer pass, see beginDepthPrepass
+  bool                          m_depthPrepass {};
 
-  ~VuDeferredRenderSpace() {
-    for (auto frameBuffer : m_gPassFrameBuffers) {
-
-      vkDestroyFramebuffer(m_vuDevice->m_device, frameBuffer, NO_ALLOC_CALLBACK);
-    }
-    for (auto frameBuffer : m_lightningPassFrameBuffers) {
-
-      vkDestroyFramebuffer(m_vuDevice->m_device, frameBuffer, NO_ALLOC_CALLBACK);
-    }
-  }
+  ~VuDeferredRenderSpace() { cleanup(); }
 
   VuDeferredRenderSpace()                             = default;
   VuDeferredRenderSpace(const VuDeferredRenderSpace&) = delete;
@@ -40,20 +68,61 @@ struct VuDeferredRenderSpace {
   operator=(const VuDeferredRenderSpace&)        = delete;
   VuDeferredRenderSpace(VuDeferredRenderSpace&&) = default;
   VuDeferredRenderSpace&
-  operator=(VuDeferredRenderSpace&&) = default;
+  operator=(VuDeferredRenderSpace&& other) noexcept;
+
+  VuDeferredRenderSpace(std::shared_ptr<VuDevice>    vuDevice,
+                        std::shared_ptr<VuSurface>   surface,
+                        GPU::GBufferLayout           gBufferLayout,
+                        bool                         singlePass          = false,
+                        bool                         depthPrepass        = false,
+                        const VuSwapChainCreateInfo& swapChainCreateInfo = {});
+
+  // color attachments of the gbuffer pass, depth excluded
+  [[nodiscard]] std::vector<VuImage*>
+  getGBufferColorImages() const;
 
-  VuDeferredRenderSpace(std::shared_ptr<VuDevice> vuDevice, std::shared_ptr<VuSurface> surface);
+  [[nodiscard]] bool
+  isSinglePass() const;
 
+  // false in single pass mode, the prepass would have to be another subpass
+  [[nodiscard]] bool
+  hasDepthPrepass() const;
+
+  // points the bindings of set at the gbuffer attachments, see VuGBufferInput. single pass mode only
+  void
+  writeInputAttachmentSet(VkDescriptorSet set) const;
+
+  // only attachments with SAMPLED usage get a slot, single pass mode has none
   void
   registerImagesToBindless(VuRenderer& vuInstance);
 
+  // gives the slots back before the images are replaced, e.g. on swapchain resize
+  void
+  unregisterImagesFromBindless(VuRenderer& vuRenderer);
+
+  // clears depth, only the depth attachment is bound
+  void
+  beginDepthPrepass(const VkCommandBuffer& commandBuffer, uint32_t frameIndex) const;
+
+  // depthPrepassed keeps the depth beginDepthPrepass wrote this frame. both variants are compatible with m_gBufferPass
   void
-  beginGBufferPass(const VkCommandBuffer& commandBuffer, uint32_t frameIndex) const;
+  beginGBufferPass(const VkCommandBuffer& commandBuffer,
+                   uint32_t               frameIndex,
+                   VkSubpassContents      contents       = VK_SUBPASS_CONTENTS_INLINE,
+                   bool                   depthPrepassed = false) const;
 
+  // same framebuffers as beginGBufferPass, keeps what the first gbuffer pass of the frame wrote
+  void
+  beginGBufferLoadPass(const VkCommandBuffer& commandBuffer, uint32_t frameIndex) const;
+
+  // in single pass mode only moves on to the lightning subpass
   void
   beginLightningPass(const VkCommandBuffer& commandBuffer, uint32_t frameIndex) const;
 
 private:
+  void
+  cleanup();
+
   void
   createFramebuffers(const VuDevice& vuDevice);
 };
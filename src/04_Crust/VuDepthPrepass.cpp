@@ -0,0 +1,295 @@
+#include "VuDepthPrepass.h"
+
+#include <array>
+#include <utility>
+
+#include "01_InnerCore/VuLogger.h"
+#include "02_OuterCore/VuConfig.h"
+#include "03_Mantle/VuDevice.h"
+#include "03_Mantle/VuPhysicalDevice.h"
+#include "03_Mantle/VuRenderPass.h"
+#include "VuGpuScene.h"
+#include "VuMaterial.h"
+#include "VuMesh.h"
+#include "VuRenderer.h"
+#include "VuShader.h"
+
+namespace Vu {
+
+// exponential moving average over the last few measurements, one arrives per prepass frame
+static constexpr float OVERDRAW_SMOOTHING = 0.25f;
+
+const char*
+toString(const VuDepthPrepassMode mode) {
+  switch (mode) {
+  case VuDepthPrepassMode::Off: return "Off";
+  case VuDepthPrepassMode::On: return "On";
+  case VuDepthPrepassMode::Auto: return "Auto";
+  }
+  return "Unknown";
+}
+
+VuDepthPrepassDecision
+decideDepthPrepass(const VuDepthPrepassDecision&          previous,
+                   const std::optional<VuOverdrawSample>& sample,
+                   const VuDepthPrepassMode               mode,
+                   const bool                             measurable,
+                   const VuDepthPrepassCreateInfo&        createInfo) {
+  VuDepthPrepassDecision decision = previous;
+  if (sample.has_value()) {
+    // an empty frame covers nothing and has no overdraw
+    const float overdraw =
+        sample->pixelCount == 0
+            ? 0.0f
+            : static_cast<float>(sample->passedSamples) / static_cast<float>(sample->pixelCount);
+    decision.overdraw = decision.hasMeasurement
+                            ? decision.overdraw + (overdraw - decision.overdraw) * OVERDRAW_SMOOTHING
+                            : overdraw;
+    decision.hasMeasurement = true;
+  }
+
+  // hysteresis keeps auto mode from flipping every frame around a single threshold
+  if (decision.hasMeasurement && decision.overdraw >= createInfo.enableOverdraw) { decision.autoEnabled = true; }
+  if (decision.hasMeasurement && decision.overdraw < createInfo.disableOverdraw) { decision.autoEnabled = false; }
+
+  decision.framesSinceActive++;
+  switch (mode) {
+  case VuDepthPrepassMode::Off: decision.active = false; break;
+  case VuDepthPrepassMode::On: decision.active = true; break;
+  case VuDepthPrepassMode::Auto:
+    decision.active =
+        measurable && (decision.autoEnabled || decision.framesSinceActive >= createInfo.probeInterval);
+    break;
+  }
+  if (decision.active) { decision.framesSinceActive = 0; }
+  return decision;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuDepthPrepass::VuDepthPrepass(VuRenderer& vuRenderer, const VuDepthPrepassCreateInfo& createInfo) :
+    m_vuDevice {vuRenderer.m_vuDevice},
+    m_pipelineLayout {vuRenderer.m_globalPipelineLayout},
+    m_createInfo {createInfo},
+    m_decision {.framesSinceActive = createInfo.probeInterval} {
+  const auto spv = VuShader::compileToSpirv(createInfo.vertShaderPath);
+  if (!spv.has_value()) {
+    Logger::Error("depth prepass shader {} cannot be compiled!", createInfo.vertShaderPath.string());
+    throw VK_ERROR_INITIALIZATION_FAILED;
+  }
+  const VkShaderModule vertModule = VuShader::createShaderModule(*m_vuDevice, spv->data(), spv->size());
+
+  // pipelines only depend on render pass compatibility, the render space creates its prepass only when it is used
+  const VkFormat depthFormat = vuRenderer.m_deferredRenderSpace.m_depthStencilImage->m_lastCreateInfo.format;
+  VuRenderPass   compatiblePass {nullptr};
+  compatiblePass.initAsDepthPrepass(m_vuDevice, depthFormat);
+
+  const u32 pipelineCount = m_vuDevice->m_dynamicRasterState.hasCullAndDepth() ? 1u : VK_CULL_MODE_FRONT_AND_BACK + 1u;
+  for (u32 cullMode = 0; cullMode < pipelineCount; ++cullMode) {
+    auto pipelineOrErr = VuGraphicsPipeline::make(m_vuDevice,
+                                                  m_pipelineLayout,
+                                                  vertModule,
+                                                  VK_NULL_HANDLE,
+                                                  compatiblePass.m_renderPass,
+                                                  0,
+                                                  {},
+                                                  VuPipelineRasterState {.cullMode = cullMode});
+    m_pipelines.push_back(move_or_THROW(pipelineOrErr));
+  }
+  vkDestroyShaderModule(m_vuDevice->m_device, vertModule, NO_ALLOC_CALLBACK);
+
+  // without PRECISE a query may only report zero or not zero
+  m_stats.measurable = vuRenderer.m_vuPhysicalDevice->m_features.occlusionQueryPrecise == VK_TRUE;
+  if (!m_stats.measurable) { Logger::Info("Precise occlusion queries not supported, depth prepass auto mode is off"); }
+  m_canInheritQueries = vuRenderer.m_vuPhysicalDevice->m_features.inheritedQueries == VK_TRUE;
+
+  VkQueryPoolCreateInfo queryPoolInfo {.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+  queryPoolInfo.queryType  = VK_QUERY_TYPE_OCCLUSION;
+  queryPoolInfo.queryCount = config::MAX_FRAMES_IN_FLIGHT * 2u;
+  THROW_if_fail(vkCreateQueryPool(m_vuDevice->m_device, &queryPoolInfo, NO_ALLOC_CALLBACK, &m_queryPool));
+  m_queries.resize(config::MAX_FRAMES_IN_FLIGHT);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuDepthPrepass::VuDepthPrepass(VuDepthPrepass&& other) noexcept :
+    m_vuDevice(std::move(other.m_vuDevice)),
+    m_pipelineLayout(other.m_pipelineLayout),
+    m_pipelines(std::move(other.m_pipelines)),
+    m_queryPool(other.m_queryPool),
+    m_queries(std::move(other.m_queries)),
+    m_mode(other.m_mode),
+    m_stats(other.m_stats),
+    m_createInfo(std::move(other.m_createInfo)),
+    m_decision(other.m_decision),
+    m_canInheritQueries(other.m_canInheritQueries),
+    m_coverageQueryActive(other.m_coverageQueryActive) {
+  other.m_queryPool = VK_NULL_HANDLE;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuDepthPrepass&
+VuDepthPrepass::operator=(VuDepthPrepass&& other) noexcept {
+  if (this != &other) {
+    cleanup();
+    m_vuDevice            = std::move(other.m_vuDevice);
+    m_pipelineLayout      = other.m_pipelineLayout;
+    m_pipelines           = std::move(other.m_pipelines);
+    m_queryPool           = other.m_queryPool;
+    m_queries             = std::move(other.m_queries);
+    m_mode                = other.m_mode;
+    m_stats               = other.m_stats;
+    m_createInfo          = std::move(other.m_createInfo);
+    m_decision            = other.m_decision;
+    m_canInheritQueries   = other.m_canInheritQueries;
+    m_coverageQueryActive = other.m_coverageQueryActive;
+    other.m_queryPool     = VK_NULL_HANDLE;
+  }
+  return *this;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuDepthPrepass::~VuDepthPrepass() { cleanup(); }
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDepthPrepass::cleanup() {
+  m_pipelines.clear();
+  if (m_vuDevice && m_queryPool != VK_NULL_HANDLE) {
+    vkDestroyQueryPool(m_vuDevice->m_device, m_queryPool, NO_ALLOC_CALLBACK);
+  }
+  m_queryPool = VK_NULL_HANDLE;
+  m_vuDevice.reset();
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool
+VuDepthPrepass::update(const u32 frameIndex) {
+  std::optional<VuOverdrawSample> sample {};
+  VuDepthPrepassQueries&          queries = m_queries[frameIndex];
+  if (queries.pending) {
+    // samples passed and availability of the prepass query, then of the coverage query. the frame completed, a
+    // missing result is dropped instead of waited for
+    const u32          queryCount = queries.coverageCounted ? 2u : 1u;
+    std::array<u64, 4> result {};
+    const VkResult     resultRes = vkGetQueryPoolResults(m_vuDevice->m_device,
+                                                     m_queryPool,
+                                                     frameIndex * 2u,
+                                                     queryCount,
+                                                     sizeof(result),
+                                                     result.data(),
+                                                     2u * sizeof(u64),
+                                                     VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    const bool available = resultRes == VK_SUCCESS && result[1] != 0 && (!queries.coverageCounted || result[3] != 0);
+    if (available) {
+      sample = VuOverdrawSample {.passedSamples = result[0],
+                                 .pixelCount    = queries.coverageCounted ? result[2] : queries.screenPixels};
+    }
+    queries = {};
+  }
+
+  m_decision       = decideDepthPrepass(m_decision, sample, m_mode, m_stats.measurable, m_createInfo);
+  m_stats.overdraw = m_decision.overdraw;
+  m_stats.active   = m_decision.active;
+  return m_stats.active;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDepthPrepass::record(VuRenderer& vuRenderer, const VkCommandBuffer& cb, const u32 frameIndex) {
+  const VuDeferredRenderSpace& renderSpace = vuRenderer.m_deferredRenderSpace;
+  const VkExtent2D             extent      = renderSpace.m_vuSwapChain.m_extend2D;
+
+  if (m_stats.measurable) { vkCmdResetQueryPool(cb, m_queryPool, frameIndex * 2u, 2u); }
+  renderSpace.beginDepthPrepass(cb, vuRenderer.m_currentFrameImageIndex);
+  if (m_stats.measurable) { vkCmdBeginQuery(cb, m_queryPool, frameIndex * 2u, VK_QUERY_CONTROL_PRECISE_BIT); }
+
+  m_stats.drawCount = 0;
+  recordRenderQueue(vuRenderer, cb, frameIndex);
+  if (vuRenderer.m_gpuScene != nullptr) {
+    m_stats.drawCount += vuRenderer.m_gpuScene->recordDepthDraws(cb, frameIndex, *this);
+  }
+
+  if (m_stats.measurable) {
+    vkCmdEndQuery(cb, m_queryPool, frameIndex * 2u);
+    m_queries[frameIndex] = {.pending = true, .screenPixels = u64 {extent.width} * extent.height};
+  }
+  vkCmdEndRenderPass(cb);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDepthPrepass::beginCoverageQuery(const VkCommandBuffer& cb, const u32 frameIndex, const bool secondaryContents) {
+  // without the coverage the frame falls back to the screen pixels
+  if (!m_queries[frameIndex].pending || (secondaryContents && !m_canInheritQueries)) { return; }
+  vkCmdBeginQuery(cb, m_queryPool, frameIndex * 2u + 1u, VK_QUERY_CONTROL_PRECISE_BIT);
+  m_coverageQueryActive = true;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDepthPrepass::endCoverageQuery(const VkCommandBuffer& cb, const u32 frameIndex) {
+  if (!m_coverageQueryActive) { return; }
+  vkCmdEndQuery(cb, m_queryPool, frameIndex * 2u + 1u);
+  m_queries[frameIndex].coverageCounted = true;
+  m_coverageQueryActive                 = false;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDepthPrepass::recordRenderQueue(VuRenderer& vuRenderer, const VkCommandBuffer& cb, const u32 frameIndex) {
+  const VuRenderQueue& renderQueue    = vuRenderer.m_renderQueue;
+  const VuBuffer&      instanceBuffer = vuRenderer.m_instanceBuffers[frameIndex];
+  auto*                instances      = static_cast<GPU::InstanceData*>(instanceBuffer.m_mapPtr);
+  const u32            packetCount    = static_cast<u32>(renderQueue.size());
+
+  bool            pipelineBound {};
+  VkCullModeFlags boundCullMode {};
+  VkBuffer        boundIndexBuffer {nullptr};
+
+  u32 groupFirst = 0;
+  while (groupFirst < packetCount) {
+    const VuDrawPacket&     packet   = renderQueue.sortedPacket(groupFirst);
+    const MaterialSettings& settings = packet.material->m_materialSettings;
+    if (settings.isTransparent) {
+      groupFirst++;
+      continue;
+    }
+
+    // only mesh and cull mode matter for depth, neighbours of different materials share a draw
+    u32 groupEnd = groupFirst;
+    for (; groupEnd < packetCount; ++groupEnd) {
+      const VuDrawPacket&     other         = renderQueue.sortedPacket(groupEnd);
+      const MaterialSettings& otherSettings = other.material->m_materialSettings;
+      if (other.mesh != packet.mesh || otherSettings.isTransparent || otherSettings.cullMode != settings.cullMode) {
+        break;
+      }
+      if (!vuRenderer.m_mergeInstances && groupEnd != groupFirst) { break; }
+      instances[groupEnd] = other.instance;
+    }
+
+    if (!pipelineBound || settings.cullMode != boundCullMode) {
+      bindPipeline(cb, settings.cullMode);
+      pipelineBound = true;
+      boundCullMode = settings.cullMode;
+    }
+    const VkBuffer indexBuffer = packet.mesh->m_indexBuffer->m_buffer;
+    if (indexBuffer != boundIndexBuffer) {
+      vkCmdBindIndexBuffer(cb, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+      boundIndexBuffer = indexBuffer;
+    }
+
+    const GPU::PushConstant pushConstant {
+        .materialDataHandle   = packet.instance.materialDataHandle,
+        .mesh                 = {packet.mesh->m_vertexBuffer->m_bindlessIndex.value_or_THROW(),
+                                 packet.mesh->m_vertexCount,
+                                 ZERO_FLAG},
+        .instanceBufferHandle = instanceBuffer.m_bindlessIndex.value_or_THROW()};
+    vkCmdPushConstants(cb,
+                       m_pipelineLayout,
+                       VK_SHADER_STAGE_ALL,
+                       MakeVkOffset(0),
+                       sizeof(GPU::PushConstant),
+                       &pushConstant);
+    vkCmdDrawIndexed(cb, packet.indexCount, groupEnd - groupFirst, 0, 0, groupFirst);
+    m_stats.drawCount++;
+    groupFirst = groupEnd;
+  }
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuDepthPrepass::bindPipeline(const VkCommandBuffer& cb, const VkCullModeFlags cullMode) const {
+  const VuGraphicsPipeline& pipeline = m_pipelines.size() == 1 ? m_pipelines.front() : m_pipelines[cullMode];
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.m_pipeline);
+  VuRenderer::setDynamicRasterState(cb, *m_vuDevice, VuPipelineRasterState {.cullMode = cullMode}, 0);
+}
+} // namespace Vu
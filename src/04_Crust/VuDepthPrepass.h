@@ -0,0 +1,149 @@
+#pragma once
+#include <optional>
+#include <vector>
+
+#include "02_OuterCore/Common.h"
+#include "02_OuterCore/VuCommon.h"
+#include "03_Mantle/VuGraphicsPipeline.h"
+
+namespace Vu {
+struct VuRenderer;
+struct VuDevice;
+
+enum class VuDepthPrepassMode : u32 {
+  Off,
+  On,
+  // follows the measured overdraw, see VuDepthPrepassCreateInfo
+  Auto,
+};
+
+const char*
+toString(VuDepthPrepassMode mode);
+
+struct VuDepthPrepassCreateInfo {
+  path vertShaderPath {"assets/shaders/engine/depth_prepass_vert.slang"};
+  // auto mode turns the prepass on above the first overdraw and off again below the second
+  float enableOverdraw {1.5f};
+  float disableOverdraw {1.2f};
+  // while auto mode has the prepass off it still runs every this many frames to keep measuring
+  u32 probeInterval {60u};
+};
+
+struct VuDepthPrepassStats {
+  // depth samples that passed the prepass per covered pixel, what the gbuffer pass shades without it. smoothed
+  float overdraw {};
+  // the prepass runs in the frame being recorded
+  bool active {};
+  // false without precise occlusion queries, auto mode then keeps the prepass off
+  bool measurable {};
+  u32  drawCount {};
+};
+
+// samples that passed the prepass and the covered pixels they are divided by, read back from a completed frame
+struct VuOverdrawSample {
+  u64 passedSamples {};
+  u64 pixelCount {};
+};
+
+// auto mode state carried from one frame to the next
+struct VuDepthPrepassDecision {
+  // samples per covered pixel, smoothed
+  float overdraw {};
+  bool  hasMeasurement {};
+  // from the smoothed overdraw, probe frames run on top of it
+  bool  autoEnabled {};
+  // frames since the prepass last ran, probeInterval makes the next decision probe
+  u32   framesSinceActive {};
+  // the prepass runs in the frame being recorded
+  bool  active {};
+};
+
+// advances the decision by one frame. sample is the result of a prepass frame that completed since the last call, if
+// any. without measurable auto mode never turns the prepass on
+[[nodiscard]] VuDepthPrepassDecision
+decideDepthPrepass(const VuDepthPrepassDecision&          previous,
+                   const std::optional<VuOverdrawSample>& sample,
+                   VuDepthPrepassMode                     mode,
+                   bool                                   measurable,
+                   const VuDepthPrepassCreateInfo&        createInfo);
+
+struct VuDepthPrepassQueries {
+  bool pending {};
+  // the gbuffer pass counted the pixels it covered, otherwise the prepass samples are divided by the screen pixels
+  bool coverageCounted {};
+  u64  screenPixels {};
+};
+// #####################################################################################################################
+
+// Optional depth only pass before the gbuffer pass. It draws the opaque render queue and gpu scene objects with a
+// position only vertex shader, the gbuffer pass then tests EQUAL without writing depth and shades every pixel once.
+// Samples passing the prepass are counted with an occlusion query, which is the overdraw the gbuffer pass would have
+// without it. A second query around the EQUAL gbuffer pass counts one sample per covered pixel, so the overdraw does
+// not drop with the share of sky on screen. Owned and recorded by VuRenderer, transparent materials stay out of the
+// prepass.
+struct VuDepthPrepass {
+  std::shared_ptr<VuDevice>          m_vuDevice {};
+  VkPipelineLayout                   m_pipelineLayout {nullptr};
+  // indexed by VkCullModeFlags, a single pipeline when the device sets the cull mode dynamically
+  std::vector<VuGraphicsPipeline>    m_pipelines {};
+  // prepass samples and gbuffer pass coverage, two occlusion queries per frame in flight
+  VkQueryPool                        m_queryPool {nullptr};
+  std::vector<VuDepthPrepassQueries> m_queries {};
+  VuDepthPrepassMode                 m_mode {VuDepthPrepassMode::Off};
+  VuDepthPrepassStats                m_stats {};
+  VuDepthPrepassCreateInfo           m_createInfo {};
+  // the first update probes right away
+  VuDepthPrepassDecision             m_decision {};
+  // a gbuffer pass taking secondary command buffers can only be counted when they inherit the query
+  bool                               m_canInheritQueries {};
+  bool                               m_coverageQueryActive {};
+
+  SETUP_EXPECTED_WRAPPER(VuDepthPrepass,
+                         (VuRenderer& vuRenderer, const VuDepthPrepassCreateInfo& createInfo),
+                         (vuRenderer, createInfo))
+public:
+  VuDepthPrepass() = default;
+
+  VuDepthPrepass(const VuDepthPrepass&) = delete;
+
+  VuDepthPrepass&
+  operator=(const VuDepthPrepass&) = delete;
+
+  VuDepthPrepass(VuDepthPrepass&& other) noexcept;
+
+  VuDepthPrepass&
+  operator=(VuDepthPrepass&& other) noexcept;
+
+  ~VuDepthPrepass();
+
+  // reads the frame's last query result, the frame must have completed. returns whether the prepass runs this frame
+  bool
+  update(u32 frameIndex);
+
+  // outside of a render pass, after the render queue was sorted and its instance buffer reserved. leaves the depth
+  // for the gbuffer pass begun with depthPrepassed
+  void
+  record(VuRenderer& vuRenderer, const VkCommandBuffer& cb, u32 frameIndex);
+
+  // around the gbuffer pass of a frame the prepass was recorded in, outside of the render pass. secondary command
+  // buffers of the pass inherit the query while m_coverageQueryActive
+  void
+  beginCoverageQuery(const VkCommandBuffer& cb, u32 frameIndex, bool secondaryContents);
+
+  void
+  endCoverageQuery(const VkCommandBuffer& cb, u32 frameIndex);
+
+  // binds the depth only pipeline and sets the raster state the device leaves dynamic
+  void
+  bindPipeline(const VkCommandBuffer& cb, VkCullModeFlags cullMode) const;
+
+private:
+  VuDepthPrepass(VuRenderer& vuRenderer, const VuDepthPrepassCreateInfo& createInfo);
+
+  void
+  cleanup();
+
+  void
+  recordRenderQueue(VuRenderer& vuRenderer, const VkCommandBuffer& cb, u32 frameIndex);
+};
+} // namespace Vu
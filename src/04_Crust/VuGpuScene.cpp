@@ -0,0 +1,407 @@
+#include "VuGpuScene.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "02_OuterCore/VuConfig.h"
+#include "03_Mantle/VuDevice.h"
+#include "03_Mantle/VuImage.h"
+#include "03_Mantle/VuPhysicalDevice.h"
+#include "VuDepthPrepass.h"
+#include "VuMaterial.h"
+#include "VuMesh.h"
+#include "VuRenderer.h"
+
+namespace Vu {
+
+static constexpr u32 CULL_GROUP_SIZE = 64u;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// level 0 is half the depth resolution, every level rounds up so the last one is 1x1
+static std::vector<VkExtent2D>
+hzbLevelExtents(const VkExtent2D depthExtent) {
+  std::vector<VkExtent2D> levels {};
+  VkExtent2D              extent = depthExtent;
+  do {
+    extent = {(extent.width + 1) / 2, (extent.height + 1) / 2};
+    levels.push_back(extent);
+  } while (extent.width > 1 || extent.height > 1);
+  return levels;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void
+computeToComputeBarrier(const VkCommandBuffer& cb) {
+  VkMemoryBarrier barrier {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cb,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       ZERO_FLAG,
+                       1,
+                       &barrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuGpuScene::VuGpuScene(std::shared_ptr<VuRenderer> vuRenderer, const VuGpuSceneCreateInfo& createInfo) :
+    m_vuRenderer {vuRenderer},
+    m_objectIdAllocator {createInfo.maxObjectCount},
+    m_maxObjectCount {createInfo.maxObjectCount} {
+  const std::shared_ptr<VuDevice>& vuDevice = vuRenderer->m_vuDevice;
+  if (!vuRenderer->m_vuPhysicalDevice->m_supportsIndirectDraw) { throw VK_ERROR_FEATURE_NOT_PRESENT; }
+
+  m_cullPipeline = vuRenderer->createComputePipeline(createInfo.cullShaderPath);
+  m_hzbPipeline  = vuRenderer->createComputePipeline(createInfo.hzbShaderPath);
+
+  const VkDeviceSize maxObjectCount = createInfo.maxObjectCount;
+
+  m_visibility = move_or_THROW(VuBuffer::make(
+      vuDevice,
+      {.name         = "gpuSceneVisibility",
+       .sizeInBytes  = maxObjectCount * sizeof(u32),
+       .vkUsageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                       VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+       .memoryUsage  = VuMemoryUsage::GpuOnly}));
+
+  m_frames.resize(config::MAX_FRAMES_IN_FLIGHT);
+  for (VuGpuSceneFrame& frame : m_frames) {
+    frame.instances = move_or_THROW(VuBuffer::make(
+        vuDevice, {.name = "gpuSceneInstances", .sizeInBytes = maxObjectCount * sizeof(GPU::InstanceData)}));
+    frame.objects = move_or_THROW(VuBuffer::make(
+        vuDevice, {.name = "gpuSceneObjects", .sizeInBytes = maxObjectCount * sizeof(GPU::GpuObject)}));
+    THROW_if_fail(frame.instances.map());
+    THROW_if_fail(frame.objects.map());
+    // the vertex shader finds its instance data through the bindless table
+    vuRenderer->registerToBindless(frame.instances);
+
+    // worst case every object of the scene in its own command slot, once per phase
+    frame.commands = move_or_THROW(VuBuffer::make(
+        vuDevice,
+        {.name         = "gpuSceneCommands",
+         .sizeInBytes  = 2 * maxObjectCount * sizeof(GPU::DrawIndexedIndirectCommand),
+         .vkUsageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                         VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+         .memoryUsage  = VuMemoryUsage::GpuOnly}));
+    frame.drawCounts = move_or_THROW(VuBuffer::make(
+        vuDevice,
+        {.name         = "gpuSceneDrawCounts",
+         .sizeInBytes  = 2 * maxObjectCount * sizeof(u32),
+         .vkUsageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                         VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+         .memoryUsage  = VuMemoryUsage::GpuOnly}));
+    frame.stats = move_or_THROW(VuBuffer::make(
+        vuDevice,
+        {.name         = "gpuSceneCullStats",
+         .sizeInBytes  = sizeof(GPU::GpuCullStats),
+         .vkUsageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                         VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+         .memoryUsage  = VuMemoryUsage::Readback}));
+    THROW_if_fail(frame.stats.map());
+    std::memset(frame.stats.m_mapPtr, 0, sizeof(GPU::GpuCullStats));
+  }
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuGpuScene::~VuGpuScene() {
+  if (!m_vuRenderer) { return; }
+  for (VuGpuSceneFrame& frame : m_frames) {
+    m_vuRenderer->unregisterFromBindless(frame.instances);
+  }
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+u32
+VuGpuScene::addObject(const std::shared_ptr<VuMaterial>& material, VuMesh& mesh, const float4x4& model) {
+  const u32 objectId   = m_objectIdAllocator.allocate();
+  const u32 groupIndex = groupOf(material, mesh);
+  m_groups[groupIndex].objectCount++;
+
+  if (objectId >= m_objects.size()) {
+    m_objects.resize(objectId + 1);
+    m_instances.resize(objectId + 1);
+  }
+  m_instances[objectId] = {.model = model, .materialDataHandle = *material->m_materialDataHnd};
+  m_objects[objectId]   = {.boundingSphere = mesh.m_boundingSphere,
+                           .indexCount     = static_cast<u32>(mesh.m_indexBuffer->m_sizeInBytes / sizeof(u32)),
+                           .groupIndex     = groupIndex};
+  m_version++;
+  return objectId;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::setTransform(const u32 objectId, const float4x4& model) {
+  m_instances[objectId].model = model;
+  m_version++;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::removeObject(const u32 objectId) {
+  m_groups[m_objects[objectId].groupIndex].objectCount--;
+  m_objects[objectId] = {};
+  m_objectIdAllocator.deallocate(objectId);
+  m_version++;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+u32
+VuGpuScene::getObjectCount() const {
+  u32 count = 0;
+  for (const VuGpuDrawGroup& group : m_groups) {
+    count += group.objectCount;
+  }
+  return count;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool
+VuGpuScene::canOcclusionCull() const {
+  const VuDeferredRenderSpace& renderSpace = m_vuRenderer->m_deferredRenderSpace;
+  return renderSpace.m_gBufferLoadPass != nullptr && renderSpace.m_depthStencilImage->m_bindlessIndex.has_value();
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::recordCulling(const VkCommandBuffer& cb, const u32 frameIndex) {
+  VuGpuSceneFrame& frame = m_frames[frameIndex];
+  if (frame.uploadedVersion != m_version) { upload(frame); }
+
+  // counters of this frame's previous submit, only read once the timeline says it completed, never waited on here
+  if (m_vuRenderer->m_vuDevice->m_timeline->isComplete(m_vuRenderer->m_frameTimelineValues[frameIndex])) {
+    std::memcpy(&m_lastStats, frame.stats.m_mapPtr, sizeof(GPU::GpuCullStats));
+  }
+
+  const u32 objectSlotCount = static_cast<u32>(m_objects.size());
+  if (objectSlotCount == 0) {
+    m_lastStats = {};
+    return;
+  }
+
+  vkCmdFillBuffer(cb, frame.drawCounts.m_buffer, 0, VK_WHOLE_SIZE, 0);
+  vkCmdFillBuffer(cb, frame.stats.m_buffer, 0, VK_WHOLE_SIZE, 0);
+  // nothing counts as visible on the first frame, the late phase draws whatever survives the empty pyramid
+  if (!m_visibilityCleared) {
+    vkCmdFillBuffer(cb, m_visibility.m_buffer, 0, VK_WHOLE_SIZE, 0);
+    m_visibilityCleared = true;
+  }
+
+  // also orders against the late phase of the previous frame, which wrote the visibility read here
+  VkMemoryBarrier clearBarrier {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cb,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       ZERO_FLAG,
+                       1,
+                       &clearBarrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+
+  dispatchCull(cb, frame, canOcclusionCull() ? GPU::CullEarly : GPU::CullFrustumOnly);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::recordOcclusionCulling(const VkCommandBuffer& cb, const u32 frameIndex) {
+  VuGpuSceneFrame& frame = m_frames[frameIndex];
+  if (m_objects.empty()) { return; }
+
+  const VuDeferredRenderSpace&  renderSpace = m_vuRenderer->m_deferredRenderSpace;
+  const VkExtent2D              depthExtent = renderSpace.m_vuSwapChain.m_extend2D;
+  const std::vector<VkExtent2D> levels      = hzbLevelExtents(depthExtent);
+
+  if (frame.hzbExtent.width != depthExtent.width || frame.hzbExtent.height != depthExtent.height) {
+    VkDeviceSize texelCount = 0;
+    for (const VkExtent2D& level : levels) {
+      texelCount += static_cast<VkDeviceSize>(level.width) * level.height;
+    }
+    // the previous submit of this frame completed, nothing reads the old pyramid anymore
+    frame.hzb       = move_or_THROW(VuBuffer::make(m_vuRenderer->m_vuDevice,
+                                                   {.name        = "gpuSceneHzb",
+                                                    .sizeInBytes = texelCount * sizeof(float),
+                                                    .memoryUsage = VuMemoryUsage::GpuOnly}));
+    frame.hzbExtent = depthExtent;
+  }
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, m_hzbPipeline.m_pipeline);
+  m_vuRenderer->bindGlobalBindlessSet(cb, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+  const VkDeviceAddress hzbAddress = frame.hzb.getDeviceAddress();
+  VkDeviceSize          srcOffset  = 0;
+  VkDeviceSize          dstOffset  = 0;
+  VkExtent2D            srcExtent  = depthExtent;
+  for (u32 level = 0; level < levels.size(); ++level) {
+    const GPU::HzbBuildPushConstant pushConstant {
+        .dst          = hzbAddress + dstOffset * sizeof(float),
+        .src          = hzbAddress + srcOffset * sizeof(float),
+        .srcWidth     = srcExtent.width,
+        .srcHeight    = srcExtent.height,
+        .dstWidth     = levels[level].width,
+        .dstHeight    = levels[level].height,
+        .depthTexture = renderSpace.m_depthStencilImage->m_bindlessIndex.value_or_THROW(),
+        .fromDepth    = level == 0 ? 1u : 0u};
+    vkCmdPushConstants(cb,
+                       m_vuRenderer->m_globalPipelineLayout,
+                       VK_SHADER_STAGE_ALL,
+                       MakeVkOffset(0),
+                       sizeof(pushConstant),
+                       &pushConstant);
+    vkCmdDispatch(cb, (levels[level].width + 7) / 8, (levels[level].height + 7) / 8, 1);
+    computeToComputeBarrier(cb);
+
+    srcOffset = dstOffset;
+    dstOffset += static_cast<VkDeviceSize>(levels[level].width) * levels[level].height;
+    srcExtent = levels[level];
+  }
+
+  dispatchCull(cb, frame, GPU::CullLate);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::recordDraws(const VkCommandBuffer& cb, const u32 frameIndex, const GPU::GpuCullPhase phase) const {
+  const VuRenderer& vuRenderer = *m_vuRenderer;
+  // the late phase draws after the gbuffer pass ended, depth is tested and written normally again
+  const bool depthPrepassed = phase == GPU::CullEarly && vuRenderer.m_gBufferDepthPrepassed;
+
+  for (u32 groupIndex = 0; groupIndex < m_groups.size(); ++groupIndex) {
+    const VuGpuDrawGroup& group = m_groups[groupIndex];
+    if (group.objectCount == 0) { continue; }
+
+    VuGraphicsPipeline* vuPipeline = vuRenderer.requestGBufferPipeline(*group.material, depthPrepassed);
+    if (vuPipeline == nullptr) { continue; }
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vuPipeline->m_pipeline);
+    VuRenderer::setDynamicRasterState(cb, *vuRenderer.m_vuDevice, *group.material, depthPrepassed);
+    recordGroupDraw(cb, m_frames[frameIndex], phase, groupIndex);
+  }
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+u32
+VuGpuScene::recordDepthDraws(const VkCommandBuffer& cb,
+                             const u32              frameIndex,
+                             const VuDepthPrepass&  depthPrepass) const {
+  u32 drawCount = 0;
+  for (u32 groupIndex = 0; groupIndex < m_groups.size(); ++groupIndex) {
+    const VuGpuDrawGroup&   group    = m_groups[groupIndex];
+    const MaterialSettings& settings = group.material->m_materialSettings;
+    if (group.objectCount == 0 || settings.isTransparent) { continue; }
+
+    depthPrepass.bindPipeline(cb, settings.cullMode);
+    recordGroupDraw(cb, m_frames[frameIndex], GPU::CullEarly, groupIndex);
+    drawCount++;
+  }
+  return drawCount;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::recordGroupDraw(const VkCommandBuffer&  cb,
+                            const VuGpuSceneFrame&  frame,
+                            const GPU::GpuCullPhase phase,
+                            const u32               groupIndex) const {
+  const VuGpuDrawGroup& group = m_groups[groupIndex];
+  // the late phase writes the second half of the command and count buffers
+  const VkDeviceSize phaseSlot = phase == GPU::CullLate ? m_maxObjectCount : 0;
+
+  vkCmdBindIndexBuffer(cb, group.mesh->m_indexBuffer->m_buffer, 0, VK_INDEX_TYPE_UINT32);
+
+  const GPU::PushConstant pushConstant {
+      .materialDataHandle   = *group.material->m_materialDataHnd,
+      .mesh                 = {group.mesh->m_vertexBuffer->m_bindlessIndex.value_or_THROW(),
+                               group.mesh->m_vertexCount,
+                               ZERO_FLAG},
+      .instanceBufferHandle = frame.instances.m_bindlessIndex.value_or_THROW()};
+  vkCmdPushConstants(cb,
+                     m_vuRenderer->m_globalPipelineLayout,
+                     VK_SHADER_STAGE_ALL,
+                     MakeVkOffset(0),
+                     sizeof(GPU::PushConstant),
+                     &pushConstant);
+
+  vkCmdDrawIndexedIndirectCount(cb,
+                                frame.commands.m_buffer,
+                                (phaseSlot + group.commandOffset) * sizeof(GPU::DrawIndexedIndirectCommand),
+                                frame.drawCounts.m_buffer,
+                                (phaseSlot + groupIndex) * sizeof(u32),
+                                group.objectCount,
+                                sizeof(GPU::DrawIndexedIndirectCommand));
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+u32
+VuGpuScene::groupOf(const std::shared_ptr<VuMaterial>& material, VuMesh& mesh) {
+  for (u32 i = 0; i < m_groups.size(); ++i) {
+    if (m_groups[i].material == material && m_groups[i].mesh == &mesh) { return i; }
+  }
+  // groups emptied by removeObject are handed out again, so there are never more groups than objects
+  for (u32 i = 0; i < m_groups.size(); ++i) {
+    if (m_groups[i].objectCount == 0) {
+      m_groups[i] = {.material = material, .mesh = &mesh};
+      return i;
+    }
+  }
+  m_groups.push_back({.material = material, .mesh = &mesh});
+  return static_cast<u32>(m_groups.size() - 1);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::upload(VuGpuSceneFrame& frame) {
+  // every group gets as many command slots as it has objects, in group order
+  u32 commandOffset = 0;
+  for (VuGpuDrawGroup& group : m_groups) {
+    group.commandOffset = commandOffset;
+    commandOffset += group.objectCount;
+  }
+  for (GPU::GpuObject& object : m_objects) {
+    if (object.indexCount != 0) { object.commandOffset = m_groups[object.groupIndex].commandOffset; }
+  }
+
+  std::memcpy(frame.instances.m_mapPtr, m_instances.data(), m_instances.size() * sizeof(GPU::InstanceData));
+  std::memcpy(frame.objects.m_mapPtr, m_objects.data(), m_objects.size() * sizeof(GPU::GpuObject));
+  frame.uploadedVersion = m_version;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuGpuScene::dispatchCull(const VkCommandBuffer& cb, const VuGpuSceneFrame& frame, const GPU::GpuCullPhase phase) const {
+  const u32          objectSlotCount = static_cast<u32>(m_objects.size());
+  const VkDeviceSize phaseSlot       = phase == GPU::CullLate ? m_maxObjectCount : 0;
+  const bool         hasHzb          = phase == GPU::CullLate;
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline.m_pipeline);
+  m_vuRenderer->bindGlobalBindlessSet(cb, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+  const GPU::GpuCullPushConstant pushConstant {
+      .instances     = frame.instances.getDeviceAddress(),
+      .objects       = frame.objects.getDeviceAddress(),
+      .commands      = frame.commands.getDeviceAddress() + phaseSlot * sizeof(GPU::DrawIndexedIndirectCommand),
+      .drawCounts    = frame.drawCounts.getDeviceAddress() + phaseSlot * sizeof(u32),
+      .visibility    = m_visibility.getDeviceAddress(),
+      .stats         = frame.stats.getDeviceAddress(),
+      .hzb           = hasHzb ? frame.hzb.getDeviceAddress() : 0,
+      .objectCount   = objectSlotCount,
+      .phase         = phase,
+      .depthWidth    = frame.hzbExtent.width,
+      .depthHeight   = frame.hzbExtent.height,
+      .hzbLevelCount = hasHzb ? static_cast<u32>(hzbLevelExtents(frame.hzbExtent).size()) : 0};
+  vkCmdPushConstants(cb,
+                     m_vuRenderer->m_globalPipelineLayout,
+                     VK_SHADER_STAGE_ALL,
+                     MakeVkOffset(0),
+                     sizeof(pushConstant),
+                     &pushConstant);
+  vkCmdDispatch(cb, (objectSlotCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+  // the counters of the last phase are read on the cpu once the frame timeline value is reached
+  VkMemoryBarrier cullBarrier {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(cb,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                       ZERO_FLAG,
+                       1,
+                       &cullBarrier,
+                       0,
+                       nullptr,
+                       0,
+                       nullptr);
+}
+} // namespace Vu
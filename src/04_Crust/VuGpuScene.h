@@ -0,0 +1,138 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "01_InnerCore/IndexAllocator.h"
+#include "02_OuterCore/Common.h"
+#include "02_OuterCore/VuCommon.h"
+#include "03_Mantle/VuBuffer.h"
+#include "03_Mantle/VuComputePipeline.h"
+#include "InteroptStructs.h"
+
+namespace Vu {
+struct VuRenderer;
+struct VuDepthPrepass;
+struct VuMaterial;
+struct VuMesh;
+
+struct VuGpuSceneCreateInfo {
+  u32  maxObjectCount {1u << 16};
+  path cullShaderPath {"assets/shaders/engine/gpu_driven/gpu_cull_comp.slang"};
+  path hzbShaderPath {"assets/shaders/engine/gpu_driven/hzb_build_comp.slang"};
+};
+
+// objects sharing material and mesh, drawn by one vkCmdDrawIndexedIndirectCount
+struct VuGpuDrawGroup {
+  std::shared_ptr<VuMaterial> material {};
+  VuMesh*                     mesh {};
+  u32                         objectCount {};
+  // first command slot, recomputed from the object counts on upload
+  u32 commandOffset {};
+};
+
+// buffers of one frame in flight, objects and instances are rewritten only when the scene changed
+struct VuGpuSceneFrame {
+  VuBuffer instances {};
+  VuBuffer objects {};
+  // early phase commands and counts first, late phase ones in the second half
+  VuBuffer commands {};
+  VuBuffer drawCounts {};
+  VuBuffer stats {};
+  // max depth pyramid of this frame's depth, rebuilt when the extent changes
+  VuBuffer   hzb {};
+  VkExtent2D hzbExtent {};
+  u64        uploadedVersion {};
+};
+// #####################################################################################################################
+
+// Persistent objects culled and turned into indirect draws on the GPU, recording cost depends on the number of
+// material/mesh pairs only. The renderer records it around the gbuffer pass once set as VuRenderer::m_gpuScene.
+// With stored depth culling runs in two phases: the objects visible last frame are drawn first, a depth pyramid is
+// built from that depth and the remaining objects are tested against it, the newly visible ones are drawn on top.
+struct VuGpuScene {
+  std::shared_ptr<VuRenderer>    m_vuRenderer {};
+  VuComputePipeline              m_cullPipeline {};
+  VuComputePipeline              m_hzbPipeline {};
+  std::vector<VuGpuSceneFrame>   m_frames {};
+  // one uint per object id, written by the late phase and read by the next frame's early phase
+  VuBuffer                       m_visibility {};
+  bool                           m_visibilityCleared {};
+  // counters of the last completed frame read back into this slot
+  GPU::GpuCullStats              m_lastStats {};
+  std::vector<VuGpuDrawGroup>    m_groups {};
+  // indexed by object id, free slots have a zero index count
+  std::vector<GPU::InstanceData> m_instances {};
+  std::vector<GPU::GpuObject>    m_objects {};
+  IndexAllocator                 m_objectIdAllocator {1};
+  u32                            m_maxObjectCount {};
+  // bumped by every change, frames whose upload is older copy the cpu arrays again
+  u64                            m_version {1};
+
+  SETUP_EXPECTED_WRAPPER(VuGpuScene,
+                         (std::shared_ptr<VuRenderer> vuRenderer, const VuGpuSceneCreateInfo& createInfo),
+                         (vuRenderer, createInfo))
+public:
+  VuGpuScene()                  = default;
+  VuGpuScene(const VuGpuScene&) = delete;
+  VuGpuScene&
+  operator=(const VuGpuScene&) = delete;
+
+  VuGpuScene(VuGpuScene&& other) noexcept = default;
+  VuGpuScene&
+  operator=(VuGpuScene&& other) noexcept = default;
+
+  ~VuGpuScene();
+
+  // returns the object id, throws when maxObjectCount is reached
+  u32
+  addObject(const std::shared_ptr<VuMaterial>& material, VuMesh& mesh, const float4x4& model);
+
+  void
+  setTransform(u32 objectId, const float4x4& model);
+
+  void
+  removeObject(u32 objectId);
+
+  [[nodiscard]] u32
+  getObjectCount() const;
+
+  // true when the gbuffer depth survives the pass and can be sampled, otherwise only frustum culling runs
+  [[nodiscard]] bool
+  canOcclusionCull() const;
+
+  // outside of a render pass, fills the frame's early phase indirect commands and draw counts
+  void
+  recordCulling(const VkCommandBuffer& cb, u32 frameIndex);
+
+  // after the first gbuffer pass ended, builds the depth pyramid and fills the late phase commands
+  void
+  recordOcclusionCulling(const VkCommandBuffer& cb, u32 frameIndex);
+
+  // inside a gbuffer pass, after the culling of the same phase was recorded
+  void
+  recordDraws(const VkCommandBuffer& cb, u32 frameIndex, GPU::GpuCullPhase phase = GPU::CullEarly) const;
+
+  // inside the depth prepass, the early phase objects of opaque materials. returns the number of indirect draws
+  u32
+  recordDepthDraws(const VkCommandBuffer& cb, u32 frameIndex, const VuDepthPrepass& depthPrepass) const;
+
+private:
+  VuGpuScene(std::shared_ptr<VuRenderer> vuRenderer, const VuGpuSceneCreateInfo& createInfo);
+
+  u32
+  groupOf(const std::shared_ptr<VuMaterial>& material, VuMesh& mesh);
+
+  void
+  upload(VuGpuSceneFrame& frame);
+
+  // index buffer, push constants and the indirect draw of one group, the pipeline is already bound
+  void
+  recordGroupDraw(const VkCommandBuffer& cb,
+                  const VuGpuSceneFrame& frame,
+                  GPU::GpuCullPhase      phase,
+                  u32                    groupIndex) const;
+
+  void
+  dispatchCull(const VkCommandBuffer& cb, const VuGpuSceneFrame& frame, GPU::GpuCullPhase phase) const;
+};
+} // namespace Vu
@@ -0,0 +1,89 @@
+#include "VuLightClusters.h"
+
+#include <algorithm>
+
+#include "02_OuterCore/VuConfig.h"
+#include "03_Mantle/VuDevice.h"
+#include "VuRenderer.h"
+
+namespace Vu {
+
+static constexpr u32 INITIAL_LIGHT_CAPACITY = 256u;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+VuLightClusters::VuLightClusters(VuRenderer& vuRenderer, const VuLightClustersCreateInfo& createInfo) :
+    m_createInfo {createInfo} {
+  m_assignPipeline = vuRenderer.createComputePipeline(createInfo.assignShaderPath);
+
+  // a light count and maxLightsPerCluster indices per cluster
+  const VkDeviceSize clusterListBytes =
+      VkDeviceSize {getClusterCount()} * (1 + createInfo.maxLightsPerCluster) * sizeof(u32);
+
+  m_frames.resize(config::MAX_FRAMES_IN_FLIGHT);
+  for (VuLightClustersFrame& frame : m_frames) {
+    reserveLightBuffer(vuRenderer, frame, INITIAL_LIGHT_CAPACITY);
+    frame.clusters = move_or_THROW(VuBuffer::make(vuRenderer.m_vuDevice,
+                                                  {.name        = "lightClusters",
+                                                   .sizeInBytes = clusterListBytes,
+                                                   .memoryUsage = VuMemoryUsage::GpuOnly}));
+    vuRenderer.registerToBindless(frame.clusters);
+  }
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+u32
+VuLightClusters::getClusterCount() const {
+  return m_createInfo.countX * m_createInfo.countY * m_createInfo.countZ;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+GPU::LightClusterInfo
+VuLightClusters::record(VuRenderer&                            vuRenderer,
+                        const VkCommandBuffer&                 cb,
+                        const u32                              frameIndex,
+                        const std::span<const GPU::PointLight> lights,
+                        const bool                             enabled) {
+  VuLightClustersFrame& frame      = m_frames[frameIndex];
+  const u32             lightCount = static_cast<u32>(lights.size());
+
+  reserveLightBuffer(vuRenderer, frame, lightCount);
+  if (lightCount != 0) { THROW_if_fail(frame.lights.setData(lights.data(), lights.size_bytes())); }
+
+  const GPU::LightClusterInfo info {.lightBufferHandle   = frame.lights.m_bindlessIndex.value_or_THROW(),
+                                    .lightCount          = lightCount,
+                                    .clusterBufferHandle = frame.clusters.m_bindlessIndex.value_or_THROW(),
+                                    .countX              = m_createInfo.countX,
+                                    .countY              = m_createInfo.countY,
+                                    .countZ              = m_createInfo.countZ,
+                                    .maxLightsPerCluster = m_createInfo.maxLightsPerCluster,
+                                    .enabled             = enabled ? 1u : 0u};
+  if (!enabled) { return info; }
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, m_assignPipeline.m_pipeline);
+  vuRenderer.bindGlobalBindlessSet(cb, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+  const GPU::LightAssignPushConstant pushConstant {.lights   = frame.lights.getDeviceAddress(),
+                                                   .clusters = frame.clusters.getDeviceAddress()};
+  vkCmdPushConstants(cb,
+                     vuRenderer.m_globalPipelineLayout,
+                     VK_SHADER_STAGE_ALL,
+                     MakeVkOffset(0),
+                     sizeof(pushConstant),
+                     &pushConstant);
+  vkCmdDispatch(cb, m_createInfo.countX, m_createInfo.countY, m_createInfo.countZ);
+  return info;
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+VuLightClusters::reserveLightBuffer(VuRenderer& vuRenderer, VuLightClustersFrame& frame, const u32 lightCount) {
+  const VkDeviceSize requiredSize = VkDeviceSize {std::max(lightCount, 1u)} * sizeof(GPU::PointLight);
+  if (frame.lights.m_buffer != VK_NULL_HANDLE && frame.lights.m_sizeInBytes >= requiredSize) { return; }
+
+  const VkDeviceSize size = std::max({requiredSize,
+                                      VkDeviceSize {frame.lights.m_sizeInBytes * 2},
+                                      VkDeviceSize {INITIAL_LIGHT_CAPACITY * sizeof(GPU::PointLight)}});
+
+  vuRenderer.unregisterFromBindless(frame.lights);
+  frame.lights = move_or_THROW(VuBuffer::make(vuRenderer.m_vuDevice, {.name = "pointLights", .sizeInBytes = size}));
+  THROW_if_fail(frame.lights.map());
+  vuRenderer.registerToBindless(frame.lights);
+}
+} // namespace Vu
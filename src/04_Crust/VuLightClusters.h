@@ -0,0 +1,75 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "02_OuterCore/Common.h"
+#include "02_OuterCore/VuCommon.h"
+#include "03_Mantle/VuBuffer.h"
+#include "03_Mantle/VuComputePipeline.h"
+#include "InteroptStructs.h"
+
+namespace Vu {
+struct VuRenderer;
+
+struct VuLightClustersCreateInfo {
+  // screen tiles in x and y, exponential depth slices between the camera planes in z
+  u32  countX {16u};
+  u32  countY {9u};
+  u32  countZ {24u};
+  // lights past this count are dropped from a cluster
+  u32  maxLightsPerCluster {256u};
+  path assignShaderPath {"assets/shaders/engine/deferred_render_space/cluster_light_assign_comp.slang"};
+};
+
+// buffers of one frame in flight
+struct VuLightClustersFrame {
+  // copy of the renderer's lights, grows with the light count
+  VuBuffer lights {};
+  // written by the assignment pass only, see GPU::LightClusterInfo for the layout
+  VuBuffer clusters {};
+};
+// #####################################################################################################################
+
+// Clustered light culling for the deferred lighting pass. The lights are copied into a bindless storage buffer every
+// frame and a compute pass builds the light list of every froxel, the lighting pass then only shades the lights of
+// the pixel's cluster. Owned and recorded by VuRenderer, the lights themselves are VuRenderer::m_pointLights.
+struct VuLightClusters {
+  VuComputePipeline                 m_assignPipeline {};
+  std::vector<VuLightClustersFrame> m_frames {};
+  VuLightClustersCreateInfo         m_createInfo {};
+
+  SETUP_EXPECTED_WRAPPER(VuLightClusters,
+                         (VuRenderer& vuRenderer, const VuLightClustersCreateInfo& createInfo),
+                         (vuRenderer, createInfo))
+public:
+  VuLightClusters()                       = default;
+  VuLightClusters(const VuLightClusters&) = delete;
+  VuLightClusters&
+  operator=(const VuLightClusters&) = delete;
+
+  VuLightClusters(VuLightClusters&& other) noexcept = default;
+  VuLightClusters&
+  operator=(VuLightClusters&& other) noexcept = default;
+
+  ~VuLightClusters() = default;
+
+  [[nodiscard]] u32
+  getClusterCount() const;
+
+  // outside of a render pass, uploads the lights and fills the cluster lists of the frame. returns what the shaders
+  // read from GPU::FrameConstant::lightClusters, which has to reach the frame constant buffer before the submit
+  GPU::LightClusterInfo
+  record(VuRenderer&                      vuRenderer,
+         const VkCommandBuffer&           cb,
+         u32                              frameIndex,
+         std::span<const GPU::PointLight> lights,
+         bool                             enabled);
+
+private:
+  VuLightClusters(VuRenderer& vuRenderer, const VuLightClustersCreateInfo& createInfo);
+
+  // the frame that last used the buffer completed, only its bindless slot has to age
+  void
+  reserveLightBuffer(VuRenderer& vuRenderer, VuLightClustersFrame& frame, u32 lightCount);
+};
+} // namespace Vu
@@ -12,5 +12,6 @@ Vu::VuMaterial::VuMaterial(MaterialSettings                             matSetti
                            const std::shared_ptr<VuShader>&             shaderHnd,
                            const std::shared_ptr<GPU::VuMaterialDataHandle>& materialDataHnd)
     : m_materialSettings {matSettings}, m_shaderHnd {shaderHnd}, m_materialDataHnd {materialDataHnd} {
-  VuGraphicsPipeline& unused = shaderHnd.get()->requestPipeline(m_materialSettings);
+  // compiles in the background, draws with this material are skipped or use a fallback until it is ready
+  shaderHnd->precompilePipelines(std::span(&m_materialSettings, 1));
 }
@@ -7,6 +7,7 @@
 #include <variant>
 
 #include "02_OuterCore/VuCommon.h"
+#include "03_Mantle/VuGraphicsPipeline.h"
 #include "03_Mantle/VuTypes.h"
 #include "InteroptStructs.h"
 
@@ -16,10 +17,25 @@ struct VuShader;
 struct MaterialSettings {
   bool            isTransparent = false;
   VkCullModeFlags cullMode      = VK_CULL_MODE_BACK_BIT;
+  // set by the renderer for the gbuffer pass that follows a depth prepass, not by materials
+  bool depthPrepassed = false;
+
+  // transparent surfaces blend over what is behind them and leave depth untouched
+  // opaque ones after a depth prepass only shade the depth it laid down, transparent ones are not part of it
+  [[nodiscard]] VuPipelineRasterState
+  toRasterState() const {
+    const bool testEqual = depthPrepassed && !isTransparent;
+    return {.cullMode       = cullMode,
+            .depthTest      = true,
+            .depthWrite     = !isTransparent && !testEqual,
+            .depthCompareOp = testEqual ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS_OR_EQUAL,
+            .blendEnable    = isTransparent};
+  }
 
   friend bool
   operator==(const MaterialSettings& lhs, const MaterialSettings& rhs) {
-    return lhs.isTransparent == rhs.isTransparent && lhs.cullMode == rhs.cullMode;
+    return lhs.isTransparent == rhs.isTransparent && lhs.cullMode == rhs.cullMode &&
+           lhs.depthPrepassed == rhs.depthPrepassed;
   }
 
   friend bool
@@ -32,6 +48,7 @@ struct MaterialSettings {
     std::size_t seed = 0x305407C8;
     seed ^= (seed << 6) + (seed >> 2) + 0x42B03DC4 + static_cast<std::size_t>(obj.isTransparent);
     seed ^= (seed << 6) + (seed >> 2) + 0x29CD679B + static_cast<uint32_t>(obj.cullMode);
+    seed ^= (seed << 6) + (seed >> 2) + 0x1B873593 + static_cast<std::size_t>(obj.depthPrepassed);
     return seed;
   }
 };
@@ -57,8 +74,9 @@ template <> struct hash<Vu::MaterialSettings> {
   operator()(const Vu::MaterialSettings& settings) const noexcept {
     std::size_t h1 = std::hash<bool>()(settings.isTransparent);
     std::size_t h2 = std::hash<uint32_t>()(static_cast<uint32_t>(settings.cullMode));
+    std::size_t h3 = std::hash<bool>()(settings.depthPrepassed);
 
-    return h1 ^ (h2 << 1);
+    return h1 ^ (h2 << 1) ^ (h3 << 2);
   }
 };
 } // namespace std
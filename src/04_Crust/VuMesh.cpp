@@ -1,5 +1,7 @@
 #include "VuMesh.h"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "01_InnerCore/TypeDefs.h"
@@ -27,6 +29,24 @@ VkDeviceSize
 VuMesh::getUV_OffsetAsByte() const {
   return (sizeof(float3) + sizeof(float3) + sizeof(float4)) * m_vertexCount;
 }
+float4
+VuMesh::calculateBoundingSphere(const std::span<const float3> positions) {
+  if (positions.empty()) { return float4(0, 0, 0, 0); }
+
+  float3 minPos = positions[0];
+  float3 maxPos = positions[0];
+  for (const float3& pos : positions) {
+    minPos = float3(std::min(minPos.x, pos.x), std::min(minPos.y, pos.y), std::min(minPos.z, pos.z));
+    maxPos = float3(std::max(maxPos.x, pos.x), std::max(maxPos.y, pos.y), std::max(maxPos.z, pos.z));
+  }
+  const float3 center = (minPos + maxPos) * 0.5f;
+
+  float radiusSquared = 0.0f;
+  for (const float3& pos : positions) {
+    radiusSquared = std::max(radiusSquared, Math::lengthSquared(pos - center));
+  }
+  return float4(center, std::sqrt(radiusSquared));
+}
 void
 VuMesh::calculateTangents(const std::span<u32>    indices,
                           const std::span<float3> positions,
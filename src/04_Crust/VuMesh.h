@@ -12,6 +12,8 @@ struct VuMesh {
   uint32_t                  m_vertexCount {};
   std::shared_ptr<VuBuffer> m_indexBuffer {};
   std::shared_ptr<VuBuffer> m_vertexBuffer {};
+  // mesh space center in xyz, radius in w
+  float4 m_boundingSphere {};
 
   static VkDeviceSize
   totalAttributesSizePerVertex();
@@ -25,6 +27,10 @@ struct VuMesh {
   [[nodiscard]] VkDeviceSize
   getUV_OffsetAsByte() const;
 
+  // centered on the bounding box, loose but cheap
+  static float4
+  calculateBoundingSphere(std::span<const float3> positions);
+
   static void
   calculateTangents(const std::span<uint32_t> indices,
                     const std::span<float3>   positions,
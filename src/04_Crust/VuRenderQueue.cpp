@@ -0,0 +1,57 @@
+#include "VuRenderQueue.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace Vu {
+
+u64
+VuRenderQueue::makeSortKey(u32 pass, u32 pipelineId, u32 materialId, u32 meshId, float viewDepth) {
+  // bit pattern of a non negative float grows with its value, the top half is enough to order draws
+  const u32 depthBits = std::bit_cast<u32>(std::max(viewDepth, 0.0f)) >> 16;
+
+  return (static_cast<u64>(pass & 0xF) << 60) | (static_cast<u64>(pipelineId & 0xFFF) << 48) |
+         (static_cast<u64>(materialId & 0xFFFF) << 32) | (static_cast<u64>(meshId & 0xFFFF) << 16) | depthBits;
+}
+
+void
+VuRenderQueue::push(VuDeferredPass pass, const VuDrawPacket& packet, float viewDepth) {
+  const u64 key = makeSortKey(pass,
+                              idOf(m_pipelineIds, packet.pipeline),
+                              idOf(m_materialIds, packet.material),
+                              idOf(m_meshIds, packet.mesh),
+                              viewDepth);
+  m_items.push_back({key, static_cast<u32>(m_packets.size())});
+  m_packets.push_back(packet);
+}
+
+void
+VuRenderQueue::sort(ThreadPool* pool) {
+  m_scratch.resize(m_items.size());
+  radixSort(m_items, m_scratch, pool);
+}
+
+size_t
+VuRenderQueue::size() const {
+  return m_packets.size();
+}
+
+const VuDrawPacket&
+VuRenderQueue::sortedPacket(size_t index) const {
+  return m_packets[m_items[index].value];
+}
+
+void
+VuRenderQueue::clear() {
+  m_packets.clear();
+  m_items.clear();
+  m_pipelineIds.clear();
+  m_materialIds.clear();
+  m_meshIds.clear();
+}
+
+u32
+VuRenderQueue::idOf(std::unordered_map<const void*, u32>& ids, const void* object) {
+  return ids.try_emplace(object, static_cast<u32>(ids.size())).first->second;
+}
+} // namespace Vu
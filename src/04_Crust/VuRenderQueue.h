@@ -0,0 +1,80 @@
+#pragma once
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "01_InnerCore/RadixSort.h"
+#include "01_InnerCore/TypeDefs.h"
+#include "02_OuterCore/VuCommon.h"
+#include "InteroptStructs.h"
+#include "VuDeferredRenderSpace.h"
+
+struct ThreadPool;
+
+namespace Vu {
+struct VuMaterial;
+struct VuMesh;
+
+// one object, consecutive packets sharing pipeline, material and mesh after sorting become one instanced draw
+struct VuDrawPacket {
+  VkPipeline        pipeline {nullptr};
+  VuMaterial*       material {};
+  VuMesh*           mesh {};
+  u32               indexCount {};
+  GPU::InstanceData instance {};
+};
+
+// what the last flushed queue did, skipped binds are the ones state sorting saved
+struct VuRenderQueueStats {
+  u32 drawCount {};
+  u32 instanceCount {};
+  u32 pipelineBinds {};
+  u32 pipelineBindsSkipped {};
+  u32 indexBufferBinds {};
+  u32 indexBufferBindsSkipped {};
+  // secondary command buffers the gbuffer draws were recorded into, zero when recorded inline
+  u32   secondaryCommandBuffers {};
+  // cpu time from sorted queue to recorded commands
+  float recordMilliseconds {};
+};
+// #####################################################################################################################
+
+// Draws of one frame, recorded in sort key order so that draws sharing state end up next to each other.
+struct VuRenderQueue {
+private:
+  std::vector<VuDrawPacket>  m_packets {};
+  std::vector<RadixSortItem> m_items {};
+  std::vector<RadixSortItem> m_scratch {};
+  // dense ids in first seen order, they fit the key fields where pointers would not
+  std::unordered_map<const void*, u32> m_pipelineIds {};
+  std::unordered_map<const void*, u32> m_materialIds {};
+  std::unordered_map<const void*, u32> m_meshIds {};
+
+public:
+  // from the most significant bit: pass 4, pipeline 12, material 16, mesh 16, depth 16.
+  // ids past a field width wrap, which only costs sorting quality
+  static u64
+  makeSortKey(u32 pass, u32 pipelineId, u32 materialId, u32 meshId, float viewDepth);
+
+  // viewDepth is any value growing with distance to the camera, opaque draws go front to back
+  void
+  push(VuDeferredPass pass, const VuDrawPacket& packet, float viewDepth);
+
+  void
+  sort(ThreadPool* pool);
+
+  [[nodiscard]] size_t
+  size() const;
+
+  // valid after sort
+  [[nodiscard]] const VuDrawPacket&
+  sortedPacket(size_t index) const;
+
+  void
+  clear();
+
+private:
+  static u32
+  idOf(std::unordered_map<const void*, u32>& ids, const void* object);
+};
+} // namespace Vu
@@ -3,6 +3,9 @@
 #include <algorithm> // for fill
 #include <array>     // for array
 #include <assert.h>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <expected> // for expected
 #include <functional>
 #include <iostream> // for char_traits, basic_ostream
@@ -13,6 +16,7 @@
 #include <vector>    // for vector
 
 #include "01_InnerCore/ScopeTimer.h"
+#include "01_InnerCore/VuLogger.h"
 #include "02_OuterCore/Color32.h"     // for Color32
 #include "02_OuterCore/FixedString.h" // for FixedString
 #include "02_OuterCore/VuCommon.h"
@@ -26,6 +30,7 @@
 #include "03_Mantle/VuSampler.h"   // for VuSampler
 #include "03_Mantle/VuSwapChain.h" // for VuSwapChain2
 #include "04_Crust/VuDeferredRenderSpace.h"
+#include "04_Crust/VuGpuScene.h"
 #include "04_Crust/VuShader.h" // for VuShader
 #include "imgui.h"             // for GetDrawData, NewFrame, Render
 #include "imgui_impl_sdl3.h"   // for ImGui_ImplSDL3_NewFrame
@@ -41,6 +46,13 @@
 #include "VuMesh.h"            // for VuMesh
 
 namespace Vu {
+namespace {
+// exponential moving average, about the last ten frames
+void
+smoothLatency(float& average, const float sampleMs) {
+  average += (sampleMs - average) * 0.1f;
+}
+} // namespace
 //======================================================================================================================
 VuRenderer::VuRenderer(const VuRendererCreateInfo& createInfo) :
     m_imgBindlessIndexAllocator {createInfo.sampledImageCount, std::pmr::new_delete_resource()},
@@ -93,18 +105,67 @@ VuRenderer::VuRenderer(const VuRendererCreateInfo& createInfo) :
   // device
   VuDeviceCreateFeatureChain defaultFeatureChain {};
 
-  auto vuDeviceOrErr =
-      VuDevice::make(m_vuPhysicalDevice, defaultFeatureChain.deviceFeatures2, config::DEVICE_EXTENSIONS);
+  std::vector<const char*> deviceExtensions = config::DEVICE_EXTENSIONS;
+  for (const char* optionalExtension : config::OPTIONAL_DEVICE_EXTENSIONS) {
+    const bool isDynamicState3 = std::strcmp(optionalExtension, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME) == 0;
+    if (isDynamicState3 ? m_vuPhysicalDevice->supportsDynamicColorBlendEnable()
+                        : m_vuPhysicalDevice->isExtensionAvailable(optionalExtension)) {
+      deviceExtensions.push_back(optionalExtension);
+    } else {
+      Logger::Info("Optional device extension not available: {}", optionalExtension);
+    }
+  }
+  for (const char* extension : deviceExtensions) {
+    if (std::strcmp(extension, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) == 0) {
+      defaultFeatureChain.link(defaultFeatureChain.extendedDynamicStateFeatures);
+    } else if (std::strcmp(extension, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME) == 0) {
+      defaultFeatureChain.link(defaultFeatureChain.extendedDynamicState3Features);
+    }
+  }
+
+  // sample counts of the depth prepass occlusion queries, see VuDepthPrepass. the coverage query is also active while
+  // the gbuffer pass executes secondary command buffers
+  defaultFeatureChain.deviceFeatures2.features.occlusionQueryPrecise =
+      m_vuPhysicalDevice->m_features.occlusionQueryPrecise;
+  defaultFeatureChain.deviceFeatures2.features.inheritedQueries = m_vuPhysicalDevice->m_features.inheritedQueries;
+
+  // optional, VuGpuScene is not available without them and everything goes through the render queue
+  if (m_vuPhysicalDevice->m_supportsIndirectDraw) {
+    defaultFeatureChain.deviceFeatures2.features.multiDrawIndirect         = VK_TRUE;
+    defaultFeatureChain.deviceFeatures2.features.drawIndirectFirstInstance = VK_TRUE;
+    defaultFeatureChain.vk12_features.drawIndirectCount                    = VK_TRUE;
+  } else {
+    Logger::Info("Indirect count draws not supported, gpu driven rendering is off");
+  }
+
+  auto vuDeviceOrErr = VuDevice::make(m_vuPhysicalDevice, defaultFeatureChain.deviceFeatures2, deviceExtensions);
   THROW_if_unexpected(vuDeviceOrErr);
   this->m_vuDevice = std::make_shared<VuDevice>(std::move(vuDeviceOrErr.value()));
 
+  m_threadPool  = std::make_shared<ThreadPool>();
+  m_fileWatcher = std::make_shared<VuFileWatcher>();
+  if (!m_fileWatcher->isEventDriven()) { Logger::Info("Shader hot reload falls back to polling"); }
+
   initCommandPool(createInfo);
-  initBindlessDescriptorSetLayout(createInfo);
-  initDescriptorPool(createInfo);
+  // one slot per render queue chunk, forEachChunk uses up to a chunk per worker plus the calling thread, and one
+  // more for the gpu scene draws
+  m_secondaryCommandPools = move_or_THROW(VuSecondaryCommandPools::make(m_vuDevice,
+                                                                        m_vuPhysicalDevice->m_indices.graphicsFamily,
+                                                                        config::MAX_FRAMES_IN_FLIGHT,
+                                                                        m_threadPool->getThreadCount() + 2));
+  resolveBindlessLimits();
+  initBindlessDescriptorSetLayout(m_lastCreateInfo);
+  initDescriptorPool(m_lastCreateInfo);
+  initInputAttachmentSet();
   initPipelineLayout();
   initBindlessDescriptorSet();
-  initBindlessResourceManager(createInfo);
+  initBindlessResourceManager(m_lastCreateInfo);
+  // images, samplers and buffers destroyed while still registered give their slot back on their own
+  m_vuDevice->m_bindlessSlotReleaser = [this](const VuBindlessTable table, const u32 index) {
+    releaseBindlessSlot(table, index);
+  };
   initDefaultResources();
+  m_lightClusters = move_or_THROW(VuLightClusters::make(*this, VuLightClustersCreateInfo {}));
 
   // init uniform buffers
 
@@ -135,20 +196,32 @@ VuRenderer::VuRenderer(const VuRendererCreateInfo& createInfo) :
   m_commandBuffers.resize(config::MAX_FRAMES_IN_FLIGHT);
   VkResult cmdBuffersRes = vkAllocateCommandBuffers(m_vuDevice->m_device, &allocInfo, m_commandBuffers.data());
   THROW_if_fail(cmdBuffersRes);
-
-  VuDeferredRenderSpace rp {m_vuDevice, m_vuSurface};
+  m_gpuProfiler = move_or_THROW(VuGpuProfiler::make(m_vuDevice, VuGpuProfilerCreateInfo {}));
+
+  VuDeferredRenderSpace rp {m_vuDevice,
+                           m_vuSurface,
+                           createInfo.gBufferLayout,
+                           createInfo.singlePassDeferred,
+                           createInfo.depthPrepassMode != VuDepthPrepassMode::Off,
+                           swapChainCreateInfo()};
   this->m_deferredRenderSpace = std::move(rp);
   m_deferredRenderSpace.registerImagesToBindless(*this);
+  if (m_deferredRenderSpace.isSinglePass()) { m_deferredRenderSpace.writeInputAttachmentSet(m_inputAttachmentSet); }
+  m_depthPrepass        = move_or_THROW(VuDepthPrepass::make(*this, VuDepthPrepassCreateInfo {}));
+  m_depthPrepass.m_mode = createInfo.depthPrepassMode;
+  m_frameConstant.gBufferLayout = createInfo.gBufferLayout;
 
   // init sync objects
+  // the swapchain only takes binary semaphores, frame completion itself is tracked on the device timeline
   VkSemaphoreCreateInfo semaphoreInfo {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
-  VkFenceCreateInfo     fenceInfo {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
-
-  fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
   uint32_t swapChainImageCount = m_deferredRenderSpace.m_vuSwapChain.m_images.size();
   m_imageAvailableSemaphores.resize(config::MAX_FRAMES_IN_FLIGHT);
-  m_inFlightFences.resize(config::MAX_FRAMES_IN_FLIGHT);
+  // zero is always complete, the first use of each frame does not wait
+  m_frameTimelineValues.assign(config::MAX_FRAMES_IN_FLIGHT, 0);
+  m_frameInputTimesNs.assign(config::MAX_FRAMES_IN_FLIGHT, 0);
+  setFramesInFlight(createInfo.framesInFlight);
+  setMaxFps(createInfo.maxFps);
 
   m_renderFinishedSemaphores.resize(swapChainImageCount);
 
@@ -156,7 +229,6 @@ VuRenderer::VuRenderer(const VuRendererCreateInfo& createInfo) :
 
     THROW_if_fail(
         vkCreateSemaphore(m_vuDevice->m_device, &semaphoreInfo, NO_ALLOC_CALLBACK, &m_imageAvailableSemaphores[i]));
-    THROW_if_fail(vkCreateFence(m_vuDevice->m_device, &fenceInfo, NO_ALLOC_CALLBACK, &m_inFlightFences[i]));
   }
 
   for (size_t i = 0; i < swapChainImageCount; i++) {
@@ -168,6 +240,14 @@ VuRenderer::VuRenderer(const VuRendererCreateInfo& createInfo) :
 }
 //======================================================================================================================
 VuRenderer::~VuRenderer() {
+  // resources outliving the renderer keep their slots, the tables go away with it
+  m_vuDevice->m_bindlessSlotReleaser = nullptr;
+  // the owner idles the device before destroying the renderer, destroys of the last frames run here
+  for (std::function<void()>& destroy : m_pendingDestroys) {
+    destroy();
+  }
+  m_pendingDestroys.clear();
+  m_vuDevice->m_timeline->waitIdle();
   ImGui_ImplVulkan_DestroyFontsTexture();
   ImGui_ImplVulkan_Shutdown();
   ImGui_ImplSDL3_Shutdown();
@@ -175,6 +255,7 @@ VuRenderer::~VuRenderer() {
   vkDestroyCommandPool(m_vuDevice->m_device, m_commandPool, NO_ALLOC_CALLBACK);
   vkDestroyDescriptorPool(m_vuDevice->m_device, m_descriptorPool, NO_ALLOC_CALLBACK);
   vkDestroyDescriptorPool(m_vuDevice->m_device, m_uiDescriptorPool, NO_ALLOC_CALLBACK);
+  vkDestroyDescriptorPool(m_vuDevice->m_device, m_inputAttachmentDescriptorPool, NO_ALLOC_CALLBACK);
   SDL_DestroyWindow(this->m_window);
   for (auto sem : m_renderFinishedSemaphores) {
     vkDestroySemaphore(m_vuDevice->m_device, sem, NO_ALLOC_CALLBACK);
@@ -182,12 +263,10 @@ VuRenderer::~VuRenderer() {
   for (auto sem : m_imageAvailableSemaphores) {
     vkDestroySemaphore(m_vuDevice->m_device, sem, NO_ALLOC_CALLBACK);
   }
-  for (auto fence : m_inFlightFences) {
-    vkDestroyFence(m_vuDevice->m_device, fence, NO_ALLOC_CALLBACK);
-  }
 
 
   vkDestroyDescriptorSetLayout(m_vuDevice->m_device, m_globalDescriptorSetLayout, NO_ALLOC_CALLBACK);
+  vkDestroyDescriptorSetLayout(m_vuDevice->m_device, m_inputAttachmentSetLayout, NO_ALLOC_CALLBACK);
 
   vkDestroyPipelineLayout(m_vuDevice->m_device, m_globalPipelineLayout, NO_ALLOC_CALLBACK);
 }
@@ -198,13 +277,23 @@ VuRenderer::shouldWindowClose() const {
 }
 //======================================================================================================================
 void
-VuRenderer::waitForFences() const {
-  THROW_if_fail(vkWaitForFences(m_vuDevice->m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX));
+VuRenderer::waitForFrame() {
+  if (m_frameTimelineValues[m_currentFrame] == 0) { return; }
+  m_vuDevice->m_timeline->waitFor(m_frameTimelineValues[m_currentFrame]);
+  smoothLatency(m_latencyStats.inputToGpuDoneMs,
+                static_cast<float>(SDL_GetTicksNS() - m_frameInputTimesNs[m_currentFrame]) / 1'000'000.0f);
 }
 //======================================================================================================================
 void
 VuRenderer::beginFrame() {
-  waitForFences();
+  waitForFrame();
+  m_uploadContext.collect();
+  // deferred destroys whose frame completed
+  m_vuDevice->m_timeline->poll();
+  if (m_swapChainDirty) {
+    m_swapChainDirty = false;
+    resetSwapChain();
+  }
 
   uint32_t swapChainImageIndex {};
   VkResult imageIndexRes = vkAcquireNextImageKHR(m_vuDevice->m_device,
@@ -224,80 +313,140 @@ VuRenderer::beginFrame() {
   if (imageIndexRes != VK_SUCCESS) { throw std::runtime_error("VuRenderer::beginFrame: swapchain acquire failed"); }
   m_currentFrameImageIndex = swapChainImageIndex;
 
-  THROW_if_fail(vkResetFences(m_vuDevice->m_device, 1, &m_inFlightFences[m_currentFrame]));
+  // must happen before the global set is bound below
+  flushBindlessWrites();
+
   THROW_if_fail(vkResetCommandBuffer(m_commandBuffers[m_currentFrame], ZERO_FLAG));
 
   VkCommandBufferBeginInfo beginInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 
   THROW_if_fail(vkBeginCommandBuffer(m_commandBuffers[m_currentFrame], &beginInfo));
-
-  m_deferredRenderSpace.beginGBufferPass(m_commandBuffers[m_currentFrame], m_currentFrameImageIndex);
-
-  VkViewport viewport {};
-  viewport.x        = 0.0f;
-  viewport.y        = (float)m_deferredRenderSpace.m_vuSwapChain.m_extend2D.height;
-  viewport.width    = (float)m_deferredRenderSpace.m_vuSwapChain.m_extend2D.width;
-  viewport.height   = -(float)m_deferredRenderSpace.m_vuSwapChain.m_extend2D.height;
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
-  vkCmdSetViewport(m_commandBuffers[m_currentFrame], 0, 1, &viewport);
-
-  VkRect2D scissor {};
-  scissor.offset = VkOffset2D {0, 0};
-  scissor.extent = m_deferredRenderSpace.m_vuSwapChain.m_extend2D;
-  vkCmdSetScissor(m_commandBuffers[m_currentFrame], 0, 1, &scissor);
+  m_gpuProfiler.beginFrame(m_commandBuffers[m_currentFrame], m_currentFrame);
+  m_gpuProfiler.beginScope(m_commandBuffers[m_currentFrame], "Frame");
+
+  // compute work has to be recorded before the render pass begins
+  m_gpuProfiler.beginScope(m_commandBuffers[m_currentFrame], "Culling");
+  if (m_gpuScene != nullptr) { m_gpuScene->recordCulling(m_commandBuffers[m_currentFrame], m_currentFrame); }
+  // the camera of this frame is already in the frame constant, only the light fields are written on top of it
+  m_frameConstant.lightClusters = m_lightClusters.record(
+      *this, m_commandBuffers[m_currentFrame], m_currentFrame, m_pointLights, m_clusteredLighting);
+  m_gpuProfiler.endScope(m_commandBuffers[m_currentFrame], "Culling");
+  THROW_if_fail(m_uniformBuffers[m_currentFrame].setData(&m_frameConstant.lightClusters,
+                                                         sizeof(GPU::LightClusterInfo),
+                                                         offsetof(GPU::FrameConstant, lightClusters)));
+
+  // set outside the pass, a pass taking secondary command buffers accepts nothing else, later passes keep it
+  setViewportAndScissor(m_commandBuffers[m_currentFrame]);
   bindGlobalBindlessSet(m_commandBuffers[m_currentFrame]);
+
+  m_gBufferPassIsSecondary = m_parallelRecording;
+  if (m_gBufferPassIsSecondary) { m_secondaryCommandPools.resetFrame(m_currentFrame); }
+  // decided before any draw is queued, their pipelines depend on it. the prepass needs the queued draws, so
+  // flushRenderQueue records it and begins the gbuffer pass afterwards
+  m_gBufferDepthPrepassed = m_depthPrepass.update(m_currentFrame) && m_deferredRenderSpace.hasDepthPrepass();
+  if (!m_gBufferDepthPrepassed) { beginGBufferPass(); }
 }
 //======================================================================================================================
 void
-VuRenderer::beginLightningPass() const {
+VuRenderer::beginLightningPass() {
+  flushRenderQueue();
+
   const VkCommandBuffer& cb = m_commandBuffers[m_currentFrame];
+  if (m_deferredRenderSpace.isSinglePass()) {
+    // the subpass dependencies cover the gbuffer writes and the light cluster lists
+    m_deferredRenderSpace.beginLightningPass(cb, m_currentFrameImageIndex);
+    // the lighting subpass is inline, unlike a gbuffer subpass taking secondary command buffers
+    m_gpuProfiler.endScope(cb, "GBuffer");
+    m_gpuProfiler.beginScope(cb, "Lighting");
+    vkCmdBindDescriptorSets(
+        cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_globalPipelineLayout, 1, 1, &m_inputAttachmentSet, 0, nullptr);
+    return;
+  }
   vkCmdEndRenderPass(cb);
+  m_depthPrepass.endCoverageQuery(cb, m_currentFrame);
+  m_gpuProfiler.endScope(cb, "GBuffer");
+
+  // second phase of the gpu scene: test what was not drawn against this frame's depth and draw the newly visible
+  // objects on top, viewport, scissor and the global set stay valid across the render passes
+  if (m_gpuScene != nullptr && m_gpuScene->canOcclusionCull()) {
+    m_gpuProfiler.beginScope(cb, "Occlusion late");
+    m_gpuScene->recordOcclusionCulling(cb, m_currentFrame);
+    m_deferredRenderSpace.beginGBufferLoadPass(cb, m_currentFrameImageIndex);
+    m_gpuScene->recordDraws(cb, m_currentFrame, GPU::CullLate);
+    vkCmdEndRenderPass(cb);
+    m_gpuProfiler.endScope(cb, "Occlusion late");
+  }
 
-  VkPipelineStageFlags srcStage =
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  // gbuffer attachments, and the light cluster lists written before the gbuffer pass
+  VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                  VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
   VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
   VkMemoryBarrier memoryBarrier = {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER};
 
-  memoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  memoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                VK_ACCESS_SHADER_WRITE_BIT;
 
   memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
   vkCmdPipelineBarrier(cb, srcStage, dstStage, ZERO_FLAG, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
 
   // lightning pass
+  m_gpuProfiler.beginScope(cb, "Lighting");
   m_deferredRenderSpace.beginLightningPass(m_commandBuffers[m_currentFrame], m_currentFrameImageIndex);
 }
 //======================================================================================================================
 void
 VuRenderer::endFrame() {
   const VkCommandBuffer& cb = m_commandBuffers[m_currentFrame];
+  // already ended when imgui was drawn
+  m_gpuProfiler.endScope(cb, "Lighting");
   vkCmdEndRenderPass(cb);
+  m_gpuProfiler.endScope(cb, "Frame");
   THROW_if_fail(vkEndCommandBuffer(cb));
 
+  // pending uploads are submitted first, their barriers on the graphics queue make them visible to this frame
+  m_uploadContext.flush();
+
+  VuTimeline& timeline   = *m_vuDevice->m_timeline;
+  const u64   frameValue = timeline.nextValue();
+
+  // binary semaphore for present, its signal value is ignored
+  const VkSemaphore&   renderFinished     = m_renderFinishedSemaphores[m_currentFrameImageIndex];
   VkSemaphore          waitSemaphores[]   = {m_imageAvailableSemaphores[m_currentFrame]};
   VkPipelineStageFlags waitStages[]       = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  VkSemaphore          signalSemaphores[] = {m_renderFinishedSemaphores[m_currentFrameImageIndex]};
+  VkSemaphore          signalSemaphores[] = {renderFinished, timeline.m_semaphore};
+  u64                  signalValues[]     = {0, frameValue};
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo {.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timelineInfo.signalSemaphoreValueCount = 2u;
+  timelineInfo.pSignalSemaphoreValues    = signalValues;
 
   VkSubmitInfo submitInfo {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submitInfo.pNext                = &timelineInfo;
   submitInfo.waitSemaphoreCount   = 1u;
   submitInfo.pWaitSemaphores      = waitSemaphores;
   submitInfo.pWaitDstStageMask    = waitStages;
   submitInfo.commandBufferCount   = 1u;
   submitInfo.pCommandBuffers      = &m_commandBuffers[m_currentFrame];
-  submitInfo.signalSemaphoreCount = 1u;
+  submitInfo.signalSemaphoreCount = 2u;
   submitInfo.pSignalSemaphores    = signalSemaphores;
 
-  THROW_if_fail(vkQueueSubmit(m_vuDevice->m_graphicsQueue, 1, &submitInfo, m_inFlightFences[m_currentFrame]));
+  THROW_if_fail(vkQueueSubmit(m_vuDevice->m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+  m_frameTimelineValues[m_currentFrame] = frameValue;
+  m_frameInputTimesNs[m_currentFrame]   = m_inputTimeNs;
+  m_gpuProfiler.endFrame(frameValue);
+  retireFrameResources(frameValue);
+  // scenes wait for their pipelines before the first frame, later ones are reloads
+  if (m_frameNumber == 0) { m_vuDevice->m_pipelineCache->logStartupStats(); }
 
   VkSwapchainKHR swapChains[] = {m_deferredRenderSpace.m_vuSwapChain.m_swapchain};
 
   VkPresentInfoKHR presentInfo {.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
   presentInfo.pNext              = nullptr;
   presentInfo.waitSemaphoreCount = 1u;
-  presentInfo.pWaitSemaphores    = signalSemaphores;
+  presentInfo.pWaitSemaphores    = &renderFinished;
   presentInfo.swapchainCount     = 1u;
   presentInfo.pSwapchains        = swapChains;
   presentInfo.pImageIndices      = &m_currentFrameImageIndex;
@@ -310,7 +459,9 @@ VuRenderer::endFrame() {
   } else if (presentRes != VK_SUCCESS) {
     throw std::runtime_error("failed to present swap chain image!");
   }
-  m_currentFrame = (m_currentFrame + 1) % config::MAX_FRAMES_IN_FLIGHT;
+  smoothLatency(m_latencyStats.inputToPresentMs, static_cast<float>(SDL_GetTicksNS() - m_inputTimeNs) / 1'000'000.0f);
+  m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+  m_frameNumber++;
 }
 //======================================================================================================================
 void
@@ -321,10 +472,10 @@ VuRenderer::bindMesh(VuMesh& mesh) {
   vkCmdBindIndexBuffer(commandBuffer, indexBuffer->m_buffer, 0, VK_INDEX_TYPE_UINT32);
 }
 //======================================================================================================================
-void
+bool
 VuRenderer::bindMaterial(std::shared_ptr<VuMaterial>& material) {
   auto& commandBuffer = m_commandBuffers[m_currentFrame];
-  bindMaterial(commandBuffer, material);
+  return bindMaterial(commandBuffer, material);
 }
 //======================================================================================================================
 void
@@ -334,13 +485,224 @@ VuRenderer::drawIndexed(u32 indexCount) const {
 }
 //======================================================================================================================
 void
+VuRenderer::queueDraw(const std::shared_ptr<VuMaterial>& material,
+                      VuMesh&                            mesh,
+                      const float4x4&                    model,
+                      const float3&                      worldPosition) {
+  VuGraphicsPipeline* vuPipeline = requestGBufferPipeline(*material, m_gBufferDepthPrepassed);
+  if (vuPipeline == nullptr) { return; }
+
+  const VuDrawPacket packet {.pipeline   = vuPipeline->m_pipeline,
+                             .material   = material.get(),
+                             .mesh       = &mesh,
+                             .indexCount = static_cast<u32>(mesh.m_indexBuffer->m_sizeInBytes / sizeof(u32)),
+                             .instance   = {.model = model, .materialDataHandle = *material->m_materialDataHnd}};
+
+  const float viewDepth = Math::lengthSquared(worldPosition - m_frameConstant.camera.position.xyz());
+  m_renderQueue.push(GBufferPass, packet, viewDepth);
+}
+//======================================================================================================================
+void
+VuRenderer::flushRenderQueue() {
+  const VkCommandBuffer& cb = m_commandBuffers[m_currentFrame];
+  m_renderQueue.sort(m_threadPool.get());
+
+  const auto startTime     = std::chrono::steady_clock::now();
+  const u32  instanceCount = static_cast<u32>(m_renderQueue.size());
+  reserveInstanceBuffer(instanceCount);
+  if (m_gBufferDepthPrepassed) {
+    m_gpuProfiler.beginScope(cb, "Depth prepass");
+    m_depthPrepass.record(*this, cb, m_currentFrame);
+    m_gpuProfiler.endScope(cb, "Depth prepass");
+    beginGBufferPass();
+  }
+
+  VuRenderQueueStats stats {.instanceCount = instanceCount};
+  if (!m_gBufferPassIsSecondary) {
+    recordRenderQueueRange(cb, 0, instanceCount, stats);
+    if (m_gpuScene != nullptr) { m_gpuScene->recordDraws(cb, m_currentFrame); }
+  } else {
+    const VkRenderPass  renderPass  = m_deferredRenderSpace.m_gBufferPass->m_renderPass;
+    const VkFramebuffer framebuffer = m_deferredRenderSpace.m_gPassFrameBuffers[m_currentFrameImageIndex];
+    // the last slot is kept for the gpu scene
+    const u32 maxChunkCount = m_secondaryCommandPools.getSlotCount() - 1;
+    const u32 chunkCount =
+        std::min(maxChunkCount,
+                 (instanceCount + config::MIN_PACKETS_PER_RECORD_CHUNK - 1) / config::MIN_PACKETS_PER_RECORD_CHUNK);
+
+    // secondary command buffers inherit nothing but the pass, every one sets its own state
+    auto beginSecondary = [&](const u32 slot) {
+      const VkCommandBuffer secondary = m_secondaryCommandPools.begin(
+          m_currentFrame, slot, renderPass, framebuffer, m_depthPrepass.m_coverageQueryActive);
+      setViewportAndScissor(secondary);
+      bindGlobalBindlessSet(secondary);
+      return secondary;
+    };
+
+    std::vector<VkCommandBuffer>    secondaries(chunkCount);
+    std::vector<VuRenderQueueStats> chunkStats(chunkCount);
+    forEachChunk(m_threadPool.get(), chunkCount, [&](const size_t chunk) {
+      // packet ranges ignore instancing groups, a group split by a chunk boundary costs one extra draw
+      const u32 first = static_cast<u32>(u64 {instanceCount} * chunk / chunkCount);
+      const u32 end   = static_cast<u32>(u64 {instanceCount} * (chunk + 1) / chunkCount);
+
+      const VkCommandBuffer secondary = beginSecondary(static_cast<u32>(chunk));
+      recordRenderQueueRange(secondary, first, end, chunkStats[chunk]);
+      THROW_if_fail(vkEndCommandBuffer(secondary));
+      secondaries[chunk] = secondary;
+    });
+
+    if (m_gpuScene != nullptr) {
+      const VkCommandBuffer secondary = beginSecondary(maxChunkCount);
+      m_gpuScene->recordDraws(secondary, m_currentFrame);
+      THROW_if_fail(vkEndCommandBuffer(secondary));
+      secondaries.push_back(secondary);
+    }
+    if (!secondaries.empty()) {
+      vkCmdExecuteCommands(cb, static_cast<u32>(secondaries.size()), secondaries.data());
+    }
+
+    for (const VuRenderQueueStats& chunk : chunkStats) {
+      stats.drawCount += chunk.drawCount;
+      stats.pipelineBinds += chunk.pipelineBinds;
+      stats.pipelineBindsSkipped += chunk.pipelineBindsSkipped;
+      stats.indexBufferBinds += chunk.indexBufferBinds;
+      stats.indexBufferBindsSkipped += chunk.indexBufferBindsSkipped;
+    }
+    stats.secondaryCommandBuffers = static_cast<u32>(secondaries.size());
+  }
+
+  const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+  stats.recordMilliseconds                               = elapsed.count();
+  m_renderQueueStats                                     = stats;
+  m_renderQueue.clear();
+}
+//======================================================================================================================
+void
+VuRenderer::beginGBufferPass() {
+  m_gpuProfiler.beginScope(m_commandBuffers[m_currentFrame], "GBuffer");
+  if (m_gBufferDepthPrepassed) {
+    m_depthPrepass.beginCoverageQuery(m_commandBuffers[m_currentFrame], m_currentFrame, m_gBufferPassIsSecondary);
+  }
+  m_deferredRenderSpace.beginGBufferPass(m_commandBuffers[m_currentFrame],
+                                         m_currentFrameImageIndex,
+                                         m_gBufferPassIsSecondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                                                  : VK_SUBPASS_CONTENTS_INLINE,
+                                         m_gBufferDepthPrepassed);
+}
+//======================================================================================================================
+void
+VuRenderer::recordRenderQueueRange(const VkCommandBuffer& cb,
+                                   const u32              first,
+                                   const u32              end,
+                                   VuRenderQueueStats&    stats) const {
+  const VuBuffer& instanceBuffer = m_instanceBuffers[m_currentFrame];
+  auto*           instances      = static_cast<GPU::InstanceData*>(instanceBuffer.m_mapPtr);
+
+  VkPipeline        boundPipeline {nullptr};
+  const VuMaterial* boundMaterial {nullptr};
+  VkBuffer          boundIndexBuffer {nullptr};
+
+  u32 groupFirst = first;
+  while (groupFirst < end) {
+    const VuDrawPacket& packet = m_renderQueue.sortedPacket(groupFirst);
+
+    // sorting put every packet of the same pipeline, material and mesh next to each other
+    u32 groupEnd = groupFirst;
+    for (; groupEnd < end; ++groupEnd) {
+      const VuDrawPacket& other = m_renderQueue.sortedPacket(groupEnd);
+      if (other.pipeline != packet.pipeline || other.material != packet.material || other.mesh != packet.mesh) {
+        break;
+      }
+      if (!m_mergeInstances && groupEnd != groupFirst) { break; }
+      instances[groupEnd] = other.instance;
+    }
+
+    if (packet.pipeline != boundPipeline) {
+      vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+      boundPipeline = packet.pipeline;
+      boundMaterial = nullptr;
+      stats.pipelineBinds++;
+    } else {
+      stats.pipelineBindsSkipped++;
+    }
+    if (packet.material != boundMaterial) {
+      setDynamicRasterState(cb, *m_vuDevice, *packet.material, m_gBufferDepthPrepassed);
+      boundMaterial = packet.material;
+    }
+
+    // we are using vertex pulling, so only index buffers we need to bind
+    const VkBuffer indexBuffer = packet.mesh->m_indexBuffer->m_buffer;
+    if (indexBuffer != boundIndexBuffer) {
+      vkCmdBindIndexBuffer(cb, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+      boundIndexBuffer = indexBuffer;
+      stats.indexBufferBinds++;
+    } else {
+      stats.indexBufferBindsSkipped++;
+    }
+
+    const GPU::PushConstant pushConstant {
+        .materialDataHandle   = packet.instance.materialDataHandle,
+        .mesh                 = {packet.mesh->m_vertexBuffer->m_bindlessIndex.value_or_THROW(),
+                                 packet.mesh->m_vertexCount,
+                                 ZERO_FLAG},
+        .instanceBufferHandle = instanceBuffer.m_bindlessIndex.value_or_THROW()};
+    vkCmdPushConstants(cb,
+                       m_globalPipelineLayout,
+                       VK_SHADER_STAGE_ALL,
+                       MakeVkOffset(0),
+                       sizeof(GPU::PushConstant),
+                       &pushConstant);
+    vkCmdDrawIndexed(cb, packet.indexCount, groupEnd - groupFirst, 0, 0, groupFirst);
+    stats.drawCount++;
+    groupFirst = groupEnd;
+  }
+}
+//======================================================================================================================
+void
+VuRenderer::setViewportAndScissor(const VkCommandBuffer& cb) const {
+  const VkExtent2D extent = m_deferredRenderSpace.m_vuSwapChain.m_extend2D;
+
+  VkViewport viewport {};
+  viewport.x        = 0.0f;
+  viewport.y        = (float)extent.height;
+  viewport.width    = (float)extent.width;
+  viewport.height   = -(float)extent.height;
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+  vkCmdSetViewport(cb, 0, 1, &viewport);
+
+  VkRect2D scissor {};
+  scissor.offset = VkOffset2D {0, 0};
+  scissor.extent = extent;
+  vkCmdSetScissor(cb, 0, 1, &scissor);
+}
+//======================================================================================================================
+void
+VuRenderer::reserveInstanceBuffer(const u32 instanceCount) {
+  VuBuffer&          instanceBuffer = m_instanceBuffers[m_currentFrame];
+  const VkDeviceSize requiredSize   = VkDeviceSize {std::max(instanceCount, 1u)} * sizeof(GPU::InstanceData);
+  if (instanceBuffer.m_buffer != VK_NULL_HANDLE && instanceBuffer.m_sizeInBytes >= requiredSize) { return; }
+
+  const VkDeviceSize size = std::max({requiredSize,
+                                      VkDeviceSize {instanceBuffer.m_sizeInBytes * 2},
+                                      VkDeviceSize {config::INITIAL_INSTANCE_CAPACITY * sizeof(GPU::InstanceData)}});
+
+  // the frame that last used this buffer has completed, only its bindless slot has to age
+  unregisterFromBindless(instanceBuffer);
+  instanceBuffer = move_or_THROW(VuBuffer::make(m_vuDevice, {.name = "instanceBuffer", .sizeInBytes = size}));
+  THROW_if_fail(instanceBuffer.map());
+  registerToBindless(instanceBuffer);
+}
+//======================================================================================================================
+void
 VuRenderer::pushConstants(const GPU::PushConstant& pushConstant) {
   auto& commandBuffer = m_commandBuffers[m_currentFrame];
   vkCmdPushConstants(commandBuffer,
                      m_globalPipelineLayout,
                      VK_SHADER_STAGE_ALL,
                      MakeVkOffset(0),
-                     config::PUSH_CONST_SIZE,
+                     sizeof(GPU::PushConstant),
                      &pushConstant);
 }
 //======================================================================================================================
@@ -353,11 +715,14 @@ VuRenderer::beginImgui() const {
 }
 //======================================================================================================================
 void
-VuRenderer::endImgui() const {
+VuRenderer::endImgui() {
   auto& commandBuffer = m_commandBuffers[m_currentFrame];
 
   ImGui::Render();
+  m_gpuProfiler.endScope(commandBuffer, "Lighting");
+  m_gpuProfiler.beginScope(commandBuffer, "ImGui");
   ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+  m_gpuProfiler.endScope(commandBuffer, "ImGui");
 }
 //======================================================================================================================
 void
@@ -382,16 +747,83 @@ VuRenderer::resetSwapChain() {
   }
   THROW_if_fail(vkDeviceWaitIdle(m_vuDevice->m_device));
 
-  VuDeferredRenderSpace rp {m_vuDevice, m_vuSurface};
+  // old gbuffer slots are recycled instead of leaking on every resize
+  m_deferredRenderSpace.unregisterImagesFromBindless(*this);
+  VuDeferredRenderSpace rp {m_vuDevice,
+                           m_vuSurface,
+                           m_lastCreateInfo.gBufferLayout,
+                           m_lastCreateInfo.singlePassDeferred,
+                           m_lastCreateInfo.depthPrepassMode != VuDepthPrepassMode::Off,
+                           swapChainCreateInfo()};
   this->m_deferredRenderSpace = std::move(rp);
   m_deferredRenderSpace.registerImagesToBindless(*this);
+  // the device is idle, the set can be rewritten in place
+  if (m_deferredRenderSpace.isSinglePass()) { m_deferredRenderSpace.writeInputAttachmentSet(m_inputAttachmentSet); }
+
+  // present waits on one semaphore per swapchain image, the image count may have changed
+  const size_t imageCount = m_deferredRenderSpace.m_vuSwapChain.m_images.size();
+  if (m_renderFinishedSemaphores.size() != imageCount) {
+    for (VkSemaphore semaphore : m_renderFinishedSemaphores) {
+      vkDestroySemaphore(m_vuDevice->m_device, semaphore, NO_ALLOC_CALLBACK);
+    }
+    m_renderFinishedSemaphores.resize(imageCount);
+    VkSemaphoreCreateInfo semaphoreInfo {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    for (VkSemaphore& semaphore : m_renderFinishedSemaphores) {
+      THROW_if_fail(vkCreateSemaphore(m_vuDevice->m_device, &semaphoreInfo, NO_ALLOC_CALLBACK, &semaphore));
+    }
+  }
+}
+//======================================================================================================================
+VuSwapChainCreateInfo
+VuRenderer::swapChainCreateInfo() const {
+  return {.presentMode = m_lastCreateInfo.presentMode, .imageCount = m_lastCreateInfo.swapChainImageCount};
+}
+//======================================================================================================================
+void
+VuRenderer::setPresentMode(const VkPresentModeKHR presentMode) {
+  if (presentMode == m_lastCreateInfo.presentMode) { return; }
+  m_lastCreateInfo.presentMode = presentMode;
+  m_swapChainDirty             = true;
+}
+//======================================================================================================================
+void
+VuRenderer::setSwapChainImageCount(const u32 imageCount) {
+  if (imageCount == m_lastCreateInfo.swapChainImageCount) { return; }
+  m_lastCreateInfo.swapChainImageCount = imageCount;
+  m_swapChainDirty                     = true;
 }
 //======================================================================================================================
 void
-VuRenderer::bindGlobalBindlessSet(const VkCommandBuffer& commandBuffer) const {
+VuRenderer::setFramesInFlight(const u32 framesInFlight) {
+  m_framesInFlight                = std::clamp(framesInFlight, 1u, config::MAX_FRAMES_IN_FLIGHT);
+  m_lastCreateInfo.framesInFlight = m_framesInFlight;
+}
+//======================================================================================================================
+void
+VuRenderer::setMaxFps(const float maxFps) {
+  m_frameLimiter.setTargetFps(maxFps);
+  m_lastCreateInfo.maxFps = m_frameLimiter.getTargetFps();
+}
+//======================================================================================================================
+void
+VuRenderer::setDepthPrepassMode(const VuDepthPrepassMode mode) {
+  m_lastCreateInfo.depthPrepassMode = mode;
+  m_depthPrepass.m_mode             = mode;
+  // Off gives a transient depth back, a prepass has to store it
+  const bool wantsPrepass = mode != VuDepthPrepassMode::Off && !m_deferredRenderSpace.isSinglePass();
+  if (wantsPrepass != m_deferredRenderSpace.hasDepthPrepass()) { m_swapChainDirty = true; }
+}
+//======================================================================================================================
+const VuRendererCreateInfo&
+VuRenderer::getCreateInfo() const {
+  return m_lastCreateInfo;
+}
+//======================================================================================================================
+void
+VuRenderer::bindGlobalBindlessSet(const VkCommandBuffer& commandBuffer, const VkPipelineBindPoint bindPoint) const {
 
   vkCmdBindDescriptorSets(commandBuffer,
-                          VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          bindPoint,
                           m_globalPipelineLayout,
                           0,
                           1,
@@ -402,6 +834,7 @@ VuRenderer::bindGlobalBindlessSet(const VkCommandBuffer& commandBuffer) const {
 //======================================================================================================================
 void
 VuRenderer::preUpdate() {
+  m_latencyStats.limiterWaitMs = m_frameLimiter.wait();
   // nano => micro => mili => second
   SDL_PollEvent(&m_sdlEvent);
   m_deltaAsSecond        = (SDL_GetTicksNS() - m_prevTimeAsNanoSecond) / 1000.0f / 1000.0f / 1000.0f;
@@ -414,6 +847,7 @@ VuRenderer::pollUserInput() {
   float prevx = m_mouseX;
   float prevy = m_mouseY;
   SDL_GetMouseState(&m_mouseX, &m_mouseY);
+  m_inputTimeNs = SDL_GetTicksNS();
   m_mouseDeltaX = prevx - m_mouseX;
   m_mouseDeltaY = prevy - m_mouseY;
 }
@@ -453,44 +887,149 @@ VuRenderer::registerToBindless(VuBuffer& vuBuffer) {
 //======================================================================================================================
 void
 VuRenderer::registerToBindless(VuImage& vuImage) {
+  if (m_imgBindlessIndexAllocator.isFull()) {
+    const u32 capacity = m_imgBindlessIndexAllocator.capacity();
+    if (capacity < m_lastCreateInfo.maxSampledImageCount) {
+      // descriptor sets catch up with the new capacity in the next flush
+      m_imgBindlessIndexAllocator.grow(std::min(capacity * 2, m_lastCreateInfo.maxSampledImageCount));
+      m_bindlessImageInfos.resize(m_imgBindlessIndexAllocator.capacity());
+    }
+  }
   uint32_t bindlessIndex = m_imgBindlessIndexAllocator.allocate();
 
-  VkDescriptorImageInfo imageInfo {};
-  imageInfo.sampler     = nullptr;
-  imageInfo.imageView   = vuImage.m_imageView;
-  imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-  for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-    VkWriteDescriptorSet descriptorWrite {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descriptorWrite.dstSet          = m_globalDescriptorSets[i];
-    descriptorWrite.dstBinding      = m_lastCreateInfo.sampledImageBinding;
-    descriptorWrite.dstArrayElement = bindlessIndex;
-    descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pImageInfo      = &imageInfo;
-    vkUpdateDescriptorSets(m_vuDevice->m_device, 1, &descriptorWrite, 0, nullptr);
-  }
+  m_bindlessImageInfos[bindlessIndex] = VkDescriptorImageInfo {
+      .sampler     = nullptr,
+      .imageView   = vuImage.m_imageView,
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  };
+  m_pendingBindlessWrites.emplace_back(VuBindlessTable::SampledImage, bindlessIndex);
   vuImage.m_bindlessIndex = bindlessIndex;
 }
 //======================================================================================================================
 void
 VuRenderer::registerToBindless(VuSampler& vuSampler) {
-  uint32_t              bindlessIndex = m_samplerBindlessIndexAllocator.allocate();
-  VkDescriptorImageInfo imageInfo {
+  uint32_t bindlessIndex = m_samplerBindlessIndexAllocator.allocate();
+
+  m_bindlessSamplerInfos[bindlessIndex] = VkDescriptorImageInfo {
       .sampler = vuSampler.m_sampler,
   };
+  m_pendingBindlessWrites.emplace_back(VuBindlessTable::Sampler, bindlessIndex);
+  vuSampler.m_bindlessIndex = bindlessIndex;
+}
+//======================================================================================================================
+void
+VuRenderer::unregisterFromBindless(VuBuffer& vuBuffer) {
+  if (!vuBuffer.m_bindlessIndex) { return; }
+  releaseBindlessSlot(VuBindlessTable::StorageBuffer, *vuBuffer.m_bindlessIndex);
+  vuBuffer.m_bindlessIndex.reset();
+}
+//======================================================================================================================
+void
+VuRenderer::unregisterFromBindless(VuImage& vuImage) {
+  if (!vuImage.m_bindlessIndex) { return; }
+  releaseBindlessSlot(VuBindlessTable::SampledImage, *vuImage.m_bindlessIndex);
+  vuImage.m_bindlessIndex.reset();
+}
+//======================================================================================================================
+void
+VuRenderer::unregisterFromBindless(VuSampler& vuSampler) {
+  if (!vuSampler.m_bindlessIndex) { return; }
+  releaseBindlessSlot(VuBindlessTable::Sampler, *vuSampler.m_bindlessIndex);
+  vuSampler.m_bindlessIndex.reset();
+}
+//======================================================================================================================
+void
+VuRenderer::releaseBindlessSlot(const VuBindlessTable table, const u32 index) {
+  // a null entry also drops a write that is still pending for this slot
+  switch (table) {
+  case VuBindlessTable::SampledImage: m_bindlessImageInfos[index] = VkDescriptorImageInfo {}; break;
+  case VuBindlessTable::Sampler: m_bindlessSamplerInfos[index] = VkDescriptorImageInfo {}; break;
+  case VuBindlessTable::StorageBuffer: break;
+  }
+  // a frame recorded before may still read the slot, it is reused once that frame completed on the gpu
+  deferDestroy([this, table, index] {
+    switch (table) {
+    case VuBindlessTable::SampledImage: m_imgBindlessIndexAllocator.deallocate(index); break;
+    case VuBindlessTable::Sampler: m_samplerBindlessIndexAllocator.deallocate(index); break;
+    case VuBindlessTable::StorageBuffer: m_bufferBindlessIndexAllocator.deallocate(index); break;
+    }
+  });
+}
+//======================================================================================================================
+void
+VuRenderer::deferDestroy(std::function<void()> destroy) {
+  m_pendingDestroys.push_back(std::move(destroy));
+}
+//======================================================================================================================
+void
+VuRenderer::retireFrameResources(const u64 frameTimelineValue) {
+  for (std::function<void()>& destroy : m_pendingDestroys) {
+    m_vuDevice->m_timeline->onComplete(frameTimelineValue, std::move(destroy));
+  }
+  m_pendingDestroys.clear();
+}
+//======================================================================================================================
+void
+VuRenderer::flushBindlessWrites() {
+  // released slots went back to their allocators in the timeline poll before this
+  if (m_imgBindlessIndexAllocator.capacity() > m_sampledImageTableSize) { growSampledImageTable(); }
+  if (m_pendingBindlessWrites.empty()) { return; }
+
+  std::vector<VkWriteDescriptorSet> writes {};
+  writes.reserve(m_pendingBindlessWrites.size() * m_globalDescriptorSets.size());
+  for (const auto& [table, index] : m_pendingBindlessWrites) {
+    const bool                   isImage = table == VuBindlessTable::SampledImage;
+    const VkDescriptorImageInfo& info    = isImage ? m_bindlessImageInfos[index] : m_bindlessSamplerInfos[index];
+    // unregistered before it was ever flushed
+    if (isImage ? info.imageView == VK_NULL_HANDLE : info.sampler == VK_NULL_HANDLE) { continue; }
+
+    for (VkDescriptorSet set : m_globalDescriptorSets) {
+      VkWriteDescriptorSet descriptorWrite {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+      descriptorWrite.dstSet          = set;
+      descriptorWrite.dstBinding      = isImage ? m_lastCreateInfo.sampledImageBinding : m_lastCreateInfo.samplerBinding;
+      descriptorWrite.dstArrayElement = index;
+      descriptorWrite.descriptorType  = isImage ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLER;
+      descriptorWrite.descriptorCount = 1;
+      descriptorWrite.pImageInfo      = &info;
+      writes.push_back(descriptorWrite);
+    }
+  }
+  m_pendingBindlessWrites.clear();
+  if (writes.empty()) { return; }
 
-  for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-    VkWriteDescriptorSet descriptorWrite {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descriptorWrite.dstSet          = m_globalDescriptorSets[i];
-    descriptorWrite.dstBinding      = m_lastCreateInfo.samplerBinding;
-    descriptorWrite.dstArrayElement = bindlessIndex;
-    descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLER;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pImageInfo      = &imageInfo;
-    vkUpdateDescriptorSets(m_vuDevice->m_device, 1, &descriptorWrite, 0, nullptr);
+  vkUpdateDescriptorSets(m_vuDevice->m_device, static_cast<u32>(writes.size()), writes.data(), 0, nullptr);
+}
+//======================================================================================================================
+void
+VuRenderer::growSampledImageTable() {
+  // rare, happens only when the table doubles, so a full wait is simpler than retiring the old sets
+  THROW_if_fail(vkDeviceWaitIdle(m_vuDevice->m_device));
+  vkDestroyDescriptorPool(m_vuDevice->m_device, m_descriptorPool, NO_ALLOC_CALLBACK);
+
+  Logger::Info("Bindless sampled image table grows from {} to {}",
+               m_sampledImageTableSize,
+               m_imgBindlessIndexAllocator.capacity());
+  m_sampledImageTableSize = m_imgBindlessIndexAllocator.capacity();
+  initDescriptorPool(m_lastCreateInfo);
+  initBindlessDescriptorSet();
+
+  for (u32 i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
+    writeUBO_ToGlobalPool(m_uniformBuffers[i], 0, i);
+    writeBDA_ToGlobalPool(i);
+  }
+
+  // the new sets are empty, every live slot has to be written again
+  m_pendingBindlessWrites.clear();
+  for (u32 i = 0; i < m_bindlessImageInfos.size(); i++) {
+    if (m_bindlessImageInfos[i].imageView != VK_NULL_HANDLE) {
+      m_pendingBindlessWrites.emplace_back(VuBindlessTable::SampledImage, i);
+    }
+  }
+  for (u32 i = 0; i < m_bindlessSamplerInfos.size(); i++) {
+    if (m_bindlessSamplerInfos[i].sampler != VK_NULL_HANDLE) {
+      m_pendingBindlessWrites.emplace_back(VuBindlessTable::Sampler, i);
+    }
   }
-  vuSampler.m_bindlessIndex = bindlessIndex;
 }
 //======================================================================================================================
 void
@@ -503,7 +1042,7 @@ VuRenderer::initCommandPool(const VuRendererCreateInfo& info) {
 //======================================================================================================================
 void
 VuRenderer::initPipelineLayout() {
-  std::array descSetLayouts {m_globalDescriptorSetLayout};
+  std::array descSetLayouts {m_globalDescriptorSetLayout, m_inputAttachmentSetLayout};
   auto       pipelineLayoutOrErr = m_vuDevice->createPipelineLayout(descSetLayouts, config::PUSH_CONST_SIZE);
   THROW_if_unexpected(pipelineLayoutOrErr);
   m_globalPipelineLayout = std::move(pipelineLayoutOrErr.value());
@@ -526,7 +1065,7 @@ VuRenderer::initBindlessDescriptorSetLayout(const VuRendererCreateInfo& info) {
   VkDescriptorSetLayoutBinding sampledImage = {};
   sampledImage.binding                      = info.sampledImageBinding;
   sampledImage.descriptorType               = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-  sampledImage.descriptorCount              = info.sampledImageCount;
+  sampledImage.descriptorCount              = info.maxSampledImageCount;
   sampledImage.stageFlags                   = VK_SHADER_STAGE_ALL;
 
   VkDescriptorSetLayoutBinding storageImage {};
@@ -541,12 +1080,13 @@ VuRenderer::initBindlessDescriptorSetLayout(const VuRendererCreateInfo& info) {
   storageBuffer.descriptorCount = 1;
   storageBuffer.stageFlags      = VK_SHADER_STAGE_ALL;
 
+  // ordered by binding number, sampledImage has to stay last for its variable count
   std::array descriptorSetLayoutBindings {
       ubo,
       sampler,
-      sampledImage,
-      storageImage,
       storageBuffer,
+      storageImage,
+      sampledImage,
   };
 
   VkDescriptorSetLayoutCreateInfo descSetLayoutCreateInfo {.sType =
@@ -560,7 +1100,8 @@ VuRenderer::initBindlessDescriptorSetLayout(const VuRendererCreateInfo& info) {
                                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
                                                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
 
-  std::array descriptorSetLayoutFlags {flag, flag, flag, flag, flag};
+  std::array descriptorSetLayoutFlags {
+      flag, flag, flag, flag, flag | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT};
 
   VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags {
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
@@ -576,15 +1117,7 @@ VuRenderer::initBindlessDescriptorSetLayout(const VuRendererCreateInfo& info) {
 //======================================================================================================================
 void
 VuRenderer::initDefaultResources() {
-  VuBufferCreateInfo stagingBufferCreateInfo {};
-  stagingBufferCreateInfo.name         = "stagingBuffer";
-  stagingBufferCreateInfo.sizeInBytes  = 1024 * 1024 * 64;
-  stagingBufferCreateInfo.vkUsageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-
-  auto stagingOrErr = VuBuffer::make(m_vuDevice, stagingBufferCreateInfo);
-  THROW_if_unexpected(stagingOrErr);
-  this->m_stagingBuffer = std::move(stagingOrErr.value());
-  THROW_if_fail(m_stagingBuffer.map());
+  m_uploadContext = move_or_THROW(VuUploadContext::make(m_vuDevice, VuUploadContextCreateInfo {}));
 
   VuBufferCreateInfo debugBufferCreateInfo {};
   debugBufferCreateInfo.name         = "debugBuffer";
@@ -611,7 +1144,8 @@ VuRenderer::initDefaultResources() {
     }
   }
 
-  auto defaultImageOrErr = VuImage::make(m_vuDevice, {.width = 512, .height = 512, .format = VK_FORMAT_R8G8B8A8_SRGB});
+  auto defaultImageOrErr = VuImage::make(
+      m_vuDevice, {.width = 512, .height = 512, .format = VK_FORMAT_R8G8B8A8_SRGB, .name = "DefaultImage"});
   THROW_if_unexpected(defaultImageOrErr);
   m_defaultImage = std::make_shared<VuImage>(std::move(defaultImageOrErr.value()));
   uploadToImage(*m_defaultImage, reinterpret_cast<const byte*>(colorData.data()), colorData.size() * sizeof(Color32));
@@ -621,7 +1155,8 @@ VuRenderer::initDefaultResources() {
   Color32 normalColor {uint8_t {128}, uint8_t {128}, uint8_t {255}, uint8_t {255}};
   std::fill(colorData.begin(), colorData.end(), normalColor);
   auto defaultNormalImageOrErr =
-      VuImage::make(m_vuDevice, {.width = 512, .height = 512, .format = VK_FORMAT_R8G8B8A8_UNORM});
+      VuImage::make(m_vuDevice,
+                    {.width = 512, .height = 512, .format = VK_FORMAT_R8G8B8A8_UNORM, .name = "DefaultNormalImage"});
   THROW_if_unexpected(defaultNormalImageOrErr);
   m_defaultNormalImage = std::make_shared<VuImage>(std::move(defaultNormalImageOrErr.value()));
 
@@ -649,6 +1184,8 @@ VuRenderer::initDefaultResources() {
   registerToBindless(*m_materialDataBuffer);
   assert(m_materialDataBuffer->m_bindlessIndex == 1);
   THROW_if_fail(m_materialDataBuffer->map());
+
+  m_instanceBuffers.resize(config::MAX_FRAMES_IN_FLIGHT);
 }
 //======================================================================================================================
 void
@@ -662,7 +1199,7 @@ VuRenderer::initDescriptorPool(const VuRendererCreateInfo& info) {
   poolSizes[1].descriptorCount = info.samplerCount * config::MAX_FRAMES_IN_FLIGHT;
 
   poolSizes[2].type            = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-  poolSizes[2].descriptorCount = info.sampledImageCount * config::MAX_FRAMES_IN_FLIGHT;
+  poolSizes[2].descriptorCount = m_sampledImageTableSize * config::MAX_FRAMES_IN_FLIGHT;
 
   poolSizes[3].type            = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
   poolSizes[3].descriptorCount = info.storageImageCount * config::MAX_FRAMES_IN_FLIGHT;
@@ -672,7 +1209,7 @@ VuRenderer::initDescriptorPool(const VuRendererCreateInfo& info) {
 
   VkDescriptorPoolCreateInfo poolInfo {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
   poolInfo.flags         = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
-  poolInfo.maxSets       = 2;
+  poolInfo.maxSets       = config::MAX_FRAMES_IN_FLIGHT;
   poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
   poolInfo.pPoolSizes    = poolSizes.data();
 
@@ -684,7 +1221,16 @@ VuRenderer::initBindlessDescriptorSet() {
   std::array<VkDescriptorSetLayout, config::MAX_FRAMES_IN_FLIGHT> globalDescLayout;
   globalDescLayout.fill(m_globalDescriptorSetLayout);
 
+  std::array<u32, config::MAX_FRAMES_IN_FLIGHT> variableCounts;
+  variableCounts.fill(m_sampledImageTableSize);
+
+  VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO};
+  variableCountInfo.descriptorSetCount = static_cast<uint32_t>(variableCounts.size());
+  variableCountInfo.pDescriptorCounts  = variableCounts.data();
+
   VkDescriptorSetAllocateInfo globalSetsAllocInfo {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+  globalSetsAllocInfo.pNext              = &variableCountInfo;
   globalSetsAllocInfo.descriptorPool     = m_descriptorPool;
   globalSetsAllocInfo.descriptorSetCount = static_cast<uint32_t>(globalDescLayout.size());
   globalSetsAllocInfo.pSetLayouts        = globalDescLayout.data();
@@ -697,34 +1243,47 @@ VuRenderer::initBindlessDescriptorSet() {
   }
 }
 //======================================================================================================================
-VkCommandBuffer
-VuRenderer::beginSingleTimeCommands() const {
-  VkCommandBufferAllocateInfo cbAllocInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
-  cbAllocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  cbAllocInfo.commandPool        = m_commandPool;
-  cbAllocInfo.commandBufferCount = 1;
+void
+VuRenderer::initInputAttachmentSet() {
+  std::array<VkDescriptorSetLayoutBinding, GBufferInputCount> bindings {};
+  for (u32 i = 0; i < GBufferInputCount; ++i) {
+    bindings[i].binding         = i;
+    bindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT;
+  }
 
-  VkCommandBuffer commandBuffer {};
-  THROW_if_fail(vkAllocateCommandBuffers(m_vuDevice->m_device, &cbAllocInfo, &commandBuffer));
+  // a gbuffer layout has either depth or world position
+  std::array<VkDescriptorBindingFlags, GBufferInputCount> bindingFlags {};
+  bindingFlags.fill(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
 
-  VkCommandBufferBeginInfo beginInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-  THROW_if_fail(vkBeginCommandBuffer(commandBuffer, &beginInfo));
-  return commandBuffer;
-}
-//======================================================================================================================
-void
-VuRenderer::endSingleTimeCommands(const VkCommandBuffer& commandBuffer) const {
-  THROW_if_fail(vkEndCommandBuffer(commandBuffer));
+  VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+  bindingFlagsInfo.bindingCount  = static_cast<uint32_t>(bindingFlags.size());
+  bindingFlagsInfo.pBindingFlags = bindingFlags.data();
 
-  VkSubmitInfo submitInfo {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO};
-  submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers    = &commandBuffer;
+  VkDescriptorSetLayoutCreateInfo layoutInfo {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+  layoutInfo.pNext        = &bindingFlagsInfo;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings    = bindings.data();
+  THROW_if_fail(
+      vkCreateDescriptorSetLayout(m_vuDevice->m_device, &layoutInfo, NO_ALLOC_CALLBACK, &m_inputAttachmentSetLayout));
 
-  THROW_if_fail(vkQueueSubmit(m_vuDevice->m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
-  THROW_if_fail(vkQueueWaitIdle(m_vuDevice->m_graphicsQueue));
+  // its own pool, the bindless pool is recreated when the sampled image table grows
+  VkDescriptorPoolSize poolSize {.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, .descriptorCount = GBufferInputCount};
 
-  vkFreeCommandBuffers(m_vuDevice->m_device, m_commandPool, 1, &commandBuffer);
+  VkDescriptorPoolCreateInfo poolInfo {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+  poolInfo.maxSets       = 1;
+  poolInfo.poolSizeCount = 1;
+  poolInfo.pPoolSizes    = &poolSize;
+  THROW_if_fail(
+      vkCreateDescriptorPool(m_vuDevice->m_device, &poolInfo, NO_ALLOC_CALLBACK, &m_inputAttachmentDescriptorPool));
+
+  VkDescriptorSetAllocateInfo allocInfo {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+  allocInfo.descriptorPool     = m_inputAttachmentDescriptorPool;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts        = &m_inputAttachmentSetLayout;
+  THROW_if_fail(vkAllocateDescriptorSets(m_vuDevice->m_device, &allocInfo, &m_inputAttachmentSet));
 }
 //======================================================================================================================
 void
@@ -739,21 +1298,57 @@ VuRenderer::initBindlessResourceManager(const VuRendererCreateInfo& info) {
   m_bdaBuffer = std::move(bdaBufferOrErr.value());
   THROW_if_fail(m_bdaBuffer.map());
 
+  for (u32 i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
+    writeBDA_ToGlobalPool(i);
+  }
+}
+//======================================================================================================================
+void
+VuRenderer::writeBDA_ToGlobalPool(u32 setIndex) const {
   VkDescriptorBufferInfo descBufferInfo {};
   descBufferInfo.buffer = m_bdaBuffer.m_buffer;
   descBufferInfo.range  = m_bdaBuffer.m_sizeInBytes;
 
-  for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-    VkWriteDescriptorSet descriptorWrite {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descriptorWrite.dstSet          = m_globalDescriptorSets[i];
-    descriptorWrite.dstBinding      = m_lastCreateInfo.storageBufferBinding;
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pBufferInfo     = &descBufferInfo;
+  VkWriteDescriptorSet descriptorWrite {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+  descriptorWrite.dstSet          = m_globalDescriptorSets[setIndex];
+  descriptorWrite.dstBinding      = m_lastCreateInfo.storageBufferBinding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  descriptorWrite.descriptorCount = 1;
+  descriptorWrite.pBufferInfo     = &descBufferInfo;
 
-    vkUpdateDescriptorSets(m_vuDevice->m_device, 1, &descriptorWrite, 0, nullptr);
-  }
+  vkUpdateDescriptorSets(m_vuDevice->m_device, 1, &descriptorWrite, 0, nullptr);
+}
+//======================================================================================================================
+void
+VuRenderer::resolveBindlessLimits() {
+  const VkPhysicalDeviceDescriptorIndexingProperties& limits = m_vuPhysicalDevice->m_descriptorIndexingProperties;
+  VuRendererCreateInfo&                               info   = m_lastCreateInfo;
+
+  // every binding is visible to all stages, so the per stage limits apply as well
+  const u32 maxSamplers =
+      std::min(limits.maxDescriptorSetUpdateAfterBindSamplers, limits.maxPerStageDescriptorUpdateAfterBindSamplers);
+  const u32 maxSampledImages = std::min(limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                                        limits.maxPerStageDescriptorUpdateAfterBindSampledImages);
+  const u32 maxStorageImages = std::min(limits.maxDescriptorSetUpdateAfterBindStorageImages,
+                                        limits.maxPerStageDescriptorUpdateAfterBindStorageImages);
+
+  info.samplerCount         = std::min(info.samplerCount, maxSamplers);
+  info.storageImageCount    = std::min(info.storageImageCount, maxStorageImages);
+  info.maxSampledImageCount = std::min(info.maxSampledImageCount, maxSampledImages);
+  info.sampledImageCount    = std::min(info.sampledImageCount, info.maxSampledImageCount);
+
+  m_samplerBindlessIndexAllocator = IndexAllocator {info.samplerCount, std::pmr::new_delete_resource()};
+  m_imgBindlessIndexAllocator     = IndexAllocator {info.sampledImageCount, std::pmr::new_delete_resource()};
+  m_sampledImageTableSize         = info.sampledImageCount;
+  m_bindlessImageInfos.resize(info.sampledImageCount);
+  m_bindlessSamplerInfos.resize(info.samplerCount);
+
+  Logger::Info("Bindless limits: {} samplers, {} storage images, {} sampled images (up to {})",
+               info.samplerCount,
+               info.storageImageCount,
+               info.sampledImageCount,
+               info.maxSampledImageCount);
 }
 //======================================================================================================================
 VuImage
@@ -772,6 +1367,10 @@ VuRenderer::createImageFromAsset(const path& path, VkFormat format) {
   u32               h = texHeight;
   VuImageCreateInfo createInfo {.width = w, .height = h, .format = format};
 
+  // file name is enough to tell textures apart in the memory stats, long names are cut
+  const std::string fileName = path.filename().string();
+  createInfo.name = VuName(fileName.c_str(), std::min(fileName.size(), VuName::capacity() - 1));
+
   auto vuImageOrrErr = VuImage::make(m_vuDevice, createInfo);
   THROW_if_unexpected(vuImageOrrErr);
   uploadToImage(vuImageOrrErr.value(), pixels, imageSize);
@@ -779,6 +1378,20 @@ VuRenderer::createImageFromAsset(const path& path, VkFormat format) {
   return std::move(vuImageOrrErr.value());
 }
 //======================================================================================================================
+VuComputePipeline
+VuRenderer::createComputePipeline(const path& shaderPath) const {
+  const auto spv = VuShader::compileToSpirv(shaderPath);
+  if (!spv.has_value()) {
+    Logger::Error("compute shader {} cannot be compiled!", shaderPath.string());
+    throw VK_ERROR_INITIALIZATION_FAILED;
+  }
+  // the pipeline keeps what it needs, the module can go right away
+  VkShaderModule shaderModule  = VuShader::createShaderModule(*m_vuDevice, spv->data(), spv->size());
+  auto           pipelineOrErr = VuComputePipeline::make(m_vuDevice, m_globalPipelineLayout, shaderModule);
+  vkDestroyShaderModule(m_vuDevice->m_device, shaderModule, NO_ALLOC_CALLBACK);
+  return move_or_THROW(pipelineOrErr);
+}
+//======================================================================================================================
 std::shared_ptr<GPU::VuMaterialDataHandle>
 VuRenderer::createMaterialDataIndex() {
   std::shared_ptr<GPU::VuMaterialDataHandle> handle        = std::make_shared<GPU::VuMaterialDataHandle>();
@@ -794,98 +1407,76 @@ VuRenderer::getMaterialDataSpan(const std::shared_ptr<GPU::VuMaterialDataHandle>
   return std::span<std::byte, config::MATERIAL_DATA_SIZE>(dataPtr, config::MATERIAL_DATA_SIZE);
 }
 //======================================================================================================================
-void
+bool
 VuRenderer::bindMaterial(const VkCommandBuffer& cb, const std::shared_ptr<VuMaterial>& material) {
   VuMaterial*         mat        = material.get();
   VuShader*           shader     = mat->m_shaderHnd.get();
-  VuGraphicsPipeline& vuPipeline = shader->requestPipeline(mat->m_materialSettings);
+  VuGraphicsPipeline* vuPipeline = shader->requestPipeline(mat->m_materialSettings);
+  if (vuPipeline == nullptr) { return false; }
 
-  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vuPipeline.m_pipeline);
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, vuPipeline->m_pipeline);
+  setDynamicRasterState(cb, *vuPipeline->m_vuDevice, *mat);
+  return true;
 }
 //======================================================================================================================
-void
-VuRenderer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-  VkBufferCopy    copyRegion {};
-  copyRegion.srcOffset = 0;
-  copyRegion.dstOffset = 0;
-  copyRegion.size      = size;
-  vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-  endSingleTimeCommands(commandBuffer);
+VuGraphicsPipeline*
+VuRenderer::requestGBufferPipeline(const VuMaterial& material, const bool depthPrepassed) const {
+  MaterialSettings settings = material.m_materialSettings;
+  settings.depthPrepassed   = depthPrepassed;
+  // auto mode switches between the two variants, the other one is kept compiled for when it does
+  if (m_deferredRenderSpace.hasDepthPrepass()) {
+    MaterialSettings other = settings;
+    other.depthPrepassed   = !depthPrepassed;
+    material.m_shaderHnd->precompilePipelines(std::span<const MaterialSettings> {&other, 1});
+  }
+  return material.m_shaderHnd->requestPipeline(settings);
 }
 //======================================================================================================================
 void
-VuRenderer::uploadToImage(const VuImage& vuImage, const byte* data, const VkDeviceSize size) {
-  // todo
-  auto res = m_stagingBuffer.setData(data, size);
-
-  transitionImageLayout(vuImage.m_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-  copyBufferToImage(
-      m_stagingBuffer.m_buffer, vuImage.m_image, vuImage.m_lastCreateInfo.width, vuImage.m_lastCreateInfo.height);
-
-  transitionImageLayout(
-      vuImage.m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+VuRenderer::setDynamicRasterState(const VkCommandBuffer& cb,
+                                  const VuDevice&        vuDevice,
+                                  const VuMaterial&      material,
+                                  const bool             depthPrepassed) {
+  MaterialSettings settings = material.m_materialSettings;
+  settings.depthPrepassed   = depthPrepassed;
+  setDynamicRasterState(cb,
+                        vuDevice,
+                        settings.toRasterState(),
+                        static_cast<u32>(material.m_shaderHnd->m_vuRenderPass->m_colorBlendAttachmentStates.size()));
 }
 //======================================================================================================================
 void
-VuRenderer::transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-  VkImageMemoryBarrier barrier {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-  barrier.oldLayout                       = oldLayout;
-  barrier.newLayout                       = newLayout;
-  barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image                           = image;
-  barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.baseMipLevel   = 0;
-  barrier.subresourceRange.levelCount     = 1;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount     = 1;
-
-  VkPipelineStageFlags sourceStage;
-  VkPipelineStageFlags destinationStage;
-
-  if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-    sourceStage      = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-  } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-             newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    sourceStage      = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  } else {
-    throw std::invalid_argument("Unsupported layout transition!");
+VuRenderer::setDynamicRasterState(const VkCommandBuffer&       cb,
+                                  const VuDevice&              vuDevice,
+                                  const VuPipelineRasterState& rasterState,
+                                  const u32                    colorAttachmentCount) {
+  // pipelines built with these states dynamic leave them to the command buffer
+  const VuDynamicRasterState& dynamicRasterState = vuDevice.m_dynamicRasterState;
+  if (dynamicRasterState.hasCullAndDepth()) {
+    dynamicRasterState.vkCmdSetCullMode(cb, rasterState.cullMode);
+    dynamicRasterState.vkCmdSetDepthTestEnable(cb, rasterState.depthTest ? VK_TRUE : VK_FALSE);
+    dynamicRasterState.vkCmdSetDepthWriteEnable(cb, rasterState.depthWrite ? VK_TRUE : VK_FALSE);
+    dynamicRasterState.vkCmdSetDepthCompareOp(cb, rasterState.depthCompareOp);
+  }
+  if (dynamicRasterState.hasBlendEnable() && colorAttachmentCount != 0) {
+    const std::vector<VkBool32> blendEnables(colorAttachmentCount, rasterState.blendEnable ? VK_TRUE : VK_FALSE);
+    dynamicRasterState.vkCmdSetColorBlendEnable(cb, 0, colorAttachmentCount, blendEnables.data());
   }
-
-  vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, ZERO_FLAG, 0, nullptr, 0, nullptr, 1, &barrier);
-  endSingleTimeCommands(commandBuffer);
 }
 //======================================================================================================================
 void
-VuRenderer::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-  VkBufferImageCopy region {};
-  region.bufferOffset                    = 0;
-  region.bufferRowLength                 = 0;
-  region.bufferImageHeight               = 0;
-  region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel       = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount     = 1;
-  region.imageOffset                     = VkOffset3D {0, 0, 0};
-  region.imageExtent                     = VkExtent3D {width, height, 1};
-
-  vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-  endSingleTimeCommands(commandBuffer);
+VuRenderer::uploadToImage(const VuImage& vuImage, const byte* data, const VkDeviceSize size) {
+  m_uploadContext.uploadToImage(vuImage, data, size);
+}
+//======================================================================================================================
+void
+VuRenderer::uploadToBuffer(const VuBuffer& vuBuffer, const void* data, const VkDeviceSize size) {
+  // mapped buffers are written directly, everything else goes through staging
+  if (vuBuffer.m_mapPtr != nullptr) {
+    THROW_if_fail(vuBuffer.setData(data, size));
+    return;
+  }
+  m_uploadContext.uploadToBuffer(vuBuffer, data, size);
 }
 //======================================================================================================================
 void
@@ -926,9 +1517,11 @@ VuRenderer::initImGui() {
   init_info.Queue                     = m_vuDevice->m_graphicsQueue;
   init_info.DescriptorPool            = m_uiDescriptorPool;
   init_info.MinImageCount             = 2;
-  init_info.ImageCount                = 2;
+  // imgui rotates its vertex buffers with this count, it has to cover every frame in flight
+  init_info.ImageCount                = config::MAX_FRAMES_IN_FLIGHT;
   init_info.UseDynamicRendering       = false;
   init_info.RenderPass                = m_deferredRenderSpace.m_lightningPass->m_renderPass;
+  init_info.Subpass                   = m_deferredRenderSpace.m_lightningPass->m_subpass;
 
   ImGui_ImplVulkan_Init(&init_info);
 
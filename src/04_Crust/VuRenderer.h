@@ -1,12 +1,23 @@
 #pragma once
+#include <functional>
+
+#include "01_InnerCore/FrameLimiter.h"
 #include "01_InnerCore/IndexAllocator.h"
+#include "01_InnerCore/ThreadPool.h"
 #include "01_InnerCore/TypeDefs.h"
 #include "02_OuterCore/VuConfig.h"
+#include "02_OuterCore/VuFileWatcher.h"
 #include "03_Mantle/VuBuffer.h"
+#include "03_Mantle/VuGpuProfiler.h"
+#include "03_Mantle/VuSecondaryCommandPools.h"
 #include "03_Mantle/VuSurface.h"
 #include "03_Mantle/VuTypes.h"
+#include "03_Mantle/VuUploadContext.h"
 #include "SDL3/SDL.h"
 #include "VuDeferredRenderSpace.h"
+#include "VuDepthPrepass.h"
+#include "VuLightClusters.h"
+#include "VuRenderQueue.h"
 
 struct ImGui_ImplVulkanH_Window;
 namespace vk {
@@ -21,6 +32,7 @@ struct VuPhysicalDevice;
 struct VuInstance;
 struct VuMaterial;
 struct VuMesh;
+struct VuGpuScene;
 } // namespace Vu
 
 namespace Vu {
@@ -29,20 +41,55 @@ struct VuSampler;
 struct VuRendererCreateInfo {
 
   // bindings that correspond to global bindless desc set
+  // sampled images use a variable descriptor count, which is only allowed on the last binding
   uint32_t uboBinding {0u};
   uint32_t samplerBinding {1u};
-  uint32_t sampledImageBinding {2u};
+  uint32_t storageBufferBinding {2u};
   uint32_t storageImageBinding {3u};
-  uint32_t storageBufferBinding {4u};
+  uint32_t sampledImageBinding {4u};
 
+  // counts are clamped to the device update after bind limits
   uint32_t uboCount {1u};
   uint32_t samplerCount {256u};
+  // initial size of the sampled image table, doubled when it runs out up to maxSampledImageCount
   uint32_t sampledImageCount {256u};
+  uint32_t maxSampledImageCount {1u << 16};
   uint32_t storageImageCount {256u};
   uint32_t storageBufferCount {256u};
+
+  // GBufferFull keeps the old RGBA32F targets around for A/B comparisons
+  GPU::GBufferLayout gBufferLayout {GPU::GBufferCompact};
+  // gbuffer and lightning as subpasses of one render pass, the lightning shader reads the gbuffer with subpassLoad.
+  // the gbuffer never leaves tile memory, but nothing can run between the two passes, gpu scene occlusion culling
+  // included
+  bool singlePassDeferred {false};
+  // depth only pass ahead of the gbuffer pass, not available with singlePassDeferred. while it runs the gbuffer pass
+  // only takes queued draws, as with VuRenderer::m_parallelRecording
+  VuDepthPrepassMode depthPrepassMode {VuDepthPrepassMode::Off};
+
+  // latency/throughput trade-off, each one can be changed later through the matching VuRenderer setter
+  VkPresentModeKHR presentMode {VK_PRESENT_MODE_IMMEDIATE_KHR};
+  // 0 asks for one image over the surface minimum
+  uint32_t swapChainImageCount {0u};
+  // clamped to [1, config::MAX_FRAMES_IN_FLIGHT]
+  uint32_t framesInFlight {2u};
+  // 0 disables the cpu frame limiter
+  float maxFps {0.0f};
+};
+
+// input latency as seen from the cpu, smoothed over recent frames. without present timing extensions the moment an
+// image reaches the display is unknown, gpu completion of the frame is the last point that can be observed
+struct VuFrameLatencyStats {
+  // input sampled until vkQueuePresentKHR returned
+  float inputToPresentMs {};
+  // input sampled until the frame's timeline value was seen complete, exact when the cpu had to wait for it
+  float inputToGpuDoneMs {};
+  // time the frame limiter held the last frame back
+  float limiterWaitMs {};
 };
 // #####################################################################################################################
 
+
 struct VuRenderer {
 
   std::shared_ptr<VuInstance>       m_vuInstance {};
@@ -53,11 +100,20 @@ struct VuRenderer {
   std::shared_ptr<VuDevice>         m_vuDevice {};
   VuDeferredRenderSpace             m_deferredRenderSpace {};
   ImGui_ImplVulkanH_Window*         m_imguiMainWindowData {};
+  // background work such as pipeline compilation
+  std::shared_ptr<ThreadPool> m_threadPool {};
+  // shader sources, checked by VuShader::tryRecompile
+  std::shared_ptr<VuFileWatcher> m_fileWatcher {};
   //
   VkCommandPool         m_commandPool {nullptr};
   VkDescriptorPool      m_descriptorPool {nullptr};
   VkDescriptorPool      m_uiDescriptorPool {nullptr};
   VkDescriptorSetLayout m_globalDescriptorSetLayout {nullptr};
+  // set 1 of the global pipeline layout, gbuffer input attachments of the single pass lightning subpass
+  VkDescriptorSetLayout m_inputAttachmentSetLayout {nullptr};
+  VkDescriptorPool      m_inputAttachmentDescriptorPool {nullptr};
+  // only written in single pass mode, rewritten with the gbuffer on swapchain resets
+  VkDescriptorSet       m_inputAttachmentSet {nullptr};
   VkPipelineLayout      m_globalPipelineLayout {nullptr};
   //
   std::vector<VkDescriptorSet> m_globalDescriptorSets {};
@@ -65,16 +121,30 @@ struct VuRenderer {
   //
   std::vector<VkSemaphore> m_imageAvailableSemaphores {};
   std::vector<VkSemaphore> m_renderFinishedSemaphores {};
-  std::vector<VkFence>     m_inFlightFences {};
+  // device timeline value signaled by the last submit of each frame in flight
+  std::vector<u64> m_frameTimelineValues {};
   //
   std::vector<VuBuffer> m_uniformBuffers {};
   u32                   m_currentFrame {};
+  // frames the cpu may record ahead of the gpu, the per frame resources exist for MAX_FRAMES_IN_FLIGHT
+  u32                   m_framesInFlight {config::MAX_FRAMES_IN_FLIGHT};
   u32                   m_currentFrameImageIndex {};
+  // frames submitted so far
+  u64                   m_frameNumber {};
   // VuDisposeStack               m_disposeStack {};
   IndexAllocator             m_imgBindlessIndexAllocator;
   IndexAllocator             m_samplerBindlessIndexAllocator;
   IndexAllocator             m_bufferBindlessIndexAllocator;
   IndexAllocator             m_materialDataBindlessIndexAllocator;
+  // cpu copy of every live bindless descriptor, null entries are free slots
+  std::vector<VkDescriptorImageInfo> m_bindlessImageInfos {};
+  std::vector<VkDescriptorImageInfo> m_bindlessSamplerInfos {};
+  // slots written since the last flush, all of them go out in one vkUpdateDescriptorSets
+  std::vector<std::pair<VuBindlessTable, u32>> m_pendingBindlessWrites {};
+  // handed to the device timeline with the value of the next frame submit
+  std::vector<std::function<void()>> m_pendingDestroys {};
+  // sampled image count the descriptor sets were allocated with
+  u32 m_sampledImageTableSize {};
   GPU::FrameConstant              m_frameConstant {};
   float                      m_deltaAsSecond {};
   u64                        m_prevTimeAsNanoSecond {};
@@ -87,11 +157,44 @@ struct VuRenderer {
   std::shared_ptr<VuImage>   m_defaultImage {};
   std::shared_ptr<VuImage>   m_defaultNormalImage {};
   std::shared_ptr<VuSampler> m_defaultSampler {};
+  VuUploadContext            m_uploadContext {};
+  // gbuffer draws of the current frame, sorted and recorded by beginLightningPass
+  VuRenderQueue      m_renderQueue {};
+  VuRenderQueueStats m_renderQueueStats {};
+  // GPU::InstanceData of the queued draws, one mapped buffer per frame in flight
+  std::vector<VuBuffer> m_instanceBuffers {};
+  // culled and drawn every frame next to the render queue when set, owned by the scene
+  VuGpuScene* m_gpuScene {};
+  // point lights of the scene, uploaded and assigned to clusters by every beginFrame
+  std::vector<GPU::PointLight> m_pointLights {};
+  VuLightClusters              m_lightClusters {};
+  // off makes the lighting pass loop over every light for every pixel
+  bool m_clusteredLighting {true};
+  VuDepthPrepass m_depthPrepass {};
+  // set by beginFrame, the gbuffer pass then begins in flushRenderQueue right after the prepass
+  bool m_gBufferDepthPrepassed {};
+  // gpu time of the frame and its passes, new passes add their own scope
+  VuGpuProfiler m_gpuProfiler {};
+  // gbuffer draws are recorded into secondary command buffers on the thread pool, read by beginFrame.
+  // the gbuffer pass then only takes queued draws, commands recorded directly into it are invalid
+  bool m_parallelRecording {true};
+  // consecutive packets sharing pipeline, material and mesh become one instanced draw, off for draw call benchmarks
+  bool m_mergeInstances {true};
+  // the gbuffer pass of the current frame was begun for secondary command buffers
+  bool                    m_gBufferPassIsSecondary {};
+  VuSecondaryCommandPools m_secondaryCommandPools {};
+  // sleeps in preUpdate, before input is sampled, so a limited frame still starts from fresh input
+  FrameLimiter        m_frameLimiter {};
+  VuFrameLatencyStats m_latencyStats {};
+  // SDL_GetTicksNS when pollUserInput ran, and the value each frame in flight was recorded with
+  u64              m_inputTimeNs {};
+  std::vector<u64> m_frameInputTimesNs {};
+  // set by the present mode and image count setters, the swapchain is rebuilt at the start of the next frame
+  bool m_swapChainDirty {};
 
 private:
   // holds the address of all other buffers
   VuBuffer             m_bdaBuffer {};
-  VuBuffer             m_stagingBuffer {};
   VuRendererCreateInfo m_lastCreateInfo {};
 
 public:
@@ -113,8 +216,9 @@ public:
   void
   beginFrame();
 
+  // records the queued gbuffer draws before switching passes
   void
-  beginLightningPass() const;
+  beginLightningPass();
 
   void
   endFrame();
@@ -122,7 +226,8 @@ public:
   void
   bindMesh(VuMesh& mesh);
 
-  void
+  // false when the material has no pipeline ready yet, the draw should be skipped
+  bool
   bindMaterial(std::shared_ptr<VuMaterial>& material);
 
   void
@@ -131,11 +236,63 @@ public:
   void
   drawIndexed(u32 indexCount) const;
 
+  // the draw is skipped while the material pipeline is still compiling
+  void
+  queueDraw(const std::shared_ptr<VuMaterial>& material,
+            VuMesh&                            mesh,
+            const float4x4&                    model,
+            const float3&                      worldPosition);
+
+  // sorts the render queue and records it as instanced draws, binds matching the previous draw are skipped
+  void
+  flushRenderQueue();
+
+  // secondary contents when m_gBufferPassIsSecondary, loads the prepass depth when m_gBufferDepthPrepassed
+  void
+  beginGBufferPass();
+
+  // records sorted packets [first, end) and writes their instance data, bind state starts empty
+  void
+  recordRenderQueueRange(const VkCommandBuffer& cb, u32 first, u32 end, VuRenderQueueStats& stats) const;
+
+  // full swapchain extent with a flipped viewport
+  void
+  setViewportAndScissor(const VkCommandBuffer& cb) const;
+
+  // grows the instance buffer of the current frame, its previous contents are dropped
+  void
+  reserveInstanceBuffer(u32 instanceCount);
+
+  // applied at the start of the next frame, unsupported modes fall back as in VuSwapChain::chooseSwapPresentMode
+  void
+  setPresentMode(VkPresentModeKHR presentMode);
+
+  // applied at the start of the next frame, 0 asks for one image over the surface minimum
+  void
+  setSwapChainImageCount(u32 imageCount);
+
+  // clamped to [1, config::MAX_FRAMES_IN_FLIGHT], takes effect with the next frame
+  void
+  setFramesInFlight(u32 framesInFlight);
+
+  // 0 disables the limiter
+  void
+  setMaxFps(float maxFps);
+
+  // leaving or entering Off rebuilds the render space at the start of the next frame, only a prepass needs the depth
+  // to outlive a render pass
+  void
+  setDepthPrepassMode(VuDepthPrepassMode mode);
+
+  // settings the renderer runs with, kept up to date by the setters
+  [[nodiscard]] const VuRendererCreateInfo&
+  getCreateInfo() const;
+
   void
   beginImgui() const;
 
   void
-  endImgui() const;
+  endImgui();
 
   void
   updateFrameConstantBuffer(GPU::FrameConstant ubo) const;
@@ -149,14 +306,19 @@ public:
   static float
   time();
 
+  // blocks until the previous submit of the current frame in flight completed
   void
-  waitForFences() const;
+  waitForFrame();
+
+  [[nodiscard]] VuSwapChainCreateInfo
+  swapChainCreateInfo() const;
 
   void
   resetSwapChain();
 
   void
-  bindGlobalBindlessSet(const VkCommandBuffer& commandBuffer) const;
+  bindGlobalBindlessSet(const VkCommandBuffer& commandBuffer,
+                        VkPipelineBindPoint    bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
 
   void
   initImGui();
@@ -177,6 +339,33 @@ public:
   void
   registerToBindless(VuSampler& vuSampler);
 
+  // the slot is reused once the current frame completed on the gpu, the resource must stay alive until the frame ends
+  void
+  unregisterFromBindless(VuBuffer& vuBuffer);
+
+  void
+  unregisterFromBindless(VuImage& vuImage);
+
+  void
+  unregisterFromBindless(VuSampler& vuSampler);
+
+  // drops the slot's descriptor and returns it to its allocator through deferDestroy. resources destroyed while still
+  // registered land here through VuDevice::m_bindlessSlotReleaser
+  void
+  releaseBindlessSlot(VuBindlessTable table, u32 index);
+
+  // grows the sampled image table if needed and writes pending descriptors
+  void
+  flushBindlessWrites();
+
+  // runs destroy once the frame being recorded, and every submit before it, completed on the gpu
+  void
+  deferDestroy(std::function<void()> destroy);
+
+  // called after the frame submit, ties pending destroys to the frame's timeline value
+  void
+  retireFrameResources(u64 frameTimelineValue);
+
   void
   initCommandPool(const VuRendererCreateInfo& info);
 
@@ -195,13 +384,20 @@ public:
   void
   initBindlessDescriptorSet();
 
-  /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // layout, pool and the single set, see VuGBufferInput for the bindings
+  void
+  initInputAttachmentSet();
 
-  [[nodiscard]] VkCommandBuffer
-  beginSingleTimeCommands() const;
+  // clamps the requested bindless counts to what the device supports with update after bind
+  void
+  resolveBindlessLimits();
 
   void
-  endSingleTimeCommands(const VkCommandBuffer& commandBuffer) const;
+  writeBDA_ToGlobalPool(u32 setIndex) const;
+
+  // reallocates every global set at the current sampled image capacity and requeues all live slots
+  void
+  growSampledImageTable();
 
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   /// RESOURCES
@@ -213,23 +409,40 @@ public:
   VuImage
   createImageFromAsset(const path& path, VkFormat format);
 
+  // compiles the shader and builds a pipeline on the global layout, throws when it does not compile
+  [[nodiscard]] VuComputePipeline
+  createComputePipeline(const path& shaderPath) const;
+
   std::shared_ptr<GPU::VuMaterialDataHandle>
   createMaterialDataIndex();
 
-  static void
+  static bool
   bindMaterial(const VkCommandBuffer& cb, const std::shared_ptr<VuMaterial>& material);
 
-  void
-  copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  // the material pipeline for the gbuffer pass, depthPrepassed selects the EQUAL depth test variant
+  [[nodiscard]] VuGraphicsPipeline*
+  requestGBufferPipeline(const VuMaterial& material, bool depthPrepassed) const;
 
-  void
-  uploadToImage(const VuImage& vuImage, const byte* data, VkDeviceSize size);
+  // applies the material raster state to whatever the bound pipeline left dynamic
+  static void
+  setDynamicRasterState(const VkCommandBuffer& cb,
+                        const VuDevice&        vuDevice,
+                        const VuMaterial&      material,
+                        bool                   depthPrepassed = false);
 
+  static void
+  setDynamicRasterState(const VkCommandBuffer&       cb,
+                        const VuDevice&              vuDevice,
+                        const VuPipelineRasterState& rasterState,
+                        u32                          colorAttachmentCount);
+
+  // uploads are batched, they are submitted together with the next frame
   void
-  transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
+  uploadToImage(const VuImage& vuImage, const byte* data, VkDeviceSize size);
 
+  // first upload of a freshly created buffer only
   void
-  copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+  uploadToBuffer(const VuBuffer& vuBuffer, const void* data, VkDeviceSize size);
 
   std::span<std::byte, Vu::config::MATERIAL_DATA_SIZE>
   getMaterialDataSpan(const std::shared_ptr<GPU::VuMaterialDataHandle>& handle) const;
@@ -1,7 +1,7 @@
 #include "VuShader.h"
 
 #include <algorithm>  // for max
-#include <cassert>    // for assert
+#include <chrono>
 #include <filesystem> // for path
 #include <format>     // for format
 #include <optional>
@@ -12,14 +12,17 @@
 #include <vector>  // for vector
 
 #include "../02_OuterCore/VuCommon.h"
+#include "01_InnerCore/ThreadPool.h"
 #include "01_InnerCore/TypeDefs.h" // for u32
 #include "01_InnerCore/VuLogger.h" // for Logger
 #include "02_OuterCore/VuConfig.h"
 #include "02_OuterCore/VuIO.h"
+#include "02_OuterCore/VuShaderCache.h"
 #include "03_Mantle/VuDevice.h"
 #include "03_Mantle/VuRenderPass.h"
 #include "04_Crust/VuMaterial.h"
 #include "VuRenderer.h"
+#include "VuSlangCompiler.h"
 
 //======================================================================================================================
 Vu::VuShader::VuShader(std::shared_ptr<VuRenderer>   vuRenderer,
@@ -31,25 +34,24 @@ Vu::VuShader::VuShader(std::shared_ptr<VuRenderer>   vuRenderer,
   this->m_vertexShaderPath   = vertexShaderPath;
   this->m_fragmentShaderPath = fragmentShaderPath;
 
-  m_lastModifiedTime = std::max(getlastModifiedTime(vertexShaderPath), getlastModifiedTime(fragmentShaderPath));
+  subscribeSourceFiles();
 
-  auto vertOutPath = compileToSpirv(vertexShaderPath);
-  auto fragOutPath = compileToSpirv(fragmentShaderPath);
-
-  const auto vertSpv = Vu::readFile(vertOutPath);
-  const auto fragSpv = Vu::readFile(fragOutPath);
+  // stages compile in parallel, the vertex one on the renderer thread pool
+  auto vertSpvFuture = vuRenderer->m_threadPool->submit([vertexShaderPath] { return compileToSpirv(vertexShaderPath); });
+  const auto fragSpv = compileToSpirv(fragmentShaderPath);
+  const auto vertSpv = vertSpvFuture.get();
 
   if (vertSpv.has_value()) {
     m_vertexShaderModule = createShaderModule(*vuRenderer->m_vuDevice, vertSpv.value().data(), vertSpv.value().size());
   } else {
-    Logger::Error("vertex spv file cannot be read!");
+    Logger::Error("vertex shader cannot be compiled!");
   }
 
   if (fragSpv.has_value()) {
     m_fragmentShaderModule =
         createShaderModule(*vuRenderer->m_vuDevice, fragSpv.value().data(), fragSpv.value().size());
   } else {
-    Logger::Error("frag spv file cannot be read!");
+    Logger::Error("frag shader cannot be compiled!");
   }
 }
 //======================================================================================================================
@@ -62,11 +64,14 @@ Vu::VuShader::VuShader(VuShader&& other) noexcept :
     m_fragmentShaderPath(std::move(other.m_fragmentShaderPath)),
     m_vertexShaderModule(other.m_vertexShaderModule),
     m_fragmentShaderModule(other.m_fragmentShaderModule),
-    m_lastModifiedTime(other.m_lastModifiedTime),
-    m_compiledPipelines(std::move(other.m_compiledPipelines)) {
+    m_watchId(other.m_watchId),
+    m_compiledPipelines(std::move(other.m_compiledPipelines)),
+    m_pendingPipelines(std::move(other.m_pendingPipelines)),
+    m_failedPipelines(std::move(other.m_failedPipelines)),
+    m_pendingReload(std::move(other.m_pendingReload)) {
   other.m_vertexShaderModule   = VK_NULL_HANDLE;
   other.m_fragmentShaderModule = VK_NULL_HANDLE;
-  other.m_lastModifiedTime     = 0;
+  other.m_watchId              = zero_optional<u32> {};
 }
 //======================================================================================================================
 Vu::VuShader&
@@ -79,12 +84,15 @@ Vu::VuShader::operator=(VuShader&& other) noexcept {
     m_fragmentShaderPath   = std::move(other.m_fragmentShaderPath);
     m_vertexShaderModule   = other.m_vertexShaderModule;
     m_fragmentShaderModule = other.m_fragmentShaderModule;
-    m_lastModifiedTime     = other.m_lastModifiedTime;
+    m_watchId              = other.m_watchId;
     m_compiledPipelines    = std::move(other.m_compiledPipelines);
+    m_pendingPipelines     = std::move(other.m_pendingPipelines);
+    m_failedPipelines      = std::move(other.m_failedPipelines);
+    m_pendingReload        = std::move(other.m_pendingReload);
 
     other.m_vertexShaderModule   = VK_NULL_HANDLE;
     other.m_fragmentShaderModule = VK_NULL_HANDLE;
-    other.m_lastModifiedTime     = 0;
+    other.m_watchId              = zero_optional<u32> {};
   }
   return *this;
 }
@@ -93,6 +101,19 @@ Vu::VuShader::~VuShader() { cleanup(); }
 //======================================================================================================================
 void
 Vu::VuShader::cleanup() {
+  // workers still read the shader modules
+  for (auto& [settings, future] : m_pendingPipelines) {
+    future.wait();
+  }
+  m_pendingPipelines.clear();
+  if (m_pendingReload.valid()) {
+    // a reload nobody will swap in, only its modules need manual destruction
+    std::optional<VuShaderVersion> version = m_pendingReload.get();
+    if (version.has_value()) {
+      vkDestroyShaderModule(m_vuRenderer->m_vuDevice->m_device, version->vertexShaderModule, nullptr);
+      vkDestroyShaderModule(m_vuRenderer->m_vuDevice->m_device, version->fragmentShaderModule, nullptr);
+    }
+  }
   if (m_vuRenderer) {
 
     if (m_vertexShaderModule != VK_NULL_HANDLE) {
@@ -104,59 +125,226 @@ Vu::VuShader::cleanup() {
       m_fragmentShaderModule = VK_NULL_HANDLE;
     }
   }
+  if (m_vuRenderer && m_watchId) { m_vuRenderer->m_fileWatcher->unsubscribe(*m_watchId); }
   m_compiledPipelines.clear();
-  m_lastModifiedTime = 0;
+  m_failedPipelines.clear();
+  m_watchId = zero_optional<u32> {};
   m_vuRenderer.reset();
   m_vuRenderPass.reset();
 }
 //======================================================================================================================
 void
 Vu::VuShader::tryRecompile() {
-  auto maxTime = std::max(getlastModifiedTime(m_vertexShaderPath), getlastModifiedTime(m_fragmentShaderPath));
-  if (maxTime <= m_lastModifiedTime) { return; }
+  if (m_pendingReload.valid()) {
+    if (m_pendingReload.wait_for(std::chrono::seconds(0)) != std::future_status::ready) { return; }
 
-  // store material settings to recreate them later
-  std::vector<MaterialSettings> currentlyAvailableMatSettings;
-  std::vector<std::string>      keys;
-  keys.reserve(m_compiledPipelines.size());
+    std::optional<VuShaderVersion> version = m_pendingReload.get();
+    if (version.has_value()) {
+      applyReload(std::move(version.value()));
+    } else {
+      Logger::Error("Shader reload failed, keeping the previous version: {}", m_fragmentShaderPath.string());
+    }
+    return;
+  }
+  if (!m_watchId || !m_vuRenderer->m_fileWatcher->consumeChange(*m_watchId)) { return; }
+  startReload();
+}
+//======================================================================================================================
+void
+Vu::VuShader::startReload() {
+  Logger::Info("Recompiling shader: {}", m_fragmentShaderPath.string());
+
+  // every permutation in use or on its way gets rebuilt against the new modules
+  std::vector<MaterialSettings> settings {};
+  settings.reserve(m_compiledPipelines.size() + m_pendingPipelines.size());
   for (const auto& pair : m_compiledPipelines) {
-    currentlyAvailableMatSettings.push_back(pair.first);
+    settings.push_back(pair.first);
+  }
+  for (const auto& pair : m_pendingPipelines) {
+    settings.push_back(pair.first);
   }
 
-  VkResult waitRes = vkDeviceWaitIdle(m_vuRenderer->m_vuDevice->m_device);
-  THROW_if_fail(waitRes);
+  auto job = [vuDevice       = m_vuRenderer->m_vuDevice,
+              pipelineLayout = m_vuRenderer->m_globalPipelineLayout,
+              renderPass     = m_vuRenderPass->m_renderPass,
+              subpass        = m_vuRenderPass->m_subpass,
+              colorBlends    = m_vuRenderPass->m_colorBlendAttachmentStates,
+              vertPath       = m_vertexShaderPath,
+              fragPath       = m_fragmentShaderPath,
+              settings       = std::move(settings)]() mutable -> std::optional<VuShaderVersion> {
+    // a failed reload keeps the previous version, nothing created for it may be left behind
+    VuShaderVersion version {};
+    auto            destroyModules = [&] {
+      if (version.vertexShaderModule != VK_NULL_HANDLE) {
+        vkDestroyShaderModule(vuDevice->m_device, version.vertexShaderModule, nullptr);
+      }
+      if (version.fragmentShaderModule != VK_NULL_HANDLE) {
+        vkDestroyShaderModule(vuDevice->m_device, version.fragmentShaderModule, nullptr);
+      }
+    };
+    try {
+      const auto vertSpv = compileToSpirv(vertPath);
+      const auto fragSpv = compileToSpirv(fragPath);
+      if (!vertSpv.has_value() || !fragSpv.has_value()) { return std::nullopt; }
 
-  auto newVuShaderOrErr = make(m_vuRenderer, m_vuRenderPass, m_vertexShaderPath, m_fragmentShaderPath);
-  THROW_if_unexpected(newVuShaderOrErr);
-  *this = std::move(newVuShaderOrErr.value());
+      version.vertexShaderModule   = createShaderModule(*vuDevice, vertSpv->data(), vertSpv->size());
+      version.fragmentShaderModule = createShaderModule(*vuDevice, fragSpv->data(), fragSpv->size());
+    } catch (...) {
+      destroyModules();
+      return std::nullopt;
+    }
+    for (const MaterialSettings& setting : settings) {
+      auto pipelineOrErr = VuGraphicsPipeline::make(vuDevice,
+                                                    pipelineLayout,
+                                                    version.vertexShaderModule,
+                                                    version.fragmentShaderModule,
+                                                    renderPass,
+                                                    subpass,
+                                                    colorBlends,
+                                                    setting.toRasterState());
+      if (pipelineOrErr.has_value()) { version.pipelines.emplace(setting, std::move(pipelineOrErr.value())); }
+    }
+    // swapping this in would retire every working pipeline for nothing
+    if (!settings.empty() && version.pipelines.empty()) {
+      destroyModules();
+      return std::nullopt;
+    }
+    return version;
+  };
+  m_pendingReload = m_vuRenderer->m_threadPool->submit(std::move(job));
+}
+//======================================================================================================================
+void
+Vu::VuShader::applyReload(VuShaderVersion&& version) {
+  // requested while the reload was running, these were queued against the old modules
+  std::vector<MaterialSettings> requeue {};
+  for (const auto& pair : m_pendingPipelines) {
+    if (!version.pipelines.contains(pair.first)) { requeue.push_back(pair.first); }
+  }
 
-  for (auto& setting : currentlyAvailableMatSettings) {
+  auto retired = std::make_shared<VuShaderVersion>(VuShaderVersion {
+      .vertexShaderModule   = m_vertexShaderModule,
+      .fragmentShaderModule = m_fragmentShaderModule,
+      .pipelines            = std::move(m_compiledPipelines),
+      .pendingPipelines     = std::move(m_pendingPipelines),
+  });
+  m_vuRenderer->deferDestroy([vuDevice = m_vuRenderer->m_vuDevice, retired] {
+    // pending jobs still read the old modules
+    for (auto& [settings, future] : retired->pendingPipelines) {
+      future.wait();
+    }
+    retired->pendingPipelines.clear();
+    retired->pipelines.clear();
+    vkDestroyShaderModule(vuDevice->m_device, retired->vertexShaderModule, nullptr);
+    vkDestroyShaderModule(vuDevice->m_device, retired->fragmentShaderModule, nullptr);
+  });
 
-    auto pipelineOrErr = VuGraphicsPipeline::make(m_vuRenderer->m_vuDevice,
-                                                  m_vuRenderer->m_globalPipelineLayout,
-                                                  m_vertexShaderModule,
-                                                  m_fragmentShaderModule,
-                                                  m_vuRenderPass->m_renderPass,
-                                                  m_vuRenderPass->m_colorBlendAttachmentStates);
+  m_vertexShaderModule   = version.vertexShaderModule;
+  m_fragmentShaderModule = version.fragmentShaderModule;
+  m_compiledPipelines    = std::move(version.pipelines);
+  m_pendingPipelines.clear();
+  // the new modules get another chance at every permutation that failed
+  m_failedPipelines.clear();
+  precompilePipelines(requeue);
 
-    m_compiledPipelines.emplace(setting, move_or_THROW(pipelineOrErr));
-  }
+  // the include graph may have changed, an edit made during the reload is carried over
+  const bool changedDuringReload = m_vuRenderer->m_fileWatcher->consumeChange(*m_watchId);
+  m_vuRenderer->m_fileWatcher->unsubscribe(*m_watchId);
+  subscribeSourceFiles();
+  if (changedDuringReload) { startReload(); }
+}
+//======================================================================================================================
+void
+Vu::VuShader::subscribeSourceFiles() {
+  const path        searchPaths[]   = {config::SHADER_MODULE_DIRECTORY};
+  std::vector<path> sourceFiles     = VuShaderCache::collectSourceFiles(m_vertexShaderPath, searchPaths);
+  std::vector<path> fragSourceFiles = VuShaderCache::collectSourceFiles(m_fragmentShaderPath, searchPaths);
+  sourceFiles.insert(sourceFiles.end(), fragSourceFiles.begin(), fragSourceFiles.end());
+  m_watchId = m_vuRenderer->m_fileWatcher->subscribe(sourceFiles);
 }
 //======================================================================================================================
-Vu::VuGraphicsPipeline&
+Vu::VuGraphicsPipeline*
 Vu::VuShader::requestPipeline(MaterialSettings materialSettings) {
-  bool contains = m_compiledPipelines.contains(materialSettings);
-  if (!contains) {
-    auto pipelineOrErr = VuGraphicsPipeline::make(m_vuRenderer->m_vuDevice,
-                                                  m_vuRenderer->m_globalPipelineLayout,
-                                                  m_vertexShaderModule,
-                                                  m_fragmentShaderModule,
-                                                  m_vuRenderPass->m_renderPass,
-                                                  m_vuRenderPass->m_colorBlendAttachmentStates);
+  collectReadyPipelines();
+
+  const MaterialSettings key = pipelineKeyOf(materialSettings);
+  auto                   it  = m_compiledPipelines.find(key);
+  if (it != m_compiledPipelines.end()) { return &it->second; }
+
+  queuePipeline(key);
+  if (m_compiledPipelines.empty()) { return nullptr; }
+  return &m_compiledPipelines.begin()->second;
+}
+//======================================================================================================================
+void
+Vu::VuShader::precompilePipelines(std::span<const MaterialSettings> materialSettings) {
+  for (const MaterialSettings& settings : materialSettings) {
+    queuePipeline(pipelineKeyOf(settings));
+  }
+}
+//======================================================================================================================
+void
+Vu::VuShader::waitForPendingPipelines() {
+  for (auto& [settings, future] : m_pendingPipelines) {
+    future.wait();
+  }
+  collectReadyPipelines();
+}
+//======================================================================================================================
+Vu::MaterialSettings
+Vu::VuShader::pipelineKeyOf(MaterialSettings materialSettings) const {
+  const VuDynamicRasterState& dynamicRasterState = m_vuRenderer->m_vuDevice->m_dynamicRasterState;
+  if (dynamicRasterState.hasCullAndDepth()) {
+    materialSettings.cullMode       = MaterialSettings {}.cullMode;
+    materialSettings.depthPrepassed = false;
+  }
+  // depth write follows transparency, it can only be folded away when blending is dynamic too
+  if (dynamicRasterState.hasCullAndDepth() && dynamicRasterState.hasBlendEnable()) {
+    materialSettings.isTransparent = false;
+  }
+  return materialSettings;
+}
+//======================================================================================================================
+void
+Vu::VuShader::queuePipeline(const MaterialSettings& materialSettings) {
+  if (m_compiledPipelines.contains(materialSettings) || m_pendingPipelines.contains(materialSettings) ||
+      m_failedPipelines.contains(materialSettings)) {
+    return;
+  }
 
-    m_compiledPipelines.emplace(materialSettings, move_or_THROW(pipelineOrErr));
+  // everything is captured by value, the shader may be moved while the job is in flight
+  auto job = [vuDevice       = m_vuRenderer->m_vuDevice,
+              pipelineLayout = m_vuRenderer->m_globalPipelineLayout,
+              vertModule     = m_vertexShaderModule,
+              fragModule     = m_fragmentShaderModule,
+              renderPass     = m_vuRenderPass->m_renderPass,
+              subpass        = m_vuRenderPass->m_subpass,
+              colorBlends    = m_vuRenderPass->m_colorBlendAttachmentStates,
+              rasterState    = materialSettings.toRasterState()]() mutable {
+    return VuGraphicsPipeline::make(
+        vuDevice, pipelineLayout, vertModule, fragModule, renderPass, subpass, colorBlends, rasterState);
+  };
+  m_pendingPipelines.emplace(materialSettings, m_vuRenderer->m_threadPool->submit(std::move(job)));
+}
+//======================================================================================================================
+void
+Vu::VuShader::collectReadyPipelines() {
+  for (auto it = m_pendingPipelines.begin(); it != m_pendingPipelines.end();) {
+    if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      ++it;
+      continue;
+    }
+    auto pipelineOrErr = it->second.get();
+    if (pipelineOrErr.has_value()) {
+      m_compiledPipelines.emplace(it->first, std::move(pipelineOrErr.value()));
+    } else {
+      Logger::Error("Pipeline creation failed for {}: {}",
+                    m_fragmentShaderPath.string(),
+                    static_cast<int32_t>(pipelineOrErr.error()));
+      m_failedPipelines.insert(it->first);
+    }
+    it = m_pendingPipelines.erase(it);
   }
-  return m_compiledPipelines[materialSettings];
 }
 //======================================================================================================================
 VkShaderModule
@@ -173,25 +361,59 @@ Vu::VuShader::createShaderModule(const VuDevice& vuDevice, const void* code, siz
   return shaderModule;
 }
 //======================================================================================================================
-path
+std::optional<std::vector<char>>
 Vu::VuShader::compileToSpirv(const path& shaderCodePath) {
   path shaderPath = shaderCodePath;
   shaderPath.make_preferred();
 
-  path spirvFilePath = shaderCodePath;
-  spirvFilePath.make_preferred();
-  spirvFilePath.replace_extension(".spv");
+  path moduleDirectory = config::SHADER_MODULE_DIRECTORY;
+  moduleDirectory.make_preferred();
+  const path        searchPaths[] = {moduleDirectory};
+  const std::string slangFlags    = "-target spirv -fvk-use-scalar-layout -I " + moduleDirectory.string();
 
   path compilerPath = config::getShaderCompilerPath();
   compilerPath.make_preferred();
 
-  std::string cmd = std::format("{0} {1} -target spirv -fvk-use-scalar-layout -o {2}",
-                                compilerPath.string(),
-                                shaderPath.string(),
-                                spirvFilePath.string());
+  // in-process builds key on the build tag of the linked Slang library, an SDK upgrade invalidates old entries
+  const std::string compilerVersion =
+      VuSlangCompiler::IS_AVAILABLE ? VuSlangCompiler::buildTag() : VuShaderCache::compilerFingerprint(compilerPath);
+
+  const u64 key           = VuShaderCache::computeKey(shaderPath, slangFlags, compilerVersion, searchPaths);
+  path      spirvFilePath = VuShaderCache::spirvPath(config::CACHE_DIRECTORY, shaderPath, key);
+  spirvFilePath.make_preferred();
+
+  if (std::filesystem::exists(spirvFilePath)) {
+    Logger::Trace("Shader cache hit: {}", shaderPath.string());
+    return readFile(spirvFilePath);
+  }
+
+  std::filesystem::create_directories(spirvFilePath.parent_path());
+  // written next to the final name first, a failed or interrupted compile never leaves a valid looking cache entry
+  path tempFilePath = spirvFilePath;
+  tempFilePath += ".tmp";
+
+  std::optional<std::vector<char>> spirv {};
+  if constexpr (VuSlangCompiler::IS_AVAILABLE) {
+    auto spirvsOrErr = VuSlangCompiler::compile(shaderPath, moduleDirectory);
+    if (!spirvsOrErr.has_value()) {
+      Logger::Error("Shader compilation failed: {}\n{}", shaderPath.string(), spirvsOrErr.error());
+      return std::nullopt;
+    }
+    spirv = std::move(spirvsOrErr->front());
+    createFile(tempFilePath, std::span(reinterpret_cast<const uint8_t*>(spirv->data()), spirv->size()));
+  } else {
+    std::string cmd = std::format(
+        "{0} {1} {2} -o {3}", compilerPath.string(), shaderPath.string(), slangFlags, tempFilePath.string());
 
-  int compileResult = system(cmd.c_str());
-  assert(compileResult == 0);
-  return spirvFilePath;
+    int compileResult = system(cmd.c_str());
+    if (compileResult != 0) {
+      Logger::Error("Shader compilation failed: {}", shaderPath.string());
+      std::filesystem::remove(tempFilePath);
+      return std::nullopt;
+    }
+    spirv = readFile(tempFilePath);
+  }
+  std::filesystem::rename(tempFilePath, spirvFilePath);
+  return spirv;
 }
-//======================================================================================================================
\ No newline at end of file
+//======================================================================================================================
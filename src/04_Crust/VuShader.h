@@ -1,4 +1,9 @@
 #pragma once
+#include <future>
+#include <span>
+#include <unordered_set>
+
+#include "01_InnerCore/zero_optional.h"
 #include "02_OuterCore/Common.h"
 #include "03_Mantle/VuGraphicsPipeline.h"
 #include "VuMaterial.h"
@@ -8,6 +13,17 @@ struct VuRenderer;
 struct VuRenderPass;
 struct VuDevice;
 
+using VuPipelineFuture = std::future<std::expected<VuGraphicsPipeline, VkResult>>;
+
+// modules and pipelines of one build of a shader, what a hot reload produces and what it retires
+struct VuShaderVersion {
+  VkShaderModule                                           vertexShaderModule {nullptr};
+  VkShaderModule                                           fragmentShaderModule {nullptr};
+  std::unordered_map<MaterialSettings, VuGraphicsPipeline> pipelines {};
+  std::unordered_map<MaterialSettings, VuPipelineFuture>   pendingPipelines {};
+};
+// #####################################################################################################################
+
 struct VuShader {
   std::shared_ptr<VuRenderer>                              m_vuRenderer {};
   std::shared_ptr<VuRenderPass>                            m_vuRenderPass {};
@@ -15,8 +31,15 @@ struct VuShader {
   path                                                     m_fragmentShaderPath {"error"};
   VkShaderModule                                           m_vertexShaderModule {nullptr};   // owned
   VkShaderModule                                           m_fragmentShaderModule {nullptr}; // owned
-  time_t                                                   m_lastModifiedTime {0};
+  // file watcher subscription covering both stages and everything they include
+  zero_optional<u32>                                       m_watchId {};
   std::unordered_map<MaterialSettings, VuGraphicsPipeline> m_compiledPipelines {};
+  // pipelines being created on the renderer thread pool, moved to m_compiledPipelines once ready
+  std::unordered_map<MaterialSettings, VuPipelineFuture>   m_pendingPipelines {};
+  // permutations whose creation failed, not queued again until the next reload
+  std::unordered_set<MaterialSettings>                     m_failedPipelines {};
+  // hot reload compiling on the renderer thread pool, swapped in by tryRecompile once ready
+  std::future<std::optional<VuShaderVersion>>              m_pendingReload {};
 
   SETUP_EXPECTED_WRAPPER(VuShader,
                          (std::shared_ptr<VuRenderer>   vuRenderer,
@@ -25,14 +48,26 @@ struct VuShader {
                           path                          fragmentShaderPath),
                          (vuRenderer, vuRenderPass, vertexShaderPath, fragmentShaderPath))
 
+  // call once per frame before recording. starts a background rebuild when the file watcher saw a change in any
+  // source file, and swaps a finished rebuild in. replaced objects are destroyed once frames using them complete
   void
   tryRecompile();
 
-  // get compiled pipeline handle if present, id not, compile and get
-  VuGraphicsPipeline&
+  // never blocks, a missing pipeline is queued for background compilation.
+  // until it is ready any other compiled pipeline of this shader is returned as a fallback, or null if there is none
+  VuGraphicsPipeline*
   requestPipeline(MaterialSettings materialSettings);
 
-  static path
+  // queue permutations known at load time so they are ready before the first draw
+  void
+  precompilePipelines(std::span<const MaterialSettings> materialSettings);
+
+  // blocks until every queued pipeline is compiled
+  void
+  waitForPendingPipelines();
+
+  // SPIR-V from the shader cache, compiled and stored there on a miss. nullopt when compilation fails
+  static std::optional<std::vector<char>>
   compileToSpirv(const path& shaderCodePath);
 
   static VkShaderModule
@@ -53,6 +88,25 @@ struct VuShader {
 private:
   void
   cleanup();
+
+  // settings the device applies dynamically are folded to one value, those materials share a pipeline
+  [[nodiscard]] MaterialSettings
+  pipelineKeyOf(MaterialSettings materialSettings) const;
+
+  void
+  queuePipeline(const MaterialSettings& materialSettings);
+
+  void
+  collectReadyPipelines();
+
+  void
+  subscribeSourceFiles();
+
+  void
+  startReload();
+
+  void
+  applyReload(VuShaderVersion&& version);
   //--------------------------------------------------------------------------------------------------------------------
 
   VuShader(std::shared_ptr<VuRenderer>   vuRenderer,
@@ -0,0 +1,183 @@
+#include "VuSlangCompiler.h"
+
+#ifdef VU_SLANG_API
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iterator>
+
+#include "01_InnerCore/Hash.h"
+#include "02_OuterCore/VuShaderCache.h"
+#include "slang-com-ptr.h"
+#include "slang.h"
+
+namespace Vu {
+
+// creating a global session loads the core module, that is the bulk of what a slangc run costs.
+// a global session must not be shared between threads, pool workers live for the whole run so each pays it once
+static slang::IGlobalSession*
+getGlobalSession() {
+  thread_local Slang::ComPtr<slang::IGlobalSession> globalSession {};
+  if (!globalSession) { slang::createGlobalSession(globalSession.writeRef()); }
+  return globalSession.get();
+}
+
+static std::string
+toString(slang::IBlob* diagnostics) {
+  if (diagnostics == nullptr) { return {}; }
+  return {static_cast<const char*>(diagnostics->getBufferPointer()), diagnostics->getBufferSize()};
+}
+
+// a session keeps every module it loaded, so the common modules are parsed once per thread. sessions are not thread
+// safe either, each thread keeps its own next to its global session
+struct VuSlangThreadSession {
+  Slang::ComPtr<slang::ISession> session {};
+  std::string                    searchPath {};
+  // sources of the preloaded modules, an edit to any of them needs a fresh session
+  u64 modulesKey {};
+  // every edit of a shader loads it once more under a new name, the session is rebuilt before that adds up
+  u32 shaderModuleCount {};
+};
+
+static constexpr u32 MAX_SHADER_MODULES_PER_SESSION = 256u;
+
+static std::vector<std::filesystem::path>
+listModules(const std::filesystem::path& moduleDirectory) {
+  std::vector<std::filesystem::path> modules {};
+  std::error_code                    ec {};
+  for (const auto& entry : std::filesystem::directory_iterator(moduleDirectory, ec)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".slang") { modules.push_back(entry.path()); }
+  }
+  std::ranges::sort(modules);
+  return modules;
+}
+
+static std::expected<VuSlangThreadSession*, std::string>
+getSession(slang::IGlobalSession* globalSession, const std::filesystem::path& moduleDirectory) {
+  thread_local VuSlangThreadSession threadSession {};
+
+  const std::vector<std::filesystem::path> modules       = listModules(moduleDirectory);
+  const std::filesystem::path              searchPaths[] = {moduleDirectory};
+  u64                                      modulesKey    = fnv1a64(moduleDirectory.string());
+  for (const std::filesystem::path& module : modules) {
+    const u64 moduleKey = VuShaderCache::computeKey(module, {}, {}, searchPaths);
+    modulesKey          = fnv1a64(std::as_bytes(std::span {&moduleKey, 1}), modulesKey);
+  }
+  if (threadSession.session && threadSession.modulesKey == modulesKey &&
+      threadSession.shaderModuleCount < MAX_SHADER_MODULES_PER_SESSION) {
+    return &threadSession;
+  }
+  threadSession = VuSlangThreadSession {.searchPath = moduleDirectory.string(), .modulesKey = modulesKey};
+
+  // same output as slangc -target spirv -fvk-use-scalar-layout -I moduleDirectory
+  slang::CompilerOptionEntry scalarLayout {};
+  scalarLayout.name            = slang::CompilerOptionName::GLSLForceScalarLayout;
+  scalarLayout.value.kind      = slang::CompilerOptionValueKind::Int;
+  scalarLayout.value.intValue0 = 1;
+
+  slang::TargetDesc targetDesc {};
+  targetDesc.format  = SLANG_SPIRV;
+  targetDesc.profile = globalSession->findProfile("spirv_1_5");
+
+  const char* searchPath = threadSession.searchPath.c_str();
+
+  slang::SessionDesc sessionDesc {};
+  sessionDesc.targets                  = &targetDesc;
+  sessionDesc.targetCount              = 1;
+  sessionDesc.searchPaths              = &searchPath;
+  sessionDesc.searchPathCount          = 1;
+  sessionDesc.compilerOptionEntries    = &scalarLayout;
+  sessionDesc.compilerOptionEntryCount = 1;
+
+  Slang::ComPtr<slang::ISession> session {};
+  if (SLANG_FAILED(globalSession->createSession(sessionDesc, session.writeRef()))) {
+    return std::unexpected("Slang session cannot be created");
+  }
+  for (const std::filesystem::path& module : modules) {
+    Slang::ComPtr<slang::IBlob> diagnostics {};
+    if (session->loadModule(module.stem().string().c_str(), diagnostics.writeRef()) == nullptr) {
+      return std::unexpected(toString(diagnostics));
+    }
+  }
+  // only kept once every module loaded, a broken module is retried with the next shader
+  threadSession.session = session;
+  return &threadSession;
+}
+
+std::string
+VuSlangCompiler::buildTag() {
+  slang::IGlobalSession* globalSession = getGlobalSession();
+  if (globalSession == nullptr) { return {}; }
+  return std::string {"slang-api:"} + globalSession->getBuildTagString();
+}
+
+std::expected<std::vector<std::vector<char>>, std::string>
+VuSlangCompiler::compile(const std::filesystem::path& shaderPath, const std::filesystem::path& moduleDirectory) {
+  slang::IGlobalSession* globalSession = getGlobalSession();
+  if (globalSession == nullptr) { return std::unexpected("Slang global session cannot be created"); }
+
+  std::ifstream file {shaderPath, std::ios::binary};
+  if (!file.is_open()) { return std::unexpected("Shader file cannot be read: " + shaderPath.string()); }
+  const std::string source {std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {}};
+
+  auto threadSessionOrErr = getSession(globalSession, moduleDirectory);
+  if (!threadSessionOrErr.has_value()) { return std::unexpected(threadSessionOrErr.error()); }
+  VuSlangThreadSession& threadSession = *threadSessionOrErr.value();
+  slang::ISession*      session       = threadSession.session.get();
+
+  // named after the content, the session serves modules by name and must not hand out the version before an edit
+  const std::string moduleName = std::format("{}_{:016x}", shaderPath.stem().string(), fnv1a64(source));
+  ++threadSession.shaderModuleCount;
+
+  Slang::ComPtr<slang::IBlob> diagnostics {};
+  slang::IModule*             module = session->loadModuleFromSourceString(
+      moduleName.c_str(), shaderPath.string().c_str(), source.c_str(), diagnostics.writeRef());
+  if (module == nullptr) { return std::unexpected(toString(diagnostics)); }
+
+  const SlangInt32 entryPointCount = module->getDefinedEntryPointCount();
+  if (entryPointCount == 0) { return std::unexpected("No entry point in " + shaderPath.string()); }
+
+  std::vector<Slang::ComPtr<slang::IEntryPoint>> entryPoints(entryPointCount);
+  std::vector<slang::IComponentType*>            components {module};
+  for (SlangInt32 i = 0; i < entryPointCount; ++i) {
+    module->getDefinedEntryPoint(i, entryPoints[i].writeRef());
+    components.push_back(entryPoints[i]);
+  }
+
+  Slang::ComPtr<slang::IComponentType> program {};
+  if (SLANG_FAILED(session->createCompositeComponentType(
+          components.data(), static_cast<SlangInt>(components.size()), program.writeRef(), diagnostics.writeRef()))) {
+    return std::unexpected(toString(diagnostics));
+  }
+
+  Slang::ComPtr<slang::IComponentType> linkedProgram {};
+  if (SLANG_FAILED(program->link(linkedProgram.writeRef(), diagnostics.writeRef()))) {
+    return std::unexpected(toString(diagnostics));
+  }
+
+  std::vector<std::vector<char>> spirvs {};
+  for (SlangInt32 i = 0; i < entryPointCount; ++i) {
+    Slang::ComPtr<slang::IBlob> code {};
+    if (SLANG_FAILED(linkedProgram->getEntryPointCode(i, 0, code.writeRef(), diagnostics.writeRef()))) {
+      return std::unexpected(toString(diagnostics));
+    }
+    const auto* begin = static_cast<const char*>(code->getBufferPointer());
+    spirvs.emplace_back(begin, begin + code->getBufferSize());
+  }
+  return spirvs;
+}
+} // namespace Vu
+
+#else
+
+std::expected<std::vector<std::vector<char>>, std::string>
+Vu::VuSlangCompiler::compile(const std::filesystem::path& shaderPath, const std::filesystem::path&) {
+  return std::unexpected("Built without VuSlangApi, cannot compile " + shaderPath.string());
+}
+
+std::string
+Vu::VuSlangCompiler::buildTag() {
+  return {};
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Vu {
+
+// In-process Slang compilation, only available when built with the VuSlangApi cmake option.
+// Safe to call from several threads at once, every thread keeps its own global session and a session that holds the
+// modules of the module directory, parsed once instead of for every shader importing them.
+struct VuSlangCompiler {
+  static constexpr bool IS_AVAILABLE =
+#ifdef VU_SLANG_API
+      true;
+#else
+      false;
+#endif
+
+  // SPIR-V of every entry point defined in the file, compiled and linked in a single request. imports are resolved
+  // against moduleDirectory
+  static std::expected<std::vector<std::vector<char>>, std::string>
+  compile(const std::filesystem::path& shaderPath, const std::filesystem::path& moduleDirectory);
+
+  // build tag of the linked Slang library, changes with every SDK upgrade. empty when not available
+  static std::string
+  buildTag();
+};
+} // namespace Vu
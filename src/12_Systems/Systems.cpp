@@ -1,7 +1,11 @@
 #include "Systems.h"
 
+#include "01_InnerCore/VuLogger.h"
 #include "02_OuterCore/math/VuMathMatrix.h"
 #include "03_Mantle/VuBuffer.h"
+#include "03_Mantle/VuDevice.h"
+#include "03_Mantle/VuMemoryTracker.h"
+#include "04_Crust/VuGpuScene.h"
 #include "04_Crust/VuMaterial.h"
 #include "04_Crust/VuMesh.h"
 #include "04_Crust/VuRenderer.h"
@@ -13,25 +17,8 @@
 void
 Vu::drawMesh(VuRenderer& vuRenderer, Transform& transform, const MeshRenderer& meshRenderer) {
 
-  std::shared_ptr<VuMaterial> materialHnd = meshRenderer.materialHnd;
-
-  VuMaterial*          matPtr       = materialHnd.get();
-  GPU::VuMaterialDataHandle matDataIndex = *matPtr->m_materialDataHnd;
-
-  // bind pipeline
-  vuRenderer.bindMaterial(materialHnd);
-
-  // push constant
-  float4x4     trs = transform.ToTRS();
-  GPU::PushConstant pc {.model              = trs,
-                   .materialDataHandle = matDataIndex,
-                   .mesh               = {meshRenderer.mesh->m_vertexBuffer->m_bindlessIndex.value_or_THROW(),
-                                          meshRenderer.mesh->m_vertexCount,
-                                          ZERO_FLAG}};
-  vuRenderer.pushConstants(pc);
-  vuRenderer.bindMesh(*meshRenderer.mesh);
-  uint32_t indexCount = meshRenderer.mesh->m_indexBuffer->m_sizeInBytes / 4;
-  vuRenderer.drawIndexed(indexCount);
+  // recorded in state order when the gbuffer pass ends, meshes sharing a material become one instanced draw
+  vuRenderer.queueDraw(meshRenderer.materialHnd, *meshRenderer.mesh, transform.ToTRS(), transform.m_position);
 }
 void
 Vu::spinn(const VuRenderer& vuRenderer, Transform& trs, const Spinn& spin) {
@@ -118,6 +105,8 @@ Vu::cameraFlySystem(VuRenderer& vuRenderer, Transform& trs, Camera& cam) {
       cam.near,
       cam.far);
 
+  vuRenderer.m_frameConstant.camera.nearPlane   = cam.near;
+  vuRenderer.m_frameConstant.camera.farPlane    = cam.far;
   vuRenderer.m_frameConstant.camera.inverseView = trs.ToTRS();
   vuRenderer.m_frameConstant.camera.inverseProj = Math::inverse(vuRenderer.m_frameConstant.camera.proj);
 
@@ -125,4 +114,199 @@ Vu::cameraFlySystem(VuRenderer& vuRenderer, Transform& trs, Camera& cam) {
   vuRenderer.m_frameConstant.camera.direction = float4(float3(cam.yaw, cam.pitch, cam.roll), 0);
   vuRenderer.m_frameConstant.time             = float4(vuRenderer.time(), 0, 0, 0).x;
   vuRenderer.updateFrameConstantBuffer(vuRenderer.m_frameConstant);
-}
\ No newline at end of file
+}
+void
+Vu::drawGpuMemoryUI(const VuRenderer& vuRenderer) {
+  if (!ImGui::CollapsingHeader("GPU Memory")) { return; }
+
+  constexpr float MIB = 1024.0f * 1024.0f;
+
+  const VuMemoryTracker& tracker = *vuRenderer.m_vuDevice->m_memoryTracker;
+  const VuMemoryStats    stats   = tracker.getStats();
+
+  ImGui::Text("Total: %.2f MiB (peak %.2f MiB)", stats.totalBytes / MIB, stats.peakTotalBytes / MIB);
+  ImGui::Text("Live allocations: %u (vkAllocateMemory calls: %llu)",
+              stats.liveAllocationCount,
+              static_cast<unsigned long long>(stats.allocateCallCount));
+
+  if (ImGui::BeginTable("##gpuMemoryCategories", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    ImGui::TableSetupColumn("Category");
+    ImGui::TableSetupColumn("MiB");
+    ImGui::TableSetupColumn("Peak MiB");
+    ImGui::TableSetupColumn("Count");
+    ImGui::TableHeadersRow();
+    for (u32 i = 0; i < stats.categories.size(); ++i) {
+      const VuMemoryCategoryStats& category = stats.categories[i];
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(toString(static_cast<VuMemoryCategory>(i)));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", category.currentBytes / MIB);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", category.peakBytes / MIB);
+      ImGui::TableNextColumn();
+      ImGui::Text("%u", category.liveAllocationCount);
+    }
+    ImGui::EndTable();
+  }
+
+  for (const VuHeapBudget& heap : vuRenderer.m_vuDevice->queryMemoryBudget()) {
+    const bool isDeviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    ImGui::Text("Heap %u%s: %.1f / %.1f MiB (size %.1f MiB)",
+                heap.heapIndex,
+                isDeviceLocal ? " (device local)" : "",
+                heap.usage / MIB,
+                heap.budget / MIB,
+                heap.size / MIB);
+  }
+  if (!vuRenderer.m_vuDevice->m_memoryBudgetEnabled) { ImGui::TextDisabled("VK_EXT_memory_budget not available"); }
+
+  if (ImGui::TreeNode("Allocations")) {
+    for (const VuMemoryRecord& record : tracker.getRecords()) {
+      ImGui::Text("%-32s %-12s %8.2f MiB  type %u",
+                  record.tag.name.c_str(),
+                  toString(record.tag.category),
+                  record.sizeInBytes / MIB,
+                  record.memoryTypeIndex);
+    }
+    ImGui::TreePop();
+  }
+
+  if (ImGui::Button("Dump JSON")) {
+    if (tracker.dumpJson("gpu_memory.json")) {
+      Logger::Info("GPU memory stats written to gpu_memory.json");
+    } else {
+      Logger::Warn("Failed to write gpu_memory.json");
+    }
+  }
+}
+void
+Vu::drawRenderQueueUI(VuRenderer& vuRenderer) {
+  if (!ImGui::CollapsingHeader("Render Queue")) { return; }
+
+  ImGui::Checkbox("Parallel recording", &vuRenderer.m_parallelRecording);
+  ImGui::Checkbox("Merge instances", &vuRenderer.m_mergeInstances);
+
+  const VuRenderQueueStats& stats = vuRenderer.m_renderQueueStats;
+  ImGui::Text("Record: %.3f ms (%u secondary command buffers)",
+              stats.recordMilliseconds,
+              stats.secondaryCommandBuffers);
+  ImGui::Text("Draws: %u (instances %u)", stats.drawCount, stats.instanceCount);
+  ImGui::Text("Pipeline binds: %u (skipped %u)", stats.pipelineBinds, stats.pipelineBindsSkipped);
+  ImGui::Text("Index buffer binds: %u (skipped %u)", stats.indexBufferBinds, stats.indexBufferBindsSkipped);
+  if (vuRenderer.m_gpuScene != nullptr) {
+    const VuGpuScene&        gpuScene = *vuRenderer.m_gpuScene;
+    const GPU::GpuCullStats& cull     = gpuScene.m_lastStats;
+    ImGui::Text("GPU scene objects: %u", gpuScene.getObjectCount());
+    ImGui::Text("Occlusion culling: %s", gpuScene.canOcclusionCull() ? "on" : "off (depth not stored)");
+    ImGui::Text("Drawn: %u (early %u, late %u)", cull.earlyDrawn + cull.lateDrawn, cull.earlyDrawn, cull.lateDrawn);
+    ImGui::Text("Culled: %u (frustum %u, occlusion %u)",
+                cull.frustumCulled + cull.occlusionCulled,
+                cull.frustumCulled,
+                cull.occlusionCulled);
+  }
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+Vu::drawFramePacingUI(VuRenderer& vuRenderer) {
+  if (!ImGui::CollapsingHeader("Frame Pacing")) { return; }
+
+  constexpr VkPresentModeKHR presentModes[] = {
+      VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+  const VkPresentModeKHR requested = vuRenderer.getCreateInfo().presentMode;
+  if (ImGui::BeginCombo("Present mode", toString(requested))) {
+    for (VkPresentModeKHR mode : presentModes) {
+      if (ImGui::Selectable(toString(mode), mode == requested)) { vuRenderer.setPresentMode(mode); }
+    }
+    ImGui::EndCombo();
+  }
+  const VuSwapChain& swapChain = vuRenderer.m_deferredRenderSpace.m_vuSwapChain;
+  ImGui::Text("Active: %s, %zu images", toString(swapChain.m_presentMode), swapChain.m_images.size());
+
+  int imageCount = static_cast<int>(vuRenderer.getCreateInfo().swapChainImageCount);
+  if (ImGui::SliderInt("Swapchain images (0 = auto)", &imageCount, 0, 8)) {
+    vuRenderer.setSwapChainImageCount(static_cast<u32>(imageCount));
+  }
+  int framesInFlight = static_cast<int>(vuRenderer.m_framesInFlight);
+  if (ImGui::SliderInt("Frames in flight", &framesInFlight, 1, static_cast<int>(config::MAX_FRAMES_IN_FLIGHT))) {
+    vuRenderer.setFramesInFlight(static_cast<u32>(framesInFlight));
+  }
+  float maxFps = vuRenderer.getCreateInfo().maxFps;
+  if (ImGui::SliderFloat("Fps limit (0 = off)", &maxFps, 0.0f, 480.0f, "%.0f")) { vuRenderer.setMaxFps(maxFps); }
+
+  const VuFrameLatencyStats& latency = vuRenderer.m_latencyStats;
+  ImGui::Text("Input to present call: %.2f ms", latency.inputToPresentMs);
+  ImGui::Text("Input to gpu done: %.2f ms", latency.inputToGpuDoneMs);
+  ImGui::Text("Limiter wait: %.2f ms", latency.limiterWaitMs);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+Vu::drawDepthPrepassUI(VuRenderer& vuRenderer) {
+  if (!ImGui::CollapsingHeader("Depth Prepass")) { return; }
+
+  constexpr VuDepthPrepassMode modes[] = {VuDepthPrepassMode::Off, VuDepthPrepassMode::On, VuDepthPrepassMode::Auto};
+  const VuDepthPrepassMode     requested = vuRenderer.getCreateInfo().depthPrepassMode;
+  if (ImGui::BeginCombo("Mode", toString(requested))) {
+    for (VuDepthPrepassMode mode : modes) {
+      if (ImGui::Selectable(toString(mode), mode == requested)) { vuRenderer.setDepthPrepassMode(mode); }
+    }
+    ImGui::EndCombo();
+  }
+  if (vuRenderer.m_deferredRenderSpace.isSinglePass()) { ImGui::Text("Not available with single pass deferred"); }
+
+  const VuDepthPrepass&      depthPrepass = vuRenderer.m_depthPrepass;
+  const VuDepthPrepassStats& stats        = depthPrepass.m_stats;
+  ImGui::Text("Active: %s (%u draws)", vuRenderer.m_gBufferDepthPrepassed ? "yes" : "no", stats.drawCount);
+  if (!stats.measurable) {
+    ImGui::Text("Overdraw: not measurable, no precise occlusion queries");
+    return;
+  }
+  ImGui::Text("Overdraw: %.2f samples per covered pixel", stats.overdraw);
+  ImGui::Text("Auto: on above %.2f, off below %.2f",
+              depthPrepass.m_createInfo.enableOverdraw,
+              depthPrepass.m_createInfo.disableOverdraw);
+}
+void
+Vu::drawGpuProfilerUI(VuRenderer& vuRenderer) {
+  if (!ImGui::CollapsingHeader("GPU Timings")) { return; }
+
+  VuGpuProfiler& profiler = vuRenderer.m_gpuProfiler;
+  if (!profiler.isSupported()) {
+    ImGui::TextDisabled("Timestamp queries not supported on the graphics queue");
+    return;
+  }
+  ImGui::Checkbox("Enabled", &profiler.m_enabled);
+
+  if (ImGui::BeginTable("##gpuTimings", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    ImGui::TableSetupColumn("Scope");
+    ImGui::TableSetupColumn("Last ms");
+    ImGui::TableSetupColumn("Avg ms");
+    ImGui::TableSetupColumn("Min ms");
+    ImGui::TableSetupColumn("Max ms");
+    ImGui::TableHeadersRow();
+    for (const VuGpuScopeStats& stats : profiler.m_timings.getStats()) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(stats.name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.lastMs);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.avgMs);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.minMs);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.maxMs);
+    }
+    ImGui::EndTable();
+  }
+
+  if (ImGui::Button("Export CSV")) {
+    if (profiler.m_timings.dumpCsv("gpu_timings.csv")) {
+      Logger::Info("GPU timings written to gpu_timings.csv");
+    } else {
+      Logger::Warn("Failed to write gpu_timings.csv");
+    }
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Reset")) { profiler.m_timings.clear(); }
+}
@@ -16,6 +16,21 @@ void drawSpinUI(uint32_t elemID, Spinn& spinn);
 
 void cameraFlySystem(VuRenderer& vuRenderer, Transform& trs, Camera& cam);
 
+// per category totals/peaks of device memory, heap budgets and a json dump button
+void drawGpuMemoryUI(const VuRenderer& vuRenderer);
+
+// draw and bind counts of the last flushed render queue, with the recording toggles
+void drawRenderQueueUI(VuRenderer& vuRenderer);
+
+// present mode, swapchain image count, frames in flight, fps limit and the measured input latency
+void drawFramePacingUI(VuRenderer& vuRenderer);
+
+// depth prepass mode with the measured overdraw that drives auto mode
+void drawDepthPrepassUI(VuRenderer& vuRenderer);
+
+// rolling gpu time of every profiler scope with a csv export button
+void drawGpuProfilerUI(VuRenderer& vuRenderer);
+
 // inline flecs::system AddTransformUISystem(flecs::world& world)
 // {
 //     return world.system<Transform>("trsUI")
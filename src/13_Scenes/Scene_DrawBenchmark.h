@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "01_InnerCore/VuLogger.h"
+#include "02_OuterCore/Common.h"
+#include "03_Mantle/VuImage.h"
+#include "04_Crust/VuAssetLoader.h"
+#include "04_Crust/VuMaterial.h"
+#include "04_Crust/VuMesh.h"
+#include "04_Crust/VuRenderer.h"
+#include "04_Crust/VuShader.h"
+#include "11_Components/Camera.h"
+#include "11_Components/Components.h"
+#include "11_Components/Transform.h"
+#include "12_Systems/Systems.h"
+
+namespace Vu {
+
+// Measures the cpu cost of recording the gbuffer draws, inline against secondary command buffers on the thread pool.
+// Instance merging is off so every queued cube is its own draw call, results are logged and the scene exits.
+struct Scene_DrawBenchmark {
+private:
+  path cubePath = "assets/gltf/Cube.glb";
+
+  path pbrVertPath = "assets/shaders/object/deferred/pbr_deferred_vert.slang";
+  path pbrFragPath = "assets/shaders/object/deferred/pbr_deferred_frag.slang";
+
+  static constexpr std::array<u32, 2> DRAW_COUNTS    = {10'000u, 50'000u};
+  static constexpr u32                WARMUP_FRAMES  = 32u;
+  static constexpr u32                MEASURE_FRAMES = 256u;
+
+public:
+  void
+  run() const {
+    constexpr Vu::VuRendererCreateInfo info {};
+    std::shared_ptr<VuRenderer>        vuRenderer = std::make_shared<VuRenderer>(info);
+
+    VuMesh mesh {};
+    VuAssetLoader::loadGLTF(*vuRenderer, cubePath, mesh);
+
+    std::shared_ptr<VuShader> basicShader = std::make_shared<VuShader>(move_or_THROW(
+        VuShader::make(vuRenderer, vuRenderer->m_deferredRenderSpace.m_gBufferPass, pbrVertPath, pbrFragPath)));
+
+    std::shared_ptr<GPU::VuMaterialDataHandle> matDataHnd = vuRenderer->createMaterialDataIndex();
+    std::shared_ptr<VuMaterial> material = std::make_shared<VuMaterial>(MaterialSettings {}, basicShader, matDataHnd);
+
+    auto* matData                = vuRenderer->getMaterialDataPointerAs<GPU::MatData_PbrDeferred>(*matDataHnd);
+    matData->colorTexture        = vuRenderer->m_defaultImage->m_bindlessIndex.value_or_THROW();
+    matData->normalTexture       = vuRenderer->m_defaultNormalImage->m_bindlessIndex.value_or_THROW();
+    matData->aoRoughMetalTexture = vuRenderer->m_defaultImage->m_bindlessIndex.value_or_THROW();
+    basicShader->waitForPendingPipelines();
+
+    auto camTrs = Transform(float3(0.0f, 0.0f, 3.5f), quaternion::identity(), float3(1, 1, 1));
+    auto cam    = Camera {};
+
+    vuRenderer->m_mergeInstances = false;
+    for (const u32 drawCount : DRAW_COUNTS) {
+      // a square grid of small cubes in front of the camera
+      std::vector<Transform> transforms {};
+      transforms.reserve(drawCount);
+      const u32 side = static_cast<u32>(std::ceil(std::sqrt(static_cast<float>(drawCount))));
+      for (u32 i = 0; i < drawCount; ++i) {
+        const float x = (static_cast<float>(i % side) / side - 0.5f) * 40.0f;
+        const float y = (static_cast<float>(i / side) / side - 0.5f) * 40.0f;
+        transforms.push_back({.m_position = float3(x, y, -30.0f),
+                              .rotation   = quaternion::identity(),
+                              .scale      = float3(0.1f, 0.1f, 0.1f)});
+      }
+
+      for (const bool parallel : {false, true}) {
+        vuRenderer->m_parallelRecording = parallel;
+
+        double recordMilliseconds {};
+        double frameMilliseconds {};
+        for (u32 frame = 0; frame < WARMUP_FRAMES + MEASURE_FRAMES; ++frame) {
+          if (vuRenderer->shouldWindowClose()) { break; }
+          vuRenderer->preUpdate();
+          vuRenderer->pollUserInput();
+          cameraFlySystem(*vuRenderer, camTrs, cam);
+
+          const auto startTime = std::chrono::steady_clock::now();
+          vuRenderer->beginFrame();
+          for (Transform& transform : transforms) {
+            vuRenderer->queueDraw(material, mesh, transform.ToTRS(), transform.m_position);
+          }
+          vuRenderer->beginLightningPass();
+          vuRenderer->endFrame();
+          const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+
+          if (frame >= WARMUP_FRAMES) {
+            recordMilliseconds += vuRenderer->m_renderQueueStats.recordMilliseconds;
+            frameMilliseconds += elapsed.count();
+          }
+        }
+        Logger::Info("Draw benchmark {} draws, {}: record {:.3f} ms, frame cpu {:.3f} ms, {} secondary buffers",
+                     drawCount,
+                     parallel ? "parallel" : "inline",
+                     recordMilliseconds / MEASURE_FRAMES,
+                     frameMilliseconds / MEASURE_FRAMES,
+                     vuRenderer->m_renderQueueStats.secondaryCommandBuffers);
+      }
+    }
+
+    THROW_if_fail(vkDeviceWaitIdle(vuRenderer->m_vuDevice->m_device));
+  }
+};
+} // namespace Vu
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <filesystem>
+#include <optional>
+#include <vector>
 
 #include "02_OuterCore/Common.h"
 #include "03_Mantle/VuImage.h"
+#include "03_Mantle/VuPhysicalDevice.h"
 #include "04_Crust/VuAssetLoader.h"
+#include "04_Crust/VuGpuScene.h"
 #include "04_Crust/VuMaterial.h"
 #include "04_Crust/VuMesh.h"
 #include "04_Crust/VuRenderer.h"
@@ -29,14 +33,21 @@ private:
 
   path defVertPath = "assets/shaders/engine/screen_space_triangle_vert.slang";
   path defFragPath = "assets/shaders/engine/deferred_render_space/deferred_lightning_pass_frag.slang";
+  // reads the gbuffer as input attachments, used with VuRendererCreateInfo::singlePassDeferred
+  path defSubpassFragPath = "assets/shaders/engine/deferred_render_space/deferred_lightning_subpass_frag.slang";
 
   bool uiNeedBuild = true;
 
 public:
+  // gbuffer and lightning in one render pass, see VuRendererCreateInfo::singlePassDeferred
+  bool singlePassDeferred = false;
+
   void
   run() const {
-    constexpr Vu::VuRendererCreateInfo info {};
-    std::shared_ptr<VuRenderer>        vuRenderer = std::make_shared<VuRenderer>(info);
+    Vu::VuRendererCreateInfo info {};
+    info.singlePassDeferred                = singlePassDeferred;
+    info.depthPrepassMode                  = VuDepthPrepassMode::Auto;
+    std::shared_ptr<VuRenderer> vuRenderer = std::make_shared<VuRenderer>(info);
 
     // create a mesh asset
     VuMesh mesh {};
@@ -48,7 +59,10 @@ public:
 
     // deffered lpas shder
     std::shared_ptr<VuShader> lPassShader = std::make_shared<VuShader>(move_or_THROW(
-        VuShader::make(vuRenderer, vuRenderer->m_deferredRenderSpace.m_lightningPass, defVertPath, defFragPath)));
+        VuShader::make(vuRenderer,
+                       vuRenderer->m_deferredRenderSpace.m_lightningPass,
+                       defVertPath,
+                       singlePassDeferred ? defSubpassFragPath : defFragPath)));
 
     MaterialSettings defaultMaterialSettings {};
 
@@ -90,19 +104,33 @@ public:
     auto camTrs = Transform(float3(0.0f, 0.0f, 3.5f), quaternion::identity(), float3(1, 1, 1));
     auto cam    = Camera {};
 
-    auto& pl0 = vuRenderer->m_frameConstant.pointLights[0];
-    auto& pl1 = vuRenderer->m_frameConstant.pointLights[1];
-
-    pl0.position = float3(5.0f, 10.0f, 0.0f);
-    pl1.position = float3(-5.0f, 10.0f, 0.0f);
-    pl0.range    = 100;
-    pl1.range    = 100;
-
-    pl0.color = float3(1.0f, 0.0f, 0.0f);
-    pl1.color = float3(1.0f, 1.0f, 1.0f);
+    vuRenderer->m_pointLights = {
+        {.color = float3(1.0f, 0.0f, 0.0f), .intensity = 1000.0f, .position = float3(5.0f, 10.0f, 0.0f), .range = 100},
+        {.color = float3(1.0f, 1.0f, 1.0f), .intensity = 1000.0f, .position = float3(-5.0f, 10.0f, 0.0f), .range = 100},
+    };
+
+    // a grid of copies culled and drawn by the gpu, the cpu records one indirect draw for all of them. without
+    // indirect count draws they go through the render queue like any other mesh
+    std::vector<Transform> gridTransforms {};
+    for (int x = -8; x < 8; ++x) {
+      for (int z = -8; z < 8; ++z) {
+        gridTransforms.push_back(Transform {.m_position = float3(x * 4.0f, -4.0f, z * 4.0f - 40.0f),
+                                            .rotation   = quaternion::identity(),
+                                            .scale      = float3(10.0F, 10.0F, 10.0F)});
+      }
+    }
+    std::optional<VuGpuScene> gpuScene {};
+    if (vuRenderer->m_vuPhysicalDevice->m_supportsIndirectDraw) {
+      gpuScene.emplace(move_or_THROW(VuGpuScene::make(vuRenderer, VuGpuSceneCreateInfo {})));
+      for (Transform& gridTrs : gridTransforms) {
+        gpuScene->addObject(basicMaterial, mesh, gridTrs.ToTRS());
+      }
+      vuRenderer->m_gpuScene = &gpuScene.value();
+    }
 
-    pl0.intensity = 1000.0f;
-    pl1.intensity = 1000.0f;
+    // materials queued their pipelines while the textures were loading
+    basicShader->waitForPendingPipelines();
+    lPassShader->waitForPendingPipelines();
 
     // Update Loop
     while (!vuRenderer->shouldWindowClose()) {
@@ -121,13 +149,19 @@ public:
 
         // user render commands begin
         drawMesh(*vuRenderer, obj0Trs, obj1MeshRenderer);
+        if (!gpuScene) {
+          for (Transform& gridTrs : gridTransforms) {
+            drawMesh(*vuRenderer, gridTrs, obj1MeshRenderer);
+          }
+        }
         // user render commands end
 
         vuRenderer->beginLightningPass();
-        vuRenderer->bindMaterial(lPassMaterial);
-        GPU::VuMaterialDataHandle dataIndex = *lPassMaterial->m_materialDataHnd;
-        vuRenderer->pushConstants({float4x4(), dataIndex});
-        vkCmdDraw(vuRenderer->m_commandBuffers[vuRenderer->m_currentFrame], 3, 1, 0, 0);
+        if (vuRenderer->bindMaterial(lPassMaterial)) {
+          GPU::VuMaterialDataHandle dataIndex = *lPassMaterial->m_materialDataHnd;
+          vuRenderer->pushConstants({float4x4(), dataIndex});
+          vkCmdDraw(vuRenderer->m_commandBuffers[vuRenderer->m_currentFrame], 3, 1, 0, 0);
+        }
 
         // UI
         {
@@ -140,11 +174,17 @@ public:
           auto wRes = ImGui::Begin("Info");
 
           drawCameraUI(vuRenderer->m_frameConstant.camera, camTrs);
+          ImGui::Checkbox("Clustered lighting", &vuRenderer->m_clusteredLighting);
           uint32_t index = 0;
-          for (GPU::PointLight& pointLight : vuRenderer->m_frameConstant.pointLights) {
+          for (GPU::PointLight& pointLight : vuRenderer->m_pointLights) {
             drawPointLightUi(pointLight, index);
             index++;
           }
+          drawGpuMemoryUI(*vuRenderer);
+          drawRenderQueueUI(*vuRenderer);
+          drawFramePacingUI(*vuRenderer);
+          drawDepthPrepassUI(*vuRenderer);
+          drawGpuProfilerUI(*vuRenderer);
           // ImGui::Text("Image Count: %u", vuRenderer.imagePool.getUsedSlotCount());
           // ImGui::Text("Sampler Count: %u", vuRenderer.vuDevice.samplerPool.getUsedSlotCount());
           // ImGui::Text("Buffer Count: %u", vuRenderer.vuDevice.bufferPool.getUsedSlotCount());
@@ -178,6 +218,7 @@ public:
     VkResult waitRes = vkDeviceWaitIdle(vuRenderer->m_vuDevice->m_device);
 
     THROW_if_fail(waitRes);
+    vuRenderer->m_gpuScene = nullptr;
   }
 };
 } // namespace Vu
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "01_InnerCore/VuLogger.h"
+#include "02_OuterCore/Common.h"
+#include "04_Crust/VuAssetLoader.h"
+#include "04_Crust/VuMaterial.h"
+#include "04_Crust/VuMesh.h"
+#include "04_Crust/VuRenderer.h"
+#include "04_Crust/VuShader.h"
+#include "11_Components/Camera.h"
+#include "11_Components/Components.h"
+#include "11_Components/Transform.h"
+#include "12_Systems/Systems.h"
+
+namespace Vu {
+
+// Measures the frame time of the lighting pass with many small point lights in front of a wall, once with the
+// clustered light lists and once looping over every light per pixel. Results are logged and the scene exits.
+struct Scene_LightBenchmark {
+private:
+  path cubePath = "assets/gltf/Cube.glb";
+
+  path pbrVertPath = "assets/shaders/object/deferred/pbr_deferred_vert.slang";
+  path pbrFragPath = "assets/shaders/object/deferred/pbr_deferred_frag.slang";
+
+  path defVertPath = "assets/shaders/engine/screen_space_triangle_vert.slang";
+  path defFragPath = "assets/shaders/engine/deferred_render_space/deferred_lightning_pass_frag.slang";
+
+  static constexpr std::array<u32, 2> LIGHT_COUNTS   = {1'000u, 10'000u};
+  static constexpr u32                WARMUP_FRAMES  = 32u;
+  static constexpr u32                MEASURE_FRAMES = 256u;
+
+public:
+  void
+  run() const {
+    constexpr Vu::VuRendererCreateInfo info {};
+    std::shared_ptr<VuRenderer>        vuRenderer = std::make_shared<VuRenderer>(info);
+
+    VuMesh mesh {};
+    VuAssetLoader::loadGLTF(*vuRenderer, cubePath, mesh);
+
+    std::shared_ptr<VuShader> basicShader = std::make_shared<VuShader>(move_or_THROW(
+        VuShader::make(vuRenderer, vuRenderer->m_deferredRenderSpace.m_gBufferPass, pbrVertPath, pbrFragPath)));
+    std::shared_ptr<VuShader> lPassShader = std::make_shared<VuShader>(move_or_THROW(
+        VuShader::make(vuRenderer, vuRenderer->m_deferredRenderSpace.m_lightningPass, defVertPath, defFragPath)));
+
+    std::shared_ptr<GPU::VuMaterialDataHandle> matDataHnd = vuRenderer->createMaterialDataIndex();
+    std::shared_ptr<VuMaterial> material = std::make_shared<VuMaterial>(MaterialSettings {}, basicShader, matDataHnd);
+
+    auto* matData                = vuRenderer->getMaterialDataPointerAs<GPU::MatData_PbrDeferred>(*matDataHnd);
+    matData->colorTexture        = vuRenderer->m_defaultImage->m_bindlessIndex.value_or_THROW();
+    matData->normalTexture       = vuRenderer->m_defaultNormalImage->m_bindlessIndex.value_or_THROW();
+    matData->aoRoughMetalTexture = vuRenderer->m_defaultImage->m_bindlessIndex.value_or_THROW();
+
+    std::shared_ptr<GPU::VuMaterialDataHandle> lPassMatDataHnd = vuRenderer->createMaterialDataIndex();
+    std::shared_ptr<VuMaterial>                lPassMaterial =
+        std::make_shared<VuMaterial>(MaterialSettings {}, lPassShader, lPassMatDataHnd);
+    *vuRenderer->getMaterialDataPointerAs<GPU::MatData_PbrDeferred>(*lPassMatDataHnd) =
+        vuRenderer->m_deferredRenderSpace.m_lightningPassMaterialData;
+
+    basicShader->waitForPendingPipelines();
+    lPassShader->waitForPendingPipelines();
+
+    auto camTrs  = Transform(float3(0.0f, 0.0f, 3.5f), quaternion::identity(), float3(1, 1, 1));
+    auto cam     = Camera {};
+    auto wallTrs = Transform {.m_position = float3(0.0f, 0.0f, -30.0f),
+                              .rotation   = quaternion::identity(),
+                              .scale      = float3(50.0f, 30.0f, 0.1f)};
+
+    for (const u32 lightCount : LIGHT_COUNTS) {
+      // small lights just in front of the wall, the same layout for every run
+      std::mt19937                          random {lightCount};
+      std::uniform_real_distribution<float> unit {0.0f, 1.0f};
+      vuRenderer->m_pointLights.clear();
+      for (u32 i = 0; i < lightCount; ++i) {
+        vuRenderer->m_pointLights.push_back(
+            {.color     = float3(unit(random), unit(random), unit(random)),
+             .intensity = 2.0f,
+             .position  = float3((unit(random) - 0.5f) * 60.0f, (unit(random) - 0.5f) * 36.0f, -29.0f + unit(random)),
+             .range     = 3.0f});
+      }
+
+      for (const bool clustered : {true, false}) {
+        vuRenderer->m_clusteredLighting = clustered;
+
+        double frameMilliseconds {};
+        for (u32 frame = 0; frame < WARMUP_FRAMES + MEASURE_FRAMES; ++frame) {
+          if (vuRenderer->shouldWindowClose()) { break; }
+          vuRenderer->preUpdate();
+          vuRenderer->pollUserInput();
+          cameraFlySystem(*vuRenderer, camTrs, cam);
+
+          // gpu bound once the frames in flight are used up, beginFrame waits for the oldest one
+          const auto startTime = std::chrono::steady_clock::now();
+          vuRenderer->beginFrame();
+          vuRenderer->queueDraw(material, mesh, wallTrs.ToTRS(), wallTrs.m_position);
+          vuRenderer->beginLightningPass();
+          if (vuRenderer->bindMaterial(lPassMaterial)) {
+            vuRenderer->pushConstants({float4x4(), *lPassMaterial->m_materialDataHnd});
+            vkCmdDraw(vuRenderer->m_commandBuffers[vuRenderer->m_currentFrame], 3, 1, 0, 0);
+          }
+          vuRenderer->endFrame();
+          const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+
+          if (frame >= WARMUP_FRAMES) { frameMilliseconds += elapsed.count(); }
+        }
+        Logger::Info("Light benchmark {} lights, {}: frame {:.3f} ms",
+                     lightCount,
+                     clustered ? "clustered" : "all lights per pixel",
+                     frameMilliseconds / MEASURE_FRAMES);
+      }
+    }
+
+    THROW_if_fail(vkDeviceWaitIdle(vuRenderer->m_vuDevice->m_device));
+  }
+};
+} // namespace Vu
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "01_InnerCore/FrameLimiter.h"
+
+TEST(FrameLimiterTest, DisabledNeverWaits)
+{
+    FrameLimiter limiter {};
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(limiter.wait(), 0.0f);
+    }
+    limiter.setTargetFps(-5.0f);
+    EXPECT_EQ(limiter.getTargetFps(), 0.0f);
+    EXPECT_EQ(limiter.wait(), 0.0f);
+}
+
+TEST(FrameLimiterTest, HoldsTheTargetInterval)
+{
+    FrameLimiter limiter {};
+    limiter.setTargetFps(200.0f);
+    // the first call only sets the first deadline
+    limiter.wait();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+        limiter.wait();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(45));
+}
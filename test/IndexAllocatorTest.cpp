@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include "01_InnerCore/IndexAllocator.h"
+
+TEST(IndexAllocatorTest, ReusesFreedIndices)
+{
+    IndexAllocator allocator(4);
+    EXPECT_EQ(allocator.allocate(), 0u);
+    EXPECT_EQ(allocator.allocate(), 1u);
+    EXPECT_EQ(allocator.allocate(), 2u);
+    allocator.deallocate(1);
+    EXPECT_EQ(allocator.allocate(), 1u);
+}
+
+TEST(IndexAllocatorTest, GrowKeepsIndicesAndRaisesCapacity)
+{
+    IndexAllocator allocator(2);
+    EXPECT_EQ(allocator.allocate(), 0u);
+    EXPECT_EQ(allocator.allocate(), 1u);
+    EXPECT_TRUE(allocator.isFull());
+    EXPECT_THROW(allocator.allocate(), std::runtime_error);
+
+    allocator.grow(4);
+    EXPECT_EQ(allocator.capacity(), 4u);
+    EXPECT_FALSE(allocator.isFull());
+    EXPECT_EQ(allocator.allocate(), 2u);
+    EXPECT_EQ(allocator.allocate(), 3u);
+    EXPECT_TRUE(allocator.isFull());
+    EXPECT_THROW(allocator.grow(3), std::runtime_error);
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include "01_InnerCore/MemoryAliasPlanner.h"
+
+TEST(MemoryAliasPlannerTest, DisjointLifetimesShareOneBlock)
+{
+    std::vector<AliasResource> resources = {
+        {.size = 100, .firstPass = 0, .lastPass = 1},
+        {.size = 300, .firstPass = 2, .lastPass = 3},
+        {.size = 200, .firstPass = 4, .lastPass = 4},
+    };
+    AliasPlan plan = planMemoryAliasing(resources);
+    ASSERT_EQ(plan.blocks.size(), 1u);
+    EXPECT_EQ(plan.blocks[0].size, 300u);
+    EXPECT_EQ(plan.unaliasedBytes, 600u);
+    EXPECT_EQ(plan.aliasedBytes, 300u);
+}
+
+TEST(MemoryAliasPlannerTest, OverlappingLifetimesGetSeparateBlocks)
+{
+    std::vector<AliasResource> resources = {
+        {.size = 100, .firstPass = 0, .lastPass = 1},
+        {.size = 100, .firstPass = 1, .lastPass = 2},
+        {.size = 50, .firstPass = 2, .lastPass = 2},
+    };
+    AliasPlan plan = planMemoryAliasing(resources);
+    ASSERT_EQ(plan.blocks.size(), 2u);
+    EXPECT_NE(plan.blockOfResource[0], plan.blockOfResource[1]);
+    // the last one only collides with the second
+    EXPECT_EQ(plan.blockOfResource[2], plan.blockOfResource[0]);
+    EXPECT_EQ(plan.aliasedBytes, 200u);
+}
+
+TEST(MemoryAliasPlannerTest, IncompatibleMemoryTypesAreNotAliased)
+{
+    std::vector<AliasResource> resources = {
+        {.size = 100, .memoryTypeBits = 0b01, .firstPass = 0, .lastPass = 0},
+        {.size = 100, .memoryTypeBits = 0b10, .firstPass = 1, .lastPass = 1},
+    };
+    AliasPlan plan = planMemoryAliasing(resources);
+    EXPECT_EQ(plan.blocks.size(), 2u);
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include "01_InnerCore/RadixSort.h"
+#include "01_InnerCore/ThreadPool.h"
+
+static std::vector<RadixSortItem>
+makeItems(size_t count, uint64_t keyMask) {
+    std::mt19937_64            rng {1234};
+    std::vector<RadixSortItem> items(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        items[i] = {rng() & keyMask, i};
+    }
+    return items;
+}
+
+static void
+expectMatchesStableSort(std::vector<RadixSortItem> items, ThreadPool* pool) {
+    std::vector<RadixSortItem> expected = items;
+    std::ranges::stable_sort(expected, {}, &RadixSortItem::key);
+
+    std::vector<RadixSortItem> scratch(items.size());
+    radixSort(items, scratch, pool);
+
+    ASSERT_EQ(items.size(), expected.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        EXPECT_EQ(items[i].key, expected[i].key);
+        EXPECT_EQ(items[i].value, expected[i].value);
+    }
+}
+
+TEST(RadixSortTest, MatchesStableSortSingleThreaded)
+{
+    expectMatchesStableSort(makeItems(1000, ~0ull), nullptr);
+    // few distinct keys, stability matters
+    expectMatchesStableSort(makeItems(1000, 0xF000000000000F0Full), nullptr);
+}
+
+TEST(RadixSortTest, MatchesStableSortWithPool)
+{
+    ThreadPool pool(3);
+    expectMatchesStableSort(makeItems(100000, ~0ull), &pool);
+    expectMatchesStableSort(makeItems(100000, 0xFFull), &pool);
+}
+
+TEST(RadixSortTest, HandlesTinyInputs)
+{
+    std::vector<RadixSortItem> items {};
+    std::vector<RadixSortItem> scratch {};
+    radixSort(items, scratch);
+    expectMatchesStableSort(makeItems(1, ~0ull), nullptr);
+    expectMatchesStableSort(makeItems(2, ~0ull), nullptr);
+}
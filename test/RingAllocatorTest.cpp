@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "01_InnerCore/RingAllocator.h"
+
+TEST(RingAllocatorTest, AllocatesSequentiallyWithAlignment)
+{
+    RingAllocator ring(1024);
+    auto a = ring.allocate(10, 16);
+    auto b = ring.allocate(10, 16);
+    ASSERT_TRUE(a.has_value());
+    ASSERT_TRUE(b.has_value());
+    EXPECT_EQ(a->offset, 0u);
+    EXPECT_EQ(b->offset, 16u);
+    EXPECT_EQ(b->consumed, 6u + 10u);
+    EXPECT_EQ(ring.getUsed(), 26u);
+}
+
+TEST(RingAllocatorTest, FailsWhenFull)
+{
+    RingAllocator ring(256);
+    EXPECT_TRUE(ring.allocate(200, 1).has_value());
+    EXPECT_FALSE(ring.allocate(100, 1).has_value());
+    EXPECT_FALSE(ring.allocate(512, 1).has_value());
+}
+
+TEST(RingAllocatorTest, WrapsAroundAfterRelease)
+{
+    RingAllocator ring(256);
+    auto a = ring.allocate(100, 1);
+    auto b = ring.allocate(100, 1);
+    ASSERT_TRUE(a.has_value());
+    ASSERT_TRUE(b.has_value());
+
+    ring.release(a->consumed);
+
+    // 56 bytes left at the end, so this must wrap to the beginning
+    auto c = ring.allocate(80, 1);
+    ASSERT_TRUE(c.has_value());
+    EXPECT_EQ(c->offset, 0u);
+    EXPECT_EQ(c->consumed, 56u + 80u);
+
+    ring.release(b->consumed);
+    ring.release(c->consumed);
+    EXPECT_EQ(ring.getUsed(), 0u);
+
+    auto d = ring.allocate(256, 1);
+    ASSERT_TRUE(d.has_value());
+    EXPECT_EQ(d->offset, 0u);
+}
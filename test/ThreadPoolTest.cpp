@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+
+#include "01_InnerCore/ThreadPool.h"
+
+TEST(ThreadPoolTest, ReturnsResultsThroughFutures)
+{
+    ThreadPool pool(4);
+    std::vector<std::future<int>> results {};
+    for (int i = 0; i < 64; ++i) {
+        results.push_back(pool.submit([i] { return i * i; }));
+    }
+    for (int i = 0; i < 64; ++i) {
+        EXPECT_EQ(results[i].get(), i * i);
+    }
+}
+
+TEST(ThreadPoolTest, DestructorRunsQueuedJobs)
+{
+    std::atomic<int> counter {0};
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&counter] { counter++; });
+        }
+    }
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST(ThreadPoolTest, ForwardsExceptionsToFuture)
+{
+    ThreadPool pool(1);
+    auto       future = pool.submit([]() -> int { throw std::runtime_error("job failed"); });
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ForEachChunkRunsEveryChunkOnce)
+{
+    ThreadPool                    pool(3);
+    std::vector<std::atomic<int>> visits(17);
+    forEachChunk(&pool, visits.size(), [&visits](size_t chunk) { visits[chunk]++; });
+    forEachChunk(nullptr, visits.size(), [&visits](size_t chunk) { visits[chunk]++; });
+    for (const std::atomic<int>& visit : visits) {
+        EXPECT_EQ(visit.load(), 2);
+    }
+}
+
+TEST(ThreadPoolTest, ForEachChunkWaitsForEveryChunkBeforeRethrowing)
+{
+    ThreadPool       pool(3);
+    std::atomic<int> finished {0};
+    auto             job = [&finished](size_t chunk) {
+        if (chunk == 0) { throw std::runtime_error("chunk failed"); }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        finished++;
+    };
+    EXPECT_THROW(forEachChunk(&pool, 8, job), std::runtime_error);
+    EXPECT_EQ(finished.load(), 7);
+}
+
+TEST(ThreadPoolTest, ForEachChunkDoesNotWaitBehindBusyWorkers)
+{
+    ThreadPool         pool(1);
+    std::promise<void> release {};
+    auto               blocker = pool.submit([future = release.get_future()] { future.wait(); });
+
+    std::vector<std::atomic<int>> visits(8);
+    forEachChunk(&pool, visits.size(), [&visits](size_t chunk) { visits[chunk]++; });
+    for (const std::atomic<int>& visit : visits) {
+        EXPECT_EQ(visit.load(), 1);
+    }
+    release.set_value();
+    blocker.get();
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "04_Crust/VuDepthPrepass.h"
+
+using namespace Vu;
+
+static VuDepthPrepassDecision
+decideAuto(const VuDepthPrepassDecision& previous, const std::optional<VuOverdrawSample>& sample, u32 probeInterval)
+{
+    return decideDepthPrepass(
+        previous, sample, VuDepthPrepassMode::Auto, true, VuDepthPrepassCreateInfo {.probeInterval = probeInterval});
+}
+
+TEST(VuDepthPrepassTest, OverdrawIsSamplesPerCoveredPixelSmoothed)
+{
+    VuDepthPrepassDecision decision = decideAuto({}, VuOverdrawSample {.passedSamples = 300, .pixelCount = 100}, 1000);
+    EXPECT_FLOAT_EQ(decision.overdraw, 3.0f);
+
+    decision = decideAuto(decision, VuOverdrawSample {.passedSamples = 100, .pixelCount = 100}, 1000);
+    EXPECT_FLOAT_EQ(decision.overdraw, 2.5f);
+
+    // nothing covered, nothing overdrawn
+    decision = decideAuto({}, VuOverdrawSample {.passedSamples = 0, .pixelCount = 0}, 1000);
+    EXPECT_TRUE(decision.hasMeasurement);
+    EXPECT_FLOAT_EQ(decision.overdraw, 0.0f);
+}
+
+TEST(VuDepthPrepassTest, AutoModeHasHysteresis)
+{
+    // defaults turn on at 1.5 and off below 1.2
+    VuDepthPrepassDecision decision = decideAuto({}, VuOverdrawSample {.passedSamples = 200, .pixelCount = 100}, 1000);
+    EXPECT_TRUE(decision.active);
+
+    // between the thresholds the prepass stays on
+    for (int i = 0; i < 50; ++i) {
+        decision = decideAuto(decision, VuOverdrawSample {.passedSamples = 130, .pixelCount = 100}, 1000);
+        EXPECT_TRUE(decision.active);
+    }
+    for (int i = 0; i < 50; ++i) {
+        decision = decideAuto(decision, VuOverdrawSample {.passedSamples = 100, .pixelCount = 100}, 1000);
+    }
+    EXPECT_FALSE(decision.active);
+
+    // and off until the upper one is reached again
+    for (int i = 0; i < 50; ++i) {
+        decision = decideAuto(decision, VuOverdrawSample {.passedSamples = 140, .pixelCount = 100}, 1000);
+        EXPECT_FALSE(decision.active);
+    }
+}
+
+TEST(VuDepthPrepassTest, AutoModeProbesOnTheInterval)
+{
+    // low overdraw keeps the prepass off between probes
+    VuDepthPrepassDecision decision {.framesSinceActive = 4};
+    decision = decideAuto(decision, VuOverdrawSample {.passedSamples = 100, .pixelCount = 100}, 4);
+    EXPECT_TRUE(decision.active);
+
+    for (int probe = 0; probe < 3; ++probe) {
+        for (int i = 0; i < 3; ++i) {
+            decision = decideAuto(decision, std::nullopt, 4);
+            EXPECT_FALSE(decision.active);
+        }
+        decision = decideAuto(decision, std::nullopt, 4);
+        EXPECT_TRUE(decision.active);
+    }
+}
+
+TEST(VuDepthPrepassTest, FixedModesIgnoreTheOverdraw)
+{
+    const VuOverdrawSample high {.passedSamples = 400, .pixelCount = 100};
+    const VuOverdrawSample low {.passedSamples = 100, .pixelCount = 100};
+
+    EXPECT_FALSE(decideDepthPrepass({}, high, VuDepthPrepassMode::Off, true, {}).active);
+    EXPECT_TRUE(decideDepthPrepass({}, low, VuDepthPrepassMode::On, true, {}).active);
+    // without precise queries auto mode never turns it on, probes included
+    EXPECT_FALSE(decideDepthPrepass({.framesSinceActive = 1000}, high, VuDepthPrepassMode::Auto, false, {}).active);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "02_OuterCore/VuFileWatcher.h"
+
+using namespace Vu;
+
+static bool
+waitForChange(VuFileWatcher& watcher, VuFileWatcher::SubscriptionId id) {
+    for (int i = 0; i < 200; ++i) {
+        if (watcher.consumeChange(id)) { return true; }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+TEST(VuFileWatcherTest, NotifiesOnlySubscribersOfChangedFile)
+{
+    const auto dir = std::filesystem::temp_directory_path() / "VuFileWatcherTest";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "common.slang") << "a";
+    std::ofstream(dir / "vert.slang") << "a";
+    std::ofstream(dir / "frag.slang") << "a";
+
+    VuFileWatcher watcher(std::chrono::milliseconds(10));
+
+    const std::vector<std::filesystem::path> vertFiles {dir / "vert.slang", dir / "common.slang"};
+    const std::vector<std::filesystem::path> fragFiles {dir / "frag.slang", dir / "common.slang"};
+    const auto                               vertId = watcher.subscribe(vertFiles);
+    const auto                               fragId = watcher.subscribe(fragFiles);
+    EXPECT_FALSE(watcher.consumeChange(vertId));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::ofstream(dir / "vert.slang") << "b";
+    EXPECT_TRUE(waitForChange(watcher, vertId));
+    EXPECT_FALSE(watcher.consumeChange(fragId));
+
+    std::ofstream(dir / "common.slang") << "b";
+    EXPECT_TRUE(waitForChange(watcher, vertId));
+    EXPECT_TRUE(waitForChange(watcher, fragId));
+    EXPECT_FALSE(watcher.consumeChange(vertId));
+
+    watcher.unsubscribe(vertId);
+    std::filesystem::remove_all(dir);
+}
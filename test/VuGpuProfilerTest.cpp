@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "03_Mantle/VuDevice.h"
+#include "03_Mantle/VuGpuProfiler.h"
+#include "03_Mantle/VuInstance.h"
+#include "03_Mantle/VuPhysicalDevice.h"
+#include "03_Mantle/VuTimeline.h"
+
+using namespace Vu;
+
+TEST(VuGpuProfilerTest, StatsCoverTheWindowOnly)
+{
+    VuGpuTimings timings {3};
+    for (float ms : {1.0f, 2.0f, 3.0f, 4.0f}) {
+        timings.addSample("GBuffer", ms);
+    }
+
+    const std::vector<VuGpuScopeStats> stats = timings.getStats();
+    ASSERT_EQ(stats.size(), 1u);
+    EXPECT_EQ(stats[0].name, "GBuffer");
+    EXPECT_EQ(stats[0].sampleCount, 3u);
+    EXPECT_FLOAT_EQ(stats[0].lastMs, 4.0f);
+    EXPECT_FLOAT_EQ(stats[0].avgMs, 3.0f);
+    EXPECT_FLOAT_EQ(stats[0].minMs, 2.0f);
+    EXPECT_FLOAT_EQ(stats[0].maxMs, 4.0f);
+}
+
+TEST(VuGpuProfilerTest, CsvKeepsFirstSeenOrder)
+{
+    VuGpuTimings timings {};
+    timings.addSample("Lighting", 0.5f);
+    timings.addSample("GBuffer", 1.0f);
+    timings.addSample("Lighting", 1.5f);
+
+    EXPECT_EQ(timings.toCsv(),
+              "scope,last_ms,avg_ms,min_ms,max_ms,samples\n"
+              "\"Lighting\",1.5000,1.0000,0.5000,1.5000,2\n"
+              "\"GBuffer\",1.0000,1.0000,1.0000,1.0000,1\n");
+
+    timings.clear();
+    EXPECT_TRUE(timings.getStats().empty());
+}
+
+TEST(VuGpuProfilerTest, TimestampDeltaHandlesWrap)
+{
+    // period of one nanosecond per tick
+    EXPECT_FLOAT_EQ(timestampDeltaMs(1'000'000, 3'000'000, 64, 1.0f), 2.0f);
+    // 8 valid bits, the counter wrapped from 250 to 4
+    EXPECT_FLOAT_EQ(timestampDeltaMs(250, 4, 8, 1'000'000.0f), 10.0f);
+    EXPECT_FLOAT_EQ(timestampDeltaMs(5, 9, 0, 1.0f), 0.0f);
+}
+
+// a device without surface or swapchain, lavapipe in CI. null when the machine has no Vulkan driver
+static std::shared_ptr<VuDevice>
+makeHeadlessDevice()
+{
+    auto instanceOrErr = VuInstance::make(false, {}, {});
+    if (!instanceOrErr.has_value()) { return nullptr; }
+    auto vuInstance = std::make_shared<VuInstance>(std::move(instanceOrErr.value()));
+
+    u32 deviceCount = 0;
+    vkEnumeratePhysicalDevices(vuInstance->m_instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(vuInstance->m_instance, &deviceCount, devices.data());
+    if (devices.empty()) { return nullptr; }
+
+    // the software driver when there is one, results do not depend on what else is installed
+    auto vuPhysicalDevice              = std::make_shared<VuPhysicalDevice>();
+    vuPhysicalDevice->m_vuInstance     = vuInstance;
+    vuPhysicalDevice->m_physicalDevice = devices.front();
+    for (VkPhysicalDevice device : devices) {
+        VkPhysicalDeviceProperties properties {};
+        vkGetPhysicalDeviceProperties(device, &properties);
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) { vuPhysicalDevice->m_physicalDevice = device; }
+    }
+    const VkPhysicalDevice physicalDevice = vuPhysicalDevice->m_physicalDevice;
+    vkGetPhysicalDeviceProperties(physicalDevice, &vuPhysicalDevice->m_properties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &vuPhysicalDevice->m_memoryProperties);
+    vkGetPhysicalDeviceFeatures(physicalDevice, &vuPhysicalDevice->m_features);
+
+    u32 familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    u32 graphicsFamily = 0;
+    while (graphicsFamily < familyCount && !(families[graphicsFamily].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+        graphicsFamily++;
+    }
+    if (graphicsFamily == familyCount) { return nullptr; }
+    VuQueueFamilyIndices& indices = vuPhysicalDevice->m_indices;
+    indices.graphicsFamily        = graphicsFamily;
+    indices.presentFamily         = graphicsFamily;
+    indices.transferFamily        = graphicsFamily;
+    indices.computeFamily         = graphicsFamily;
+
+    // VuTimeline is all the profiler needs from the device
+    VkPhysicalDeviceVulkan12Features vk12Features {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    vk12Features.timelineSemaphore = VK_TRUE;
+    VkPhysicalDeviceFeatures2 features2 {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+    features2.pNext = &vk12Features;
+
+    auto deviceOrErr = VuDevice::make(vuPhysicalDevice, features2, {});
+    if (!deviceOrErr.has_value()) { return nullptr; }
+    return std::make_shared<VuDevice>(std::move(deviceOrErr.value()));
+}
+
+// CI sets VU_REQUIRE_DEVICE so a missing driver fails there instead of skipping silently
+static bool
+deviceRequired()
+{
+    const char* value = std::getenv("VU_REQUIRE_DEVICE");
+    return value != nullptr && std::string_view {value} != "0";
+}
+
+TEST(VuGpuProfilerDeviceTest, ReadsBackScopesOfASubmittedFrame)
+{
+    std::shared_ptr<VuDevice> vuDevice = makeHeadlessDevice();
+    if (vuDevice == nullptr) {
+        if (deviceRequired()) { GTEST_FAIL() << "no Vulkan device"; }
+        GTEST_SKIP() << "no Vulkan device";
+    }
+
+    VuGpuProfiler profiler = move_or_THROW(VuGpuProfiler::make(vuDevice, VuGpuProfilerCreateInfo {}));
+    if (!profiler.isSupported()) {
+        if (deviceRequired()) { GTEST_FAIL() << "no timestamps on the graphics queue"; }
+        GTEST_SKIP() << "no timestamps on the graphics queue";
+    }
+
+    VkCommandPoolCreateInfo poolInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.queueFamilyIndex = vuDevice->m_vuPhysicalDevice->m_indices.graphicsFamily;
+    VkCommandPool commandPool {nullptr};
+    THROW_if_fail(vkCreateCommandPool(vuDevice->m_device, &poolInfo, NO_ALLOC_CALLBACK, &commandPool));
+
+    VkCommandBufferAllocateInfo allocInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocInfo.commandPool        = commandPool;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 2;
+    std::array<VkCommandBuffer, 2> commandBuffers {};
+    THROW_if_fail(vkAllocateCommandBuffers(vuDevice->m_device, &allocInfo, commandBuffers.data()));
+
+    VkCommandBufferBeginInfo beginInfo {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    THROW_if_fail(vkBeginCommandBuffer(commandBuffers[0], &beginInfo));
+    profiler.beginFrame(commandBuffers[0], 0);
+    profiler.beginScope(commandBuffers[0], "Outer");
+    profiler.beginScope(commandBuffers[0], "Inner");
+    profiler.endScope(commandBuffers[0], "Inner");
+    profiler.endScope(commandBuffers[0], "Outer");
+    THROW_if_fail(vkEndCommandBuffer(commandBuffers[0]));
+
+    VuTimeline&                   timeline = *vuDevice->m_timeline;
+    const u64                     value    = timeline.nextValue();
+    VkTimelineSemaphoreSubmitInfo timelineInfo {.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues    = &value;
+    VkSubmitInfo submitInfo {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .pNext = &timelineInfo};
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.pCommandBuffers      = &commandBuffers[0];
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &timeline.m_semaphore;
+    THROW_if_fail(vkQueueSubmit(vuDevice->m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+    profiler.endFrame(value);
+    timeline.waitFor(value);
+
+    // the next frame reads the completed one back
+    THROW_if_fail(vkBeginCommandBuffer(commandBuffers[1], &beginInfo));
+    profiler.beginFrame(commandBuffers[1], 1);
+    THROW_if_fail(vkEndCommandBuffer(commandBuffers[1]));
+
+    const std::vector<VuGpuScopeStats> stats = profiler.m_timings.getStats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].name, "Outer");
+    EXPECT_EQ(stats[1].name, "Inner");
+    for (const VuGpuScopeStats& scope : stats) {
+        EXPECT_EQ(scope.sampleCount, 1u);
+        EXPECT_GE(scope.lastMs, 0.0f);
+    }
+    EXPECT_GE(stats[0].lastMs, stats[1].lastMs);
+
+    vkDestroyCommandPool(vuDevice->m_device, commandPool, NO_ALLOC_CALLBACK);
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include "03_Mantle/VuMemoryTracker.h"
+
+using namespace Vu;
+
+static VkDeviceMemory
+fakeHandle(uintptr_t value) {
+    return reinterpret_cast<VkDeviceMemory>(value);
+}
+
+TEST(VuMemoryTrackerTest, TracksCategoryTotalsAndPeak)
+{
+    VuMemoryTracker tracker {};
+    tracker.onAllocate(fakeHandle(1), {.tag = {"A", VuMemoryCategory::Texture}, .sizeInBytes = 100});
+    tracker.onAllocate(fakeHandle(2), {.tag = {"B", VuMemoryCategory::Texture}, .sizeInBytes = 50});
+    tracker.onAllocate(fakeHandle(3), {.tag = {"C", VuMemoryCategory::Geometry}, .sizeInBytes = 30});
+    tracker.onFree(fakeHandle(1));
+
+    VuMemoryStats stats = tracker.getStats();
+    const VuMemoryCategoryStats& texture = stats.categories[static_cast<u32>(VuMemoryCategory::Texture)];
+    EXPECT_EQ(texture.currentBytes, 50u);
+    EXPECT_EQ(texture.peakBytes, 150u);
+    EXPECT_EQ(texture.liveAllocationCount, 1u);
+    EXPECT_EQ(stats.totalBytes, 80u);
+    EXPECT_EQ(stats.peakTotalBytes, 180u);
+    EXPECT_EQ(stats.liveAllocationCount, 2u);
+    EXPECT_EQ(stats.allocateCallCount, 3u);
+
+    // unknown handles are ignored
+    tracker.onFree(fakeHandle(42));
+    EXPECT_EQ(tracker.getStats().totalBytes, 80u);
+
+    std::vector<VuMemoryRecord> records = tracker.getRecords();
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_STREQ(records[0].tag.name.c_str(), "B");
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "03_Mantle/VuPipelineCache.h"
+
+using namespace Vu;
+
+static VkPhysicalDeviceProperties
+fakeProperties() {
+    VkPhysicalDeviceProperties properties {};
+    properties.vendorID      = 0x10de;
+    properties.deviceID      = 0x2684;
+    properties.driverVersion = 0x8a4c4000;
+    for (uint8_t i = 0; i < VK_UUID_SIZE; ++i) {
+        properties.pipelineCacheUUID[i] = i;
+    }
+    return properties;
+}
+
+static std::vector<std::byte>
+makeBlob(const VkPhysicalDeviceProperties& properties, size_t payloadSize) {
+    VkPipelineCacheHeaderVersionOne header {};
+    header.headerSize    = sizeof(header);
+    header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+    header.vendorID      = properties.vendorID;
+    header.deviceID      = properties.deviceID;
+    std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<std::byte> blob(sizeof(header) + payloadSize);
+    std::memcpy(blob.data(), &header, sizeof(header));
+    return blob;
+}
+
+TEST(VuPipelineCacheTest, AcceptsMatchingHeader)
+{
+    const VkPhysicalDeviceProperties properties = fakeProperties();
+    EXPECT_TRUE(VuPipelineCache::isCompatible(makeBlob(properties, 64), properties));
+}
+
+TEST(VuPipelineCacheTest, RejectsForeignOrTruncatedData)
+{
+    const VkPhysicalDeviceProperties properties = fakeProperties();
+    std::vector<std::byte>           blob       = makeBlob(properties, 0);
+
+    EXPECT_FALSE(VuPipelineCache::isCompatible(std::span(blob).first(8), properties));
+
+    VkPhysicalDeviceProperties otherDevice = properties;
+    otherDevice.deviceID++;
+    EXPECT_FALSE(VuPipelineCache::isCompatible(blob, otherDevice));
+
+    VkPhysicalDeviceProperties otherUUID = properties;
+    otherUUID.pipelineCacheUUID[3] ^= 0xff;
+    EXPECT_FALSE(VuPipelineCache::isCompatible(blob, otherUUID));
+}
+
+TEST(VuPipelineCacheTest, FileNameChangesWithDriverVersion)
+{
+    VkPhysicalDeviceProperties properties = fakeProperties();
+    const auto                 before     = VuPipelineCache::makeFileName(properties);
+    properties.driverVersion++;
+    EXPECT_NE(before, VuPipelineCache::makeFileName(properties));
+    EXPECT_EQ(before.string(), "pipeline_10de_2684_8a4c4000_000102030405060708090a0b0c0d0e0f.bin");
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "02_OuterCore/VuShaderCache.h"
+
+using namespace Vu;
+
+static void
+writeText(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream file {path, std::ios::trunc};
+    file << text;
+}
+
+class VuShaderCacheTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir {};
+
+    void
+    SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "VuShaderCacheTest";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir / "common");
+        std::filesystem::create_directories(dir / "object");
+        writeText(dir / "common" / "Structs.h", "struct A {};\n");
+        writeText(dir / "common" / "Common.slang", "#include \"Structs.h\"\n#include \"Missing.slang\"\n");
+        writeText(dir / "object" / "frag.slang", "  #include \"../common/Common.slang\"\nvoid main() {}\n");
+    }
+
+    void
+    TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(VuShaderCacheTest, CollectsTransitiveIncludesOnce)
+{
+    writeText(dir / "object" / "frag.slang",
+              "#include \"../common/Common.slang\"\n#include \"../common/Structs.h\"\nvoid main() {}\n");
+
+    auto files = VuShaderCache::collectSourceFiles(dir / "object" / "frag.slang");
+    ASSERT_EQ(files.size(), 3u);
+    EXPECT_EQ(files[0].filename(), "frag.slang");
+    EXPECT_EQ(files[1].filename(), "Common.slang");
+    EXPECT_EQ(files[2].filename(), "Structs.h");
+}
+
+TEST_F(VuShaderCacheTest, KeyChangesWithIncludedFileFlagsAndCompiler)
+{
+    const auto shader = dir / "object" / "frag.slang";
+    const u64  base   = VuShaderCache::computeKey(shader, "-target spirv", "1");
+
+    EXPECT_EQ(base, VuShaderCache::computeKey(shader, "-target spirv", "1"));
+    EXPECT_NE(base, VuShaderCache::computeKey(shader, "-target spirv -O3", "1"));
+    EXPECT_NE(base, VuShaderCache::computeKey(shader, "-target spirv", "2"));
+
+    writeText(dir / "common" / "Structs.h", "struct A { int x; };\n");
+    EXPECT_NE(base, VuShaderCache::computeKey(shader, "-target spirv", "1"));
+}
+
+TEST_F(VuShaderCacheTest, SpirvPathContainsStemAndKey)
+{
+    auto path = VuShaderCache::spirvPath("cache", "shaders/frag.slang", 0xabcull);
+    EXPECT_EQ(path, std::filesystem::path("cache") / "shaders" / "frag_0000000000000abc.spv");
+}
+
+TEST_F(VuShaderCacheTest, ResolvesImportsThroughSearchPaths)
+{
+    writeText(dir / "common" / "Lighting.slang", "__exported import Structs_Module;\n");
+    writeText(dir / "common" / "Structs_Module.slang", "#include \"Structs.h\"\n");
+    writeText(dir / "object" / "lit.slang", "import Lighting;\nvoid main() {}\n");
+
+    EXPECT_EQ(VuShaderCache::collectSourceFiles(dir / "object" / "lit.slang").size(), 1u);
+
+    const std::filesystem::path searchPaths[] = {dir / "common"};
+    auto files = VuShaderCache::collectSourceFiles(dir / "object" / "lit.slang", searchPaths);
+    ASSERT_EQ(files.size(), 4u);
+    EXPECT_EQ(files[1].filename(), "Lighting.slang");
+    EXPECT_EQ(files[2].filename(), "Structs_Module.slang");
+    EXPECT_EQ(files[3].filename(), "Structs.h");
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "03_Mantle/VuSwapChain.h"
+
+using namespace Vu;
+
+TEST(VuSwapChainTest, KeepsSupportedPresentMode)
+{
+    const std::vector<VkPresentModeKHR> modes {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+    EXPECT_EQ(VuSwapChain::chooseSwapPresentMode(modes, VK_PRESENT_MODE_MAILBOX_KHR), VK_PRESENT_MODE_MAILBOX_KHR);
+    EXPECT_EQ(VuSwapChain::chooseSwapPresentMode(modes, VK_PRESENT_MODE_FIFO_KHR), VK_PRESENT_MODE_FIFO_KHR);
+}
+
+TEST(VuSwapChainTest, FallsBackToClosestPresentMode)
+{
+    const std::vector<VkPresentModeKHR> withMailbox {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+    EXPECT_EQ(VuSwapChain::chooseSwapPresentMode(withMailbox, VK_PRESENT_MODE_IMMEDIATE_KHR),
+              VK_PRESENT_MODE_MAILBOX_KHR);
+
+    // mailbox must not fall back to a tearing mode
+    const std::vector<VkPresentModeKHR> withImmediate {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+    EXPECT_EQ(VuSwapChain::chooseSwapPresentMode(withImmediate, VK_PRESENT_MODE_MAILBOX_KHR), VK_PRESENT_MODE_FIFO_KHR);
+
+    const std::vector<VkPresentModeKHR> fifoOnly {VK_PRESENT_MODE_FIFO_KHR};
+    EXPECT_EQ(VuSwapChain::chooseSwapPresentMode(fifoOnly, VK_PRESENT_MODE_IMMEDIATE_KHR), VK_PRESENT_MODE_FIFO_KHR);
+}
+
+TEST(VuSwapChainTest, ClampsImageCountToSurfaceLimits)
+{
+    VkSurfaceCapabilitiesKHR capabilities {};
+    capabilities.minImageCount = 2;
+    capabilities.maxImageCount = 4;
+    EXPECT_EQ(VuSwapChain::chooseImageCount(capabilities, 0), 3u);
+    EXPECT_EQ(VuSwapChain::chooseImageCount(capabilities, 1), 2u);
+    EXPECT_EQ(VuSwapChain::chooseImageCount(capabilities, 8), 4u);
+
+    // no upper limit
+    capabilities.maxImageCount = 0;
+    EXPECT_EQ(VuSwapChain::chooseImageCount(capabilities, 8), 8u);
+}